@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include "benchmark/benchmark.h"
+#include "b_plus_tree/b_plus_tree.h"
+#include "comparator.h"
+#include "system/user_system/user.h"
+#include "system/train_system/train.h"
+#include "system/ticket_system/ticket.h"
+#include "heap_file/heap_file.h"
+
+namespace sjtu {
+
+// Keys that compare equal under the rough comparator come in groups of this size
+constexpr int kGroupSize = 8;
+
+template <class T>
+auto MakeKey(int i) -> T;
+
+template <>
+auto MakeKey<Key>(int i) -> Key {
+  return Key("key" + std::to_string(i / kGroupSize), i);
+}
+
+template <>
+auto MakeKey<array<char, 20>>(int i) -> array<char, 20> {
+  array<char, 20> key{};
+  snprintf(&key[0], 20, "key_%010d", i);
+  return key;
+}
+
+template <>
+auto MakeKey<array<unsigned int, 10>>(int i) -> array<unsigned int, 10> {
+  array<unsigned int, 10> key{};
+  key[0] = 0xe7ab99u;
+  key[1] = i;
+  return key;
+}
+
+template <>
+auto MakeKey<StationTrain>(int i) -> StationTrain {
+  return {i / kGroupSize, i};
+}
+
+template <>
+auto MakeKey<BuyInfo>(int i) -> BuyInfo {
+  BuyInfo info{};
+  snprintf(&info.user_[0], 20, "user_%010d", i / kGroupSize);
+  info.buy_time_ = i;
+  return info;
+}
+
+template <>
+auto MakeKey<int>(int i) -> int {
+  return i;
+}
+
+template <class T>
+auto MakeValue(int i) -> T;
+
+template <>
+auto MakeValue<int>(int i) -> int {
+  return i;
+}
+
+template <>
+auto MakeValue<Rid>(int i) -> Rid {
+  return {i, 0};
+}
+
+template <>
+auto MakeValue<TrainStation>(int i) -> TrainStation {
+  return {i, 0};
+}
+
+// A fixed random permutation of [0, n), so that every run touches the same pages in the same order
+auto Permutation(int n) -> vector<int> {
+  vector<int> keys;
+  for (int i = 0; i < n; ++i) {
+    keys.push_back(i);
+  }
+  std::mt19937 engine(n);
+  for (int i = n - 1; i > 0; --i) {
+    std::swap(keys[i], keys[std::uniform_int_distribution<int>(0, i)(engine)]);
+  }
+  return keys;
+}
+
+// The key and value types of a tree
+template <class Tree>
+struct TreeTraits;
+
+INDEX_TEMPLATE_ARGUMENTS
+struct TreeTraits<BPLUSTREE_TYPE> {
+  using Key = KeyType;
+  using Value = ValueType;
+};
+
+template <class Tree>
+void Fill(Tree *tree, const vector<int> &keys) {
+  using KeyType = typename TreeTraits<Tree>::Key;
+  using ValueType = typename TreeTraits<Tree>::Value;
+  tree->Clean();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    tree->Insert(MakeKey<KeyType>(keys[i]), MakeValue<ValueType>(keys[i]));
+  }
+}
+
+// Insert range(0) keys in random order into an empty tree
+template <class Tree>
+void BM_Insert(benchmark::State &state) {
+  using KeyType = typename TreeTraits<Tree>::Key;
+  using ValueType = typename TreeTraits<Tree>::Value;
+  auto keys = Permutation(state.range(0));
+  Tree tree("bench_b_plus_tree");
+  for (auto _ : state) {
+    state.PauseTiming();
+    tree.Clean();
+    state.ResumeTiming();
+    for (size_t i = 0; i < keys.size(); ++i) {
+      tree.Insert(MakeKey<KeyType>(keys[i]), MakeValue<ValueType>(keys[i]));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Look up random keys in a tree of range(0) keys
+template <class Tree>
+void BM_GetValue(benchmark::State &state) {
+  using KeyType = typename TreeTraits<Tree>::Key;
+  using ValueType = typename TreeTraits<Tree>::Value;
+  auto keys = Permutation(state.range(0));
+  Tree tree("bench_b_plus_tree");
+  Fill(&tree, keys);
+  vector<ValueType> result;
+  size_t pos = 0;
+  for (auto _ : state) {
+    result.clear();
+    tree.GetValue(MakeKey<KeyType>(keys[pos]), &result);
+    benchmark::DoNotOptimize(result.size());
+    pos = pos + 1 == keys.size() ? 0 : pos + 1;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Remove every key in random order from a tree of range(0) keys
+template <class Tree>
+void BM_Remove(benchmark::State &state) {
+  using KeyType = typename TreeTraits<Tree>::Key;
+  auto keys = Permutation(state.range(0));
+  auto order = Permutation(state.range(0) + 1);
+  Tree tree("bench_b_plus_tree");
+  for (auto _ : state) {
+    state.PauseTiming();
+    Fill(&tree, keys);
+    state.ResumeTiming();
+    for (size_t i = 0; i < order.size(); ++i) {
+      if (order[i] < state.range(0)) {
+        tree.Remove(MakeKey<KeyType>(order[i]));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Scan the keys equal to a random key under the rough comparator in a tree of range(0) keys
+template <class Tree>
+void BM_GetAllValue(benchmark::State &state) {
+  using KeyType = typename TreeTraits<Tree>::Key;
+  using ValueType = typename TreeTraits<Tree>::Value;
+  auto keys = Permutation(state.range(0));
+  Tree tree("bench_b_plus_tree");
+  Fill(&tree, keys);
+  vector<ValueType> result;
+  size_t pos = 0;
+  size_t value_cnt = 0;
+  for (auto _ : state) {
+    result.clear();
+    tree.GetAllValue(MakeKey<KeyType>(keys[pos] / kGroupSize * kGroupSize), &result);
+    value_cnt += result.size();
+    pos = pos + 1 == keys.size() ? 0 : pos + 1;
+  }
+  state.SetItemsProcessed(value_cnt);
+}
+
+// Every instantiation in b_plus_tree.cpp, named after the index that uses it
+using KeyTree = BPlusTree<Key, int, Comparator, RoughComparator>;
+using UserTree = BPlusTree<array<char, 20>, Rid, UserComparator, UserComparator, POINT_INDEX_PAGE_SIZE>;
+using TrainIDTree = BPlusTree<array<char, 20>, int, TrainComparator, TrainComparator, POINT_INDEX_PAGE_SIZE>;
+using StationIDTree =
+    BPlusTree<array<unsigned int, 10>, int, StationComparator, StationComparator, POINT_INDEX_PAGE_SIZE>;
+using StationInfoTree = BPlusTree<StationTrain, TrainStation, StationTrainComparator, StationIDComparator>;
+using OrderTree = BPlusTree<BuyInfo, Rid, BuyInfoComparator, RoughBuyInfoComparator, SCAN_INDEX_PAGE_SIZE>;
+using QueueTree = BPlusTree<int, Rid, TimeComparator, TimeComparator, SCAN_INDEX_PAGE_SIZE>;
+
+#define BENCHMARK_TREE(Tree)                                                                          \
+  BENCHMARK_TEMPLATE(BM_Insert, Tree)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond); \
+  BENCHMARK_TEMPLATE(BM_GetValue, Tree)->RangeMultiplier(10)->Range(1000, 100000);                      \
+  BENCHMARK_TEMPLATE(BM_Remove, Tree)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond); \
+  BENCHMARK_TEMPLATE(BM_GetAllValue, Tree)->RangeMultiplier(10)->Range(1000, 100000)
+
+BENCHMARK_TREE(KeyTree);
+BENCHMARK_TREE(UserTree);
+BENCHMARK_TREE(TrainIDTree);
+BENCHMARK_TREE(StationIDTree);
+BENCHMARK_TREE(StationInfoTree);
+BENCHMARK_TREE(OrderTree);
+BENCHMARK_TREE(QueueTree);
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,59 @@
+#include <memory>
+#include <random>
+#include "benchmark/benchmark.h"
+#include "buffer/buffer_pool_manager.h"
+#include "config.h"
+
+namespace sjtu {
+
+// Create page_cnt pages in a fresh file. They are written, since a page that was never written is not read from disk
+void CreatePages(BufferPoolManager *bpm, int page_cnt) {
+  for (int i = 0; i < page_cnt; ++i) {
+    bpm->WritePage(bpm->NewPage()).GetDataMut()[0] = 1;
+  }
+  bpm->FlushAllPages();
+}
+
+// Read random pages that all fit in a pool of range(0) frames, so that every fetch after the first round is a hit
+void BM_FetchPageHit(benchmark::State &state) {
+  int frame_cnt = state.range(0);
+  int page_cnt = frame_cnt / 2;
+  auto disk_manager = std::make_shared<DiskManager>("bench_bpm_hit", DIRECT_IO);
+  disk_manager->Clean();
+  BufferPoolManager bpm(frame_cnt, disk_manager, LRUK_REPLACER_K);
+  CreatePages(&bpm, page_cnt);
+  std::mt19937 engine(frame_cnt);
+  for (auto _ : state) {
+    auto guard = bpm.ReadPage(std::uniform_int_distribution<int>(1, page_cnt)(engine));
+    benchmark::DoNotOptimize(guard.GetData());
+  }
+  auto stats = bpm.GetStats();
+  state.counters["hit_rate"] = 1.0 * stats.hit_cnt_ / (stats.hit_cnt_ + stats.miss_cnt_);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Read pages round-robin from a file 8 times larger than a pool of range(0) frames, so that every fetch is a miss
+void BM_FetchPageMiss(benchmark::State &state) {
+  int frame_cnt = state.range(0);
+  int page_cnt = frame_cnt * 8;
+  auto disk_manager = std::make_shared<DiskManager>("bench_bpm_miss", DIRECT_IO);
+  disk_manager->Clean();
+  BufferPoolManager bpm(frame_cnt, disk_manager, LRUK_REPLACER_K);
+  CreatePages(&bpm, page_cnt);
+  int page_id = 0;
+  for (auto _ : state) {
+    page_id = page_id == page_cnt ? 1 : page_id + 1;
+    auto guard = bpm.ReadPage(page_id);
+    benchmark::DoNotOptimize(guard.GetData());
+  }
+  auto stats = bpm.GetStats();
+  state.counters["hit_rate"] = 1.0 * stats.hit_cnt_ / (stats.hit_cnt_ + stats.miss_cnt_);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_FetchPageHit)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_FetchPageMiss)->RangeMultiplier(4)->Range(16, 1024);
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,32 @@
+#include "benchmark/benchmark.h"
+#include "buffer/lru_k_replacer.h"
+#include "config.h"
+
+namespace sjtu {
+
+// Evict from a full replacer of range(0) evictable frames. The victim is accessed and made evictable again, as a
+// buffer pool does when it reuses the frame, so that every iteration sees the same number of frames.
+void BM_Evict(benchmark::State &state) {
+  int frame_cnt = state.range(0);
+  LRUKReplacer replacer(frame_cnt, LRUK_REPLACER_K);
+  for (int round = 0; round < LRUK_REPLACER_K; ++round) {
+    for (int frame_id = 0; frame_id < frame_cnt; ++frame_id) {
+      replacer.RecordAccess(frame_id, frame_id);
+    }
+  }
+  for (int frame_id = 0; frame_id < frame_cnt; ++frame_id) {
+    replacer.SetEvictable(frame_id, true);
+  }
+  for (auto _ : state) {
+    auto frame_id = replacer.Evict();
+    replacer.RecordAccess(*frame_id, *frame_id);
+    replacer.SetEvictable(*frame_id, true);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Evict)->RangeMultiplier(4)->Range(16, 4096);
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+#include <random>
+#include <string>
+#include "benchmark/benchmark.h"
+#include "buffer/replacer.h"
+#include "config.h"
+
+namespace sjtu {
+
+static constexpr int kFrameCnt = 100;
+static constexpr int kPageCnt = 4096;
+static constexpr int kAccessCnt = 200000;
+
+enum TraceType { POINT_LOOKUPS, LOOKUPS_AND_SCANS, LOOPING_SCANS };
+
+// Draw a page with a skew towards the low page ids: a tenth of the pages receive about half of the lookups
+auto SkewedPage(std::mt19937 *engine) -> int {
+  double x = std::uniform_real_distribution<double>(0, 1)(*engine);
+  return static_cast<int>(kPageCnt * x * x * x);
+}
+
+/**
+ * Generate the page ids read by an index:
+ *  - POINT_LOOKUPS: skewed lookups, as on the hash indexes,
+ *  - LOOKUPS_AND_SCANS: the same lookups, interrupted by scans of 4 pools of consecutive leaves, as GetAll does,
+ *  - LOOPING_SCANS: scans over a pool and a quarter, again and again.
+ */
+auto MakeTrace(TraceType type) -> vector<int> {
+  std::mt19937 engine(type);
+  vector<int> trace;
+  while (trace.size() < kAccessCnt) {
+    if (type == LOOPING_SCANS) {
+      for (int page_id = 0; page_id < 5 * kFrameCnt / 4; ++page_id) {
+        trace.push_back(page_id);
+      }
+    } else if (type == LOOKUPS_AND_SCANS && std::uniform_int_distribution<int>(0, 999)(engine) < 2) {
+      int begin = std::uniform_int_distribution<int>(0, kPageCnt - 4 * kFrameCnt)(engine);
+      for (int page_id = begin; page_id < begin + 4 * kFrameCnt; ++page_id) {
+        trace.push_back(page_id);
+      }
+    } else {
+      trace.push_back(SkewedPage(&engine));
+    }
+  }
+  return trace;
+}
+
+// Replay a trace through a pool of kFrameCnt frames that uses the replacer, pinning each page while it is read like a
+// page guard does, and return the number of hits
+auto Replay(const vector<int> &trace, Replacer *replacer) -> size_t {
+  vector<int> frame_ids(kPageCnt, -1);
+  vector<int> page_ids(kFrameCnt, -1);
+  int free_frame_cnt = kFrameCnt;
+  size_t hit_cnt = 0;
+  for (size_t i = 0; i < trace.size(); ++i) {
+    int page_id = trace[i];
+    int frame_id = frame_ids[page_id];
+    if (frame_id != -1) {
+      ++hit_cnt;
+    } else {
+      frame_id = free_frame_cnt > 0 ? --free_frame_cnt : *replacer->Evict();
+      if (page_ids[frame_id] != -1) {
+        frame_ids[page_ids[frame_id]] = -1;
+      }
+      page_ids[frame_id] = page_id;
+      frame_ids[page_id] = frame_id;
+    }
+    replacer->RecordAccess(frame_id, page_id);
+    replacer->SetEvictable(frame_id, false);
+    replacer->SetEvictable(frame_id, true);
+  }
+  return hit_cnt;
+}
+
+// Replay the trace range(0) through the policy range(1), and report its hit rate
+void BM_HitRate(benchmark::State &state) {
+  static const char *trace_names[] = {"point_lookups", "lookups_and_scans", "looping_scans"};
+  static const char *policy_names[] = {"lru_k", "clock", "2q", "arc"};
+  auto trace = MakeTrace(static_cast<TraceType>(state.range(0)));
+  auto type = static_cast<ReplacerType>(state.range(1));
+  size_t hit_cnt = 0;
+  for (auto _ : state) {
+    auto replacer = MakeReplacer(type, kFrameCnt, LRUK_REPLACER_K);
+    hit_cnt = Replay(trace, replacer.get());
+  }
+  state.SetLabel(std::string(trace_names[state.range(0)]) + "/" + policy_names[state.range(1)]);
+  state.counters["hit_rate"] = 1.0 * hit_cnt / trace.size();
+  state.SetItemsProcessed(state.iterations() * trace.size());
+}
+
+BENCHMARK(BM_HitRate)->ArgsProduct({{POINT_LOOKUPS, LOOKUPS_AND_SCANS, LOOPING_SCANS}, {0, 1, 2, 3}})
+    ->Unit(benchmark::kMillisecond);
+
+}
+
+BENCHMARK_MAIN();
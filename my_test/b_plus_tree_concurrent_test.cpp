@@ -0,0 +1,195 @@
+#include <atomic>
+#include <thread>
+#include "b_plus_tree/b_plus_tree.h"
+#include "comparator.h"
+#include "gtest/gtest.h"
+
+namespace sjtu {
+
+using IntTree = BPlusTree<Key, int, Comparator, RoughComparator>;
+
+constexpr int kThreadCnt = 4;
+constexpr int kKeyCnt = 20000;
+
+template <class F>
+void RunThreads(F &&f) {
+  std::vector<std::thread> threads;
+  for (int id = 0; id < kThreadCnt; ++id) {
+    threads.emplace_back(f, id);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(BPlusTreeConcurrentTests, InsertTest) {
+  IntTree tree("concurrent_insert", ReplacerType::LRU_K, 4, 5);
+  tree.Clean();
+  RunThreads([&tree](int id) {
+    for (int i = id; i < kKeyCnt; i += kThreadCnt) {
+      EXPECT_TRUE(tree.Insert(Key("key", i), i));
+    }
+  });
+  EXPECT_TRUE(tree.CheckIntegrity());
+  EXPECT_EQ(tree.GetSize(), kKeyCnt);
+  // 20000 keys in leaves of at most 4 need at least 7 levels of fan-out 5
+  EXPECT_GE(tree.GetHeight(), 7);
+  vector<int> result;
+  tree.GetAll(&result);
+  ASSERT_EQ(result.size(), kKeyCnt);
+  for (int i = 0; i < kKeyCnt; ++i) {
+    EXPECT_EQ(result[i], i);
+  }
+}
+
+TEST(BPlusTreeConcurrentTests, ResidentTest) {
+  constexpr int kLookupCnt = 2000;
+  IntTree tree("concurrent_resident", ReplacerType::LRU_K, 4, 5);
+  tree.Clean();
+  for (int i = 0; i < kKeyCnt; ++i) {
+    tree.Insert(Key("key", (i * 7919) % kKeyCnt), i);
+  }
+  // the header, the root and its children stay in the pool, so a lookup only misses below them
+  vector<FileStats> stats;
+  tree.CollectStats(&stats);
+  int height = tree.GetHeight();
+  ASSERT_GE(height, 3);
+  EXPECT_GE(stats[0].resident_page_cnt_, 4);
+  for (int i = 0; i < kLookupCnt; ++i) {
+    stats.clear();
+    tree.CollectStats(&stats);
+    auto miss_cnt = stats[0].miss_cnt_;
+    vector<int> result;
+    EXPECT_TRUE(tree.GetValue(Key("key", (i * 104729) % kKeyCnt), &result));
+    stats.clear();
+    tree.CollectStats(&stats);
+    EXPECT_LE(stats[0].miss_cnt_ - miss_cnt, height - 2);
+  }
+  // the lookups pin the resident pages through their swips
+  EXPECT_EQ(stats[0].swizzled_hit_cnt_ > 0, POINTER_SWIZZLING);
+  for (int i = 0; i < kKeyCnt; ++i) {
+    tree.Remove(Key("key", i));
+  }
+  stats.clear();
+  tree.CollectStats(&stats);
+  EXPECT_EQ(tree.GetHeight(), 0);
+  EXPECT_EQ(stats[0].resident_page_cnt_, 1);
+}
+
+TEST(BPlusTreeConcurrentTests, MixedTest) {
+  IntTree tree("concurrent_mixed", ReplacerType::LRU_K, 4, 5);
+  tree.Clean();
+  for (int i = 0; i < kKeyCnt; i += 2) {
+    tree.Insert(Key("key", i), i);
+  }
+  RunThreads([&tree](int id) {
+    for (int i = id; i < kKeyCnt; i += kThreadCnt) {
+      if (id % 2 == 0) {  // even keys: remove the ones that were inserted before
+        tree.Remove(Key("key", i));
+      } else {  // odd keys: insert them, and read the even keys concurrently
+        EXPECT_TRUE(tree.Insert(Key("key", i), i));
+        vector<int> result;
+        tree.GetValue(Key("key", i), &result);
+        ASSERT_EQ(result.size(), 1);
+        EXPECT_EQ(result[0], i);
+      }
+    }
+    if (id == 1) {
+      vector<int> result;
+      tree.GetAllValue(Key("key"), &result);
+      for (size_t i = 1; i < result.size(); ++i) {
+        EXPECT_LT(result[i - 1], result[i]);
+      }
+    }
+  });
+  EXPECT_TRUE(tree.CheckIntegrity());
+  vector<int> result;
+  tree.GetAll(&result);
+  ASSERT_EQ(result.size(), kKeyCnt / 2);
+  for (int i = 0; i < kKeyCnt / 2; ++i) {
+    EXPECT_EQ(result[i], 2 * i + 1);
+  }
+  for (int i = 0; i < kKeyCnt; i += 2) {
+    vector<int> value;
+    EXPECT_FALSE(tree.GetValue(Key("key", i), &value));
+  }
+}
+
+TEST(BPlusTreeConcurrentTests, AppendTest) {
+  IntTree tree("concurrent_append", ReplacerType::LRU_K, 4, 5);
+  tree.Clean();
+  for (int i = 0; i < kKeyCnt; ++i) {
+    EXPECT_TRUE(tree.Insert(Key("key", i), i));
+  }
+  EXPECT_FALSE(tree.Insert(Key("key", kKeyCnt - 1), 0));
+  EXPECT_TRUE(tree.CheckIntegrity());
+  vector<int> result;
+  tree.GetAll(&result);
+  ASSERT_EQ(result.size(), kKeyCnt);
+  for (int i = 0; i < kKeyCnt; ++i) {
+    EXPECT_EQ(result[i], i);
+  }
+  // appends fill the leaves: 5000 full leaves and their parents, where even splits leave 6667 leaves of 3 keys
+  vector<FileStats> stats;
+  tree.CollectStats(&stats);
+  EXPECT_LT(stats[0].page_cnt_, 7000);
+}
+
+TEST(BPlusTreeConcurrentTests, AppendRemoveTest) {
+  IntTree tree("concurrent_append_remove", ReplacerType::LRU_K, 4, 5);
+  tree.Clean();
+  std::atomic<int> appended_cnt = 0;
+  std::atomic<int> removed_cnt = 0;
+  // every odd key is removed while the next key is appended, so the leaf the hint points at underflows under appends
+  std::thread remover([&tree, &appended_cnt, &removed_cnt] {
+    for (int i = 1; i < kKeyCnt; i += 2) {
+      while (appended_cnt.load(std::memory_order_acquire) <= i) {
+        std::this_thread::yield();
+      }
+      tree.Remove(Key("key", i));
+      removed_cnt.store(i / 2 + 1, std::memory_order_release);
+    }
+  });
+  for (int i = 0; i < kKeyCnt; ++i) {
+    EXPECT_TRUE(tree.Insert(Key("key", i), i));
+    appended_cnt.store(i + 1, std::memory_order_release);
+    while (i % 2 == 0 && removed_cnt.load(std::memory_order_acquire) < i / 2) {
+      std::this_thread::yield();
+    }
+  }
+  remover.join();
+  EXPECT_TRUE(tree.CheckIntegrity());
+  vector<int> result;
+  tree.GetAll(&result);
+  ASSERT_EQ(result.size(), kKeyCnt / 2);
+  for (int i = 0; i < kKeyCnt / 2; ++i) {
+    EXPECT_EQ(result[i], 2 * i);
+  }
+}
+
+TEST(BPlusTreeConcurrentTests, PrefixAppendTest) {
+  IntTree tree("concurrent_prefix_append", ReplacerType::LRU_K, 4, 5);
+  tree.Clean();
+  constexpr int kWindow = 100;
+  RunThreads([&tree](int id) {
+    // every thread appends to its own prefix and removes its oldest keys, so leaves behind the hints are deleted
+    std::string name(1, static_cast<char>('a' + id));
+    for (int i = 0; i < kKeyCnt; ++i) {
+      EXPECT_TRUE(tree.Insert(Key(name, i), i));
+      if (i >= kWindow) {
+        tree.Remove(Key(name, i - kWindow));
+      }
+    }
+  });
+  EXPECT_TRUE(tree.CheckIntegrity());
+  for (int id = 0; id < kThreadCnt; ++id) {
+    vector<int> result;
+    tree.GetAllValue(Key(std::string(1, static_cast<char>('a' + id))), &result);
+    ASSERT_EQ(result.size(), kWindow);
+    for (int i = 0; i < kWindow; ++i) {
+      EXPECT_EQ(result[i], kKeyCnt - kWindow + i);
+    }
+  }
+}
+
+}
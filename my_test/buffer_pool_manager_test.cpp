@@ -0,0 +1,207 @@
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "buffer/buffer_pool_manager.h"
+#include "config.h"
+#include "gtest/gtest.h"
+
+namespace sjtu {
+
+TEST(BufferPoolManagerTests, FlusherTest) {
+  constexpr int kFrameCnt = 10;
+  constexpr int kHighWater = 4;
+  auto disk_manager = std::make_shared<DiskManager>("flusher_test");
+  disk_manager->Clean();
+  BufferPoolManager bpm(kFrameCnt, disk_manager, LRUK_REPLACER_K, kHighWater);
+  for (int i = 0; i < kFrameCnt; ++i) {
+    int page_id = bpm.NewPage();
+    auto guard = bpm.WritePage(page_id);
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+  }
+  // the dirty frames are written back down to half of the high-water mark without any eviction
+  std::this_thread::sleep_for(std::chrono::milliseconds(FLUSHER_INTERVAL_MS * 20));
+  EXPECT_GE(disk_manager->GetNumWrites(), kFrameCnt - kHighWater / 2);
+  // new pages now evict clean frames, and the written pages read back intact
+  for (int i = 0; i < kFrameCnt; ++i) {
+    bpm.WritePage(bpm.NewPage());
+  }
+  for (int page_id = 1; page_id <= kFrameCnt; ++page_id) {
+    auto guard = bpm.ReadPage(page_id);
+    EXPECT_EQ(std::string(guard.GetData()), "page " + std::to_string(page_id));
+  }
+}
+
+TEST(BufferPoolManagerTests, ReadAheadTest) {
+  constexpr int kFrameCnt = 10;
+  constexpr int kPageCnt = 30;
+  auto disk_manager = std::make_shared<DiskManager>("read_ahead_test");
+  disk_manager->Clean();
+  BufferPoolManager bpm(kFrameCnt, disk_manager, LRUK_REPLACER_K);
+  for (int i = 0; i < kPageCnt; ++i) {
+    int page_id = bpm.NewPage();
+    auto guard = bpm.WritePage(page_id);
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+  }
+  // the first pages were evicted long ago. read them ahead, some twice, while others are being fetched
+  for (int page_id = 1; page_id <= kPageCnt; page_id += 4) {
+    vector<int> page_ids;
+    for (int i = page_id; i < page_id + 8 && i <= kPageCnt; ++i) {
+      page_ids.push_back(i);
+    }
+    bpm.ReadAhead(page_ids);
+    for (int i = page_id; i < page_id + 4 && i <= kPageCnt; ++i) {
+      auto guard = bpm.ReadPage(i);
+      EXPECT_EQ(std::string(guard.GetData()), "page " + std::to_string(i));
+    }
+  }
+  // a page that is read ahead but never fetched does not keep its frame pinned
+  bpm.FlushAllPages();
+  for (int page_id = 1; page_id <= kPageCnt; ++page_id) {
+    auto pin_count = bpm.GetPinCount(page_id);
+    EXPECT_TRUE(!pin_count.has_value() || pin_count.value() == 0);
+  }
+}
+
+TEST(BufferPoolManagerTests, ScanRingTest) {
+  constexpr int kFrameCnt = 32;
+  constexpr int kHotPageCnt = 8;
+  constexpr int kPageCnt = 200;
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::CLOCK, ReplacerType::TWO_Q, ReplacerType::ARC}) {
+    SCOPED_TRACE(static_cast<int>(type));
+    auto disk_manager = std::make_shared<DiskManager>("scan_ring_test");
+    disk_manager->Clean();
+    // the dirty frames never pass the high-water mark, so the flusher stays idle
+    BufferPoolManager bpm(kFrameCnt, disk_manager, LRUK_REPLACER_K, kFrameCnt, type);
+    for (int i = 0; i < kPageCnt; ++i) {
+      int page_id = bpm.NewPage();
+      auto guard = bpm.WritePage(page_id);
+      snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    }
+    for (int round = 0; round < 2; ++round) {
+      for (int page_id = 1; page_id <= kHotPageCnt; ++page_id) {
+        bpm.ReadPage(page_id);
+      }
+    }
+    // two scans of all the other pages only recycle the frames of their rings, and leave the hot pages alone
+    for (int round = 0; round < 2; ++round) {
+      ScanRing ring;
+      for (int page_id = kHotPageCnt + 1; page_id <= kPageCnt; ++page_id) {
+        auto guard = bpm.ReadPage(page_id, &ring);
+        EXPECT_EQ(std::string(guard.GetData()), "page " + std::to_string(page_id));
+      }
+    }
+    auto miss_cnt = bpm.GetStats().miss_cnt_;
+    for (int page_id = 1; page_id <= kHotPageCnt; ++page_id) {
+      bpm.ReadPage(page_id);
+    }
+    EXPECT_EQ(bpm.GetStats().miss_cnt_, miss_cnt);
+  }
+}
+
+TEST(BufferPoolManagerTests, ResidentTest) {
+  constexpr int kFrameCnt = 20;
+  constexpr int kPageCnt = 60;
+  constexpr int kResidentCnt = kFrameCnt * RESIDENT_FRAME_PERCENT / 100;
+  auto disk_manager = std::make_shared<DiskManager>("resident_test");
+  disk_manager->Clean();
+  // the dirty frames never pass the high-water mark, so the flusher stays idle
+  BufferPoolManager bpm(kFrameCnt, disk_manager, LRUK_REPLACER_K, kFrameCnt);
+  for (int i = 0; i < kPageCnt; ++i) {
+    int page_id = bpm.NewPage();
+    auto guard = bpm.WritePage(page_id);
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+  }
+  ASSERT_EQ(bpm.ResidentCapacity(), kResidentCnt);
+  for (int page_id = 1; page_id <= kResidentCnt; ++page_id) {
+    EXPECT_TRUE(bpm.SetResident(page_id, true));
+  }
+  EXPECT_FALSE(bpm.SetResident(kResidentCnt + 1, true));
+  // the resident pages survive reads of every other page, which all miss
+  for (int round = 0; round < 2; ++round) {
+    for (int page_id = kResidentCnt + 1; page_id <= kPageCnt; ++page_id) {
+      auto guard = bpm.ReadPage(page_id);
+      EXPECT_EQ(std::string(guard.GetData()), "page " + std::to_string(page_id));
+    }
+  }
+  auto miss_cnt = bpm.GetStats().miss_cnt_;
+  for (int page_id = 1; page_id <= kResidentCnt; ++page_id) {
+    auto guard = bpm.ReadPage(page_id);
+    EXPECT_EQ(std::string(guard.GetData()), "page " + std::to_string(page_id));
+  }
+  EXPECT_EQ(bpm.GetStats().miss_cnt_, miss_cnt);
+  // a released or deleted page frees its place in the region
+  bpm.SetResident(1, false);
+  EXPECT_TRUE(bpm.SetResident(kResidentCnt + 1, true));
+  EXPECT_TRUE(bpm.DeletePage(2));
+  EXPECT_EQ(bpm.GetStats().resident_page_cnt_, kResidentCnt - 1);
+  for (int page_id = 1; page_id <= kPageCnt; ++page_id) {
+    bpm.ReadPage(page_id);
+  }
+  EXPECT_TRUE(bpm.SetResident(kResidentCnt + 2, true));
+}
+
+TEST(BufferPoolManagerTests, SwipTest) {
+  if (!POINTER_SWIZZLING) {
+    GTEST_SKIP();
+  }
+  constexpr int kFrameCnt = 20;
+  auto disk_manager = std::make_shared<DiskManager>("swip_test");
+  disk_manager->Clean();
+  BufferPoolManager bpm(kFrameCnt, disk_manager, LRUK_REPLACER_K);
+  for (int i = 0; i < 2; ++i) {
+    int page_id = bpm.NewPage();
+    auto guard = bpm.WritePage(page_id);
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+  }
+  Swip swip;
+  bpm.Swizzle(1, &swip);
+  EXPECT_EQ(swip.FrameOf(1), -1);
+  ASSERT_TRUE(bpm.SetResident(1, true));
+  bpm.Swizzle(1, &swip);
+  ASSERT_NE(swip.FrameOf(1), -1);
+  EXPECT_EQ(swip.FrameOf(2), -1);
+  {
+    auto guard = bpm.ReadPage(1, swip);
+    EXPECT_EQ(std::string(guard.GetData()), "page 1");
+    EXPECT_EQ(bpm.GetPinCount(1), 1);
+  }
+  EXPECT_EQ(bpm.GetPinCount(1), 0);
+  EXPECT_EQ(bpm.GetStats().swizzled_hit_cnt_, 1);
+  // a swip to a released page, or to another page, is stale and the read goes through the page table
+  bpm.SetResident(1, false);
+  EXPECT_EQ(std::string(bpm.ReadPage(1, swip).GetData()), "page 1");
+  EXPECT_EQ(std::string(bpm.ReadPage(2, swip).GetData()), "page 2");
+  EXPECT_EQ(bpm.GetStats().swizzled_hit_cnt_, 1);
+  EXPECT_TRUE(bpm.DeletePage(1));
+}
+
+TEST(BufferPoolManagerTests, DirectIOTest) {
+  constexpr int kFrameCnt = 10;
+  constexpr int kPageCnt = 30;
+  auto disk_manager = std::make_shared<DiskManager>("direct_io_test", true);
+  disk_manager->Clean();
+  {
+    BufferPoolManager bpm(kFrameCnt, disk_manager, LRUK_REPLACER_K);
+    for (int i = 0; i < kPageCnt; ++i) {
+      int page_id = bpm.NewPage();
+      auto guard = bpm.WritePage(page_id);
+      snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    }
+    for (int page_id = 1; page_id <= kPageCnt; ++page_id) {
+      auto guard = bpm.ReadPage(page_id);
+      EXPECT_EQ(std::string(guard.GetData()), "page " + std::to_string(page_id));
+    }
+    bpm.FlushAllPages();
+  }
+  // buffers that are not aligned go through the bounce buffer, before and after a checkpoint
+  auto buffer = std::make_unique<char[]>(BUSTUB_PAGE_SIZE + 1);
+  disk_manager->ReadPage(1, buffer.get() + 1);
+  EXPECT_EQ(std::string(buffer.get() + 1), "page 1");
+  disk_manager->Prepare(1);
+  disk_manager->Apply();
+  disk_manager->ReadPage(kPageCnt, buffer.get() + 1);
+  EXPECT_EQ(std::string(buffer.get() + 1), "page " + std::to_string(kPageCnt));
+}
+
+}
@@ -0,0 +1,133 @@
+#include <thread>
+#include "hash/extendible_hash_table.h"
+#include "comparator.h"
+#include "gtest/gtest.h"
+
+namespace sjtu {
+
+using IntTable = ExtendibleHashTable<Key, int, Comparator>;
+
+constexpr int kThreadCnt = 4;
+constexpr int kKeyCnt = 20000;
+
+template <class F>
+void RunThreads(F &&f) {
+  std::vector<std::thread> threads;
+  for (int id = 0; id < kThreadCnt; ++id) {
+    threads.emplace_back(f, id);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(ExtendibleHashTableTests, SplitMergeTest) {
+  // small buckets and directories, so that the keys split buckets, directories and the header many times
+  IntTable table("hash_split_merge", ReplacerType::LRU_K, 16, 4);
+  table.Clean();
+  EXPECT_TRUE(table.IsEmpty());
+  for (int i = 0; i < kKeyCnt; ++i) {
+    EXPECT_TRUE(table.Insert(Key("key", i), i));
+  }
+  EXPECT_FALSE(table.Insert(Key("key", 0), 1));
+  EXPECT_TRUE(table.CheckIntegrity());
+  EXPECT_EQ(table.GetSize(), kKeyCnt);
+  for (int i = 0; i < kKeyCnt; ++i) {
+    vector<int> result;
+    ASSERT_TRUE(table.GetValue(Key("key", i), &result));
+    EXPECT_EQ(result[0], i);
+  }
+  for (int i = 0; i < kKeyCnt; i += 2) {
+    table.Remove(Key("key", i));
+  }
+  table.Remove(Key("key", 0));
+  EXPECT_TRUE(table.CheckIntegrity());
+  for (int i = 0; i < kKeyCnt; ++i) {
+    vector<int> result;
+    EXPECT_EQ(table.GetValue(Key("key", i), &result), i % 2 == 1);
+  }
+  for (int i = 1; i < kKeyCnt; i += 2) {
+    table.Remove(Key("key", i));
+  }
+  EXPECT_TRUE(table.CheckIntegrity());
+  EXPECT_TRUE(table.IsEmpty());
+  // removes do not give back the ids handed out by the size
+  EXPECT_EQ(table.GetSize(), kKeyCnt);
+}
+
+TEST(ExtendibleHashTableTests, ConcurrentTest) {
+  IntTable table("hash_concurrent", ReplacerType::LRU_K, 16, 4);
+  table.Clean();
+  for (int i = 0; i < kKeyCnt; i += 2) {
+    table.Insert(Key("key", i), i);
+  }
+  RunThreads([&table](int id) {
+    for (int i = id; i < kKeyCnt; i += kThreadCnt) {
+      if (id % 2 == 0) {  // even keys: remove the ones that were inserted before
+        table.Remove(Key("key", i));
+      } else {  // odd keys: insert them, and read them back while the others split and merge buckets
+        EXPECT_TRUE(table.Insert(Key("key", i), i));
+        vector<int> result;
+        table.GetValue(Key("key", i), &result);
+        ASSERT_EQ(result.size(), 1);
+        EXPECT_EQ(result[0], i);
+      }
+    }
+  });
+  EXPECT_TRUE(table.CheckIntegrity());
+  for (int i = 0; i < kKeyCnt; ++i) {
+    vector<int> result;
+    EXPECT_EQ(table.GetValue(Key("key", i), &result), i % 2 == 1);
+  }
+}
+
+TEST(ExtendibleHashTableTests, ReopenTest) {
+  {
+    IntTable table("hash_reopen");
+    table.Clean();
+    for (int i = 0; i < kKeyCnt; ++i) {
+      table.Insert(Key("key", i), i);
+    }
+    table.Remove(Key("key", 0));
+  }
+  IntTable table("hash_reopen");
+  EXPECT_TRUE(table.CheckIntegrity());
+  EXPECT_EQ(table.GetSize(), kKeyCnt);
+  vector<int> result;
+  EXPECT_FALSE(table.GetValue(Key("key", 0), &result));
+  EXPECT_TRUE(table.GetValue(Key("key", kKeyCnt - 1), &result));
+  EXPECT_EQ(result[0], kKeyCnt - 1);
+  // new pages are allocated after the ones of the reopened table
+  EXPECT_TRUE(table.Insert(Key("key", kKeyCnt), kKeyCnt));
+  EXPECT_TRUE(table.CheckIntegrity());
+}
+
+TEST(ExtendibleHashTableTests, FilterTest) {
+  {
+    IntTable table("hash_filter");
+    table.Clean();
+    // more keys than the smallest filter holds, so that the first checkpoint rebuilds it
+    for (int i = 0; i < kKeyCnt; ++i) {
+      table.Insert(Key("key", i), i);
+    }
+    vector<std::string> files;
+    table.PrepareCheckpoint(1, &files);
+    table.ApplyCheckpoint();
+    EXPECT_TRUE(table.CheckIntegrity());
+  }
+  IntTable table("hash_filter");
+  EXPECT_TRUE(table.CheckIntegrity());
+  for (int i = kKeyCnt; i < 2 * kKeyCnt; ++i) {
+    vector<int> result;
+    EXPECT_FALSE(table.GetValue(Key("key", i), &result));
+  }
+  vector<FileStats> stats;
+  table.CollectStats(&stats);
+  ASSERT_EQ(stats.size(), 1);
+  EXPECT_GT(stats[0].filter_byte_cnt_, 0);
+  EXPECT_EQ(stats[0].filter_negative_cnt_ + stats[0].filter_false_positive_cnt_, kKeyCnt);
+  // 16 bits per key give a false positive rate well below 1%
+  EXPECT_LT(stats[0].filter_false_positive_cnt_, kKeyCnt / 100);
+}
+
+}
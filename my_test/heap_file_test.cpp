@@ -0,0 +1,47 @@
+#include <cstddef>
+#include <string>
+#include "heap_file/heap_file.h"
+#include "my_stl/vector.hpp"
+#include "gtest/gtest.h"
+
+namespace sjtu {
+
+struct TestRecord {
+  int key_;
+  int state_;
+  char payload_[100];
+};
+
+TEST(HeapFileTests, InsertUpdateReopenTest) {
+  constexpr int kRecordCnt = 1000;
+  vector<Rid> rids;
+  {
+    HeapFile heap_file("heap_file_test_db");
+    heap_file.Clean();
+    for (int i = 0; i < kRecordCnt; ++i) {
+      TestRecord record{i, 0, {}};
+      snprintf(record.payload_, sizeof(record.payload_), "record %d", i);
+      rids.push_back(heap_file.Insert(record));
+    }
+    // records span several pages, and a record keeps its rid
+    EXPECT_NE(rids[0].page_id_, rids[kRecordCnt - 1].page_id_);
+    for (int i = 0; i < kRecordCnt; i += 3) {
+      int state = 1;
+      heap_file.Update(rids[i], reinterpret_cast<const char *>(&state), offsetof(TestRecord, state_), sizeof(state));
+    }
+  }
+  HeapFile heap_file("heap_file_test_db");
+  for (int i = 0; i < kRecordCnt; ++i) {
+    auto record = heap_file.Get<TestRecord>(rids[i]);
+    EXPECT_EQ(record.key_, i);
+    EXPECT_EQ(record.state_, i % 3 == 0 ? 1 : 0);
+    EXPECT_EQ(std::string(record.payload_), "record " + std::to_string(i));
+  }
+  // new records are appended after the reopened ones
+  TestRecord record{kRecordCnt, 0, {}};
+  Rid rid = heap_file.Insert(record);
+  EXPECT_EQ(heap_file.Get<TestRecord>(rid).key_, kRecordCnt);
+  EXPECT_EQ(heap_file.Get<TestRecord>(rids[kRecordCnt - 1]).key_, kRecordCnt - 1);
+}
+
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "comparator.h"
+#include "system/ticket_system/ticket.h"
+#include "system/train_system/train.h"
+#include "system/user_system/user.h"
+#include "gtest/gtest.h"
+
+namespace sjtu {
+
+constexpr int kKeyCnt = 2000;
+
+auto Sign(int x) -> int { return (x > 0) - (x < 0); }
+
+// Normalized keys must sort like the comparator and decode back to the same key
+template <typename KeyType, typename KeyComparator, typename F>
+void CheckOrder(F &&random_key) {
+  using Normalizer = KeyNormalizer<KeyType, KeyComparator>;
+  static_assert(Normalizer::kIsNormalized);
+  std::vector<KeyType> keys;
+  for (int i = 0; i < kKeyCnt; ++i) {
+    keys.push_back(random_key());
+  }
+  KeyComparator comparator;
+  for (int i = 0; i < kKeyCnt; ++i) {
+    auto normalized = Normalizer::Normalize(keys[i]);
+    EXPECT_EQ(comparator(Normalizer::Denormalize(normalized), keys[i]), 0);
+    // neighbours often share a prefix, so compare them as well as random pairs
+    for (int j : {(i + 1) % kKeyCnt, (i * 7 + 3) % kKeyCnt}) {
+      EXPECT_EQ(Sign(Normalizer::Compare(normalized, Normalizer::Normalize(keys[j]))),
+                Sign(comparator(keys[i], keys[j])));
+    }
+  }
+}
+
+TEST(NormalizedKeyTests, OrderTest) {
+  std::mt19937 rng(20240615);
+  // few distinct values per field, so that keys often tie on their first fields
+  auto small = [&rng]() { return static_cast<int>(rng() % 5) - 2; };
+  auto chars = [&rng]() {
+    array<char, 20> res;
+    for (int i = 0; i < 20; ++i) {
+      res[i] = static_cast<char>(rng() % 3 == 0 ? rng() % 256 : 'a' + rng() % 2);
+    }
+    return res;
+  };
+  CheckOrder<Key, Comparator>([&]() {
+    Key key;
+    key.hash1_ = small();
+    key.hash2_ = small();
+    key.value_ = static_cast<int>(rng());
+    return key;
+  });
+  CheckOrder<array<char, 20>, UserComparator>(chars);
+  CheckOrder<array<char, 20>, TrainComparator>(chars);
+  CheckOrder<array<unsigned int, 10>, StationComparator>([&]() {
+    array<unsigned int, 10> res;
+    for (int i = 0; i < 10; ++i) {
+      res[i] = rng() % 2 == 0 ? rng() % 2 : rng();
+    }
+    return res;
+  });
+  CheckOrder<StationTrain, StationTrainComparator>([&]() {
+    return StationTrain{small(), static_cast<int>(rng())};
+  });
+  CheckOrder<BuyInfo, BuyInfoComparator>([&]() { return BuyInfo{chars(), static_cast<int>(rng())}; });
+  CheckOrder<int, TimeComparator>([&]() { return static_cast<int>(rng()); });
+}
+
+TEST(NormalizedKeyTests, SearchTest) {
+  using Normalizer = KeyNormalizer<int, TimeComparator>;
+  std::mt19937 rng(7);
+  for (int size = 0; size < 100; ++size) {
+    std::vector<int> keys;
+    for (int i = 0; i < size; ++i) {
+      keys.push_back(static_cast<int>(rng() % 64) - 32);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    for (int key = -34; key <= 34; ++key) {
+      int lower = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+      int upper = std::upper_bound(keys.begin(), keys.end(), key) - keys.begin();
+      int end = static_cast<int>(keys.size());
+      EXPECT_EQ((SearchNormalized<false, Normalizer>(keys.data(), 0, end, key)), lower);
+      EXPECT_EQ((SearchNormalized<true, Normalizer>(keys.data(), 0, end, key)), upper);
+    }
+  }
+}
+
+}
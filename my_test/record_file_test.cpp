@@ -0,0 +1,37 @@
+#include <cstddef>
+#include "record_file/record_file.hpp"
+#include "my_stl/array.hpp"
+#include "gtest/gtest.h"
+
+namespace sjtu {
+
+TEST(RecordFileTests, UpdateReopenTest) {
+  constexpr int kRecordCnt = 1000;
+  using Record = array<int, 30>;
+  {
+    RecordFile<Record> record_file("record_file_test_db");
+    record_file.Clean();
+    for (int i = 1; i <= kRecordCnt; ++i) {
+      Record record;
+      for (int j = 0; j < 30; ++j) {
+        record[j] = i * 100 + j;
+      }
+      record_file.Update(record, i);
+    }
+    // a partial update leaves the rest of the record untouched
+    Record record;
+    record[5] = -1;
+    record_file.Update(record, 7, 5 * sizeof(int), sizeof(int));
+    EXPECT_EQ((*record_file.Read(7))[5], -1);
+    EXPECT_EQ((*record_file.Read(7))[6], 706);
+  }
+  RecordFile<Record> record_file("record_file_test_db");
+  for (int i = 1; i <= kRecordCnt; ++i) {
+    auto guard = record_file.Read(i);
+    for (int j = 0; j < 30; ++j) {
+      EXPECT_EQ((*guard)[j], i == 7 && j == 5 ? -1 : i * 100 + j);
+    }
+  }
+}
+
+}
@@ -0,0 +1,111 @@
+#include "buffer/replacer.h"
+#include "config.h"
+#include "gtest/gtest.h"
+
+namespace sjtu {
+
+// Load a page into a frame and unpin it, as the buffer pool does on a miss
+void Load(Replacer *replacer, int frame_id, int page_id) {
+  replacer->RecordAccess(frame_id, page_id);
+  replacer->SetEvictable(frame_id, true);
+}
+
+TEST(ReplacerTests, PinTest) {
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::CLOCK, ReplacerType::TWO_Q, ReplacerType::ARC}) {
+    auto replacer = MakeReplacer(type, 4, LRUK_REPLACER_K);
+    for (int frame_id = 0; frame_id < 4; ++frame_id) {
+      replacer->RecordAccess(frame_id, frame_id);
+    }
+    EXPECT_EQ(replacer->Size(), 0);
+    EXPECT_FALSE(replacer->Evict().has_value());
+    replacer->SetEvictable(1, true);
+    replacer->SetEvictable(3, true);
+    replacer->SetEvictable(3, true);
+    EXPECT_EQ(replacer->Size(), 2);
+    EXPECT_THROW(replacer->Remove(0), std::exception);
+    replacer->Remove(3);
+    EXPECT_EQ(replacer->Size(), 1);
+    EXPECT_EQ(replacer->Evict(), 1);
+    EXPECT_FALSE(replacer->Evict().has_value());
+    replacer->Clean();
+    EXPECT_EQ(replacer->Size(), 0);
+  }
+}
+
+TEST(ReplacerTests, ScanAccessTest) {
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::CLOCK, ReplacerType::TWO_Q, ReplacerType::ARC}) {
+    auto replacer = MakeReplacer(type, 4, LRUK_REPLACER_K);
+    for (int frame_id = 0; frame_id < 3; ++frame_id) {
+      Load(replacer.get(), frame_id, frame_id);
+    }
+    // the page loaded by a scan is the next victim, and reading it again in the scan does not promote it
+    replacer->RecordAccess(3, 3, AccessType::Scan);
+    replacer->SetEvictable(3, true);
+    replacer->RecordAccess(3, 3, AccessType::Scan);
+    EXPECT_EQ(replacer->Evict(), 3);
+  }
+}
+
+TEST(ReplacerTests, ScanReloadTest) {
+  constexpr int kFrameCnt = 8;
+  for (auto type : {ReplacerType::TWO_Q, ReplacerType::ARC}) {
+    SCOPED_TRACE(static_cast<int>(type));
+    auto replacer = MakeReplacer(type, kFrameCnt, LRUK_REPLACER_K);
+    for (int frame_id = 0; frame_id < kFrameCnt; ++frame_id) {
+      Load(replacer.get(), frame_id, frame_id);
+    }
+    // a scan reloads a page remembered in a ghost list, and the page is evicted again before the ghosts overflow
+    auto frame_id = replacer->Evict();
+    ASSERT_TRUE(frame_id.has_value());
+    int page_id = *frame_id;
+    replacer->RecordAccess(*frame_id, page_id, AccessType::Scan);
+    replacer->SetEvictable(*frame_id, true);
+    EXPECT_EQ(replacer->Evict(), frame_id);
+    for (int new_page_id = kFrameCnt; new_page_id < 10 * kFrameCnt; ++new_page_id) {
+      Load(replacer.get(), *frame_id, new_page_id);
+      frame_id = replacer->Evict();
+      ASSERT_TRUE(frame_id.has_value());
+    }
+  }
+}
+
+TEST(ReplacerTests, ClockTest) {
+  auto replacer = MakeReplacer(ReplacerType::CLOCK, 3, LRUK_REPLACER_K);
+  for (int frame_id = 0; frame_id < 3; ++frame_id) {
+    Load(replacer.get(), frame_id, frame_id);
+  }
+  // the first sweep clears every reference bit
+  EXPECT_EQ(replacer->Evict(), 0);
+  // the frame read again gets a second chance
+  replacer->RecordAccess(1, 1);
+  EXPECT_EQ(replacer->Evict(), 2);
+  EXPECT_EQ(replacer->Evict(), 1);
+}
+
+// A page read again soon after its eviction must survive a scan
+void CheckScanResistance(ReplacerType type) {
+  constexpr int kFrameCnt = 8;
+  auto replacer = MakeReplacer(type, kFrameCnt, LRUK_REPLACER_K);
+  for (int frame_id = 0; frame_id < kFrameCnt; ++frame_id) {
+    Load(replacer.get(), frame_id, frame_id);
+  }
+  auto frame_id = replacer->Evict();
+  ASSERT_EQ(frame_id, 0);
+  Load(replacer.get(), 0, 0);
+  for (int page_id = kFrameCnt; page_id < 10 * kFrameCnt; ++page_id) {
+    frame_id = replacer->Evict();
+    ASSERT_TRUE(frame_id.has_value());
+    ASSERT_NE(frame_id, 0);
+    Load(replacer.get(), *frame_id, page_id);
+  }
+}
+
+TEST(ReplacerTests, TwoQueueTest) {
+  CheckScanResistance(ReplacerType::TWO_Q);
+}
+
+TEST(ReplacerTests, ArcTest) {
+  CheckScanResistance(ReplacerType::ARC);
+}
+
+}
@@ -1,3 +1,5 @@
+#include <unistd.h>
+#include <sys/wait.h>
 #include "system/system.h"
 #include "gtest/gtest.h"
 
@@ -27,4 +29,129 @@ TEST(TicketSystemTests, BasicBuyTicketTest) {
 
   std::cout.rdbuf(originalCoutBuf);
 }
-}
\ No newline at end of file
+
+TEST(TicketSystemTests, ParallelRunTest) {
+  std::stringstream commands;
+  int timestamp = 0;
+  commands << "[" << ++timestamp << "] clean\n";
+  commands << "[" << ++timestamp << "] add_user -c a -g 1 -u root -p 1 -n 根 -m root@sjtu\n";
+  commands << "[" << ++timestamp << "] login -u root -p 1\n";
+  for (int i = 0; i < 8; ++i) {
+    commands << "[" << ++timestamp << "] add_user -c root -g 1 -u user" << i << " -p 1 -n 用户 -m u@sjtu\n";
+    commands << "[" << ++timestamp << "] login -u user" << i << " -p 1\n";
+  }
+  commands << "[" << ++timestamp << "] add_train -i T1 -n 3 -m 10 -s 上院|中院|下院 -p 1|2 -x 19:19 -t 600|600 -o 5 "
+           << "-d 06-01|08-17 -y G\n";
+  commands << "[" << ++timestamp << "] add_train -i T2 -n 2 -m 5 -s 中院|下院 -p 3 -x 08:00 -t 60 -o _ "
+           << "-d 06-01|08-17 -y D\n";
+  commands << "[" << ++timestamp << "] release_train -i T1\n";
+  commands << "[" << ++timestamp << "] release_train -i T2\n";
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 0; i < 8; ++i) {
+      commands << "[" << ++timestamp << "] buy_ticket -u user" << i << " -i T" << i % 2 + 1 << " -d 07-0" << round % 3 + 1
+               << " -n " << i % 3 + 1 << " -f 中院 -t 下院 -q true\n";
+      commands << "[" << ++timestamp << "] query_ticket -s 中院 -t 下院 -d 07-0" << round % 3 + 1 << "\n";
+      commands << "[" << ++timestamp << "] query_train -i T1 -d 07-0" << round % 3 + 1 << "\n";
+      commands << "[" << ++timestamp << "] query_order -u user" << (i + round) % 8 << "\n";
+    }
+    commands << "[" << ++timestamp << "] refund_ticket -u user" << round % 8 << "\n";
+    commands << "[" << ++timestamp << "] modify_profile -c root -u user" << round % 8 << " -g 2\n";
+    commands << "[" << ++timestamp << "] query_profile -c user" << round % 8 << " -u user" << round % 8 << "\n";
+  }
+  commands << "[" << ++timestamp << "] exit\n";
+
+  std::streambuf* originalCinBuf = std::cin.rdbuf();
+  std::streambuf* originalCoutBuf = std::cout.rdbuf();
+  std::string outputs[2];
+  for (int worker_cnt : {0, 4}) {
+    std::stringstream input_stream(commands.str());
+    std::cin.rdbuf(input_stream.rdbuf());
+    std::stringstream output_stream;
+    std::cout.rdbuf(output_stream.rdbuf());
+    System system("sword");
+    system.Run(worker_cnt);
+    outputs[worker_cnt == 0 ? 0 : 1] = output_stream.str();
+  }
+  std::cin.rdbuf(originalCinBuf);
+  std::cout.rdbuf(originalCoutBuf);
+  EXPECT_EQ(outputs[0], outputs[1]);
+}
+
+TEST(TicketSystemTests, CrashRecoveryTest) {
+  std::stringstream commands;
+  commands << "[1] clean\n";
+  commands << "[2] add_train -i HAPPY_TRAIN -n 3 -m 1000 -s 上院|中院|下院 -p 114|514 -x 19:19 -t 600|600 -o 5 -d 06-01|08-17 -y G\n";
+  commands << "[3] release_train -i HAPPY_TRAIN\n";
+  commands << "[4] add_user -c a -g 1 -u Texas -p 114514 -n 强 -m @sjtu.edu.cn\n";
+  commands << "[5] login -u Texas -p 114514\n";
+  commands << "[6] buy_ticket -u Texas -i HAPPY_TRAIN -d 08-17 -n 800 -f 中院 -t 下院\n";
+
+  std::streambuf* originalCinBuf = std::cin.rdbuf();
+  std::streambuf* originalCoutBuf = std::cout.rdbuf();
+  pid_t pid = fork();
+  if (pid == 0) {
+    // crash right after the output is printed, without exit or any destructor
+    std::cin.rdbuf(commands.rdbuf());
+    std::stringstream output_stream;
+    std::cout.rdbuf(output_stream.rdbuf());
+    System system("sword");
+    system.Run();
+    _exit(output_stream.str() == "[1] 0\n[2] 0\n[3] 0\n[4] 0\n[5] 0\n[6] 411200\n" ? 0 : 1);
+  }
+  int status;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+
+  // Texas is still logged in, and the ticket is still sold
+  std::stringstream input_stream;
+  input_stream << "[7] query_order -u Texas\n";
+  input_stream << "[8] buy_ticket -u Texas -i HAPPY_TRAIN -d 08-17 -n 800 -f 中院 -t 下院\n";
+  input_stream << "[9] exit\n";
+  std::cin.rdbuf(input_stream.rdbuf());
+  std::stringstream output_stream;
+  std::cout.rdbuf(output_stream.rdbuf());
+  {
+    System system("sword");
+    system.Run();
+  }
+  std::cin.rdbuf(originalCinBuf);
+  std::cout.rdbuf(originalCoutBuf);
+  EXPECT_EQ(output_stream.str(), "[7] 1\n[success] HAPPY_TRAIN 中院 08-17 05:24 -> 下院 08-17 15:24 514 800\n"
+                                 "[8] -1\n[9] bye\n");
+}
+
+TEST(TicketSystemTests, SnapshotTest) {
+  std::stringstream input_stream;
+  input_stream << "[1] clean\n";
+  input_stream << "[2] add_train -i HAPPY_TRAIN -n 3 -m 1000 -s 上院|中院|下院 -p 114|514 -x 19:19 -t 600|600 -o 5 -d 06-01|08-17 -y G\n";
+  input_stream << "[3] release_train -i HAPPY_TRAIN\n";
+  input_stream << "[4] add_user -c a -g 1 -u Texas -p 114514 -n 强 -m @sjtu.edu.cn\n";
+  input_stream << "[5] login -u Texas -p 114514\n";
+  input_stream << "[6] create_snapshot -n before\n";
+  input_stream << "[7] buy_ticket -u Texas -i HAPPY_TRAIN -d 08-17 -n 800 -f 中院 -t 下院\n";
+  input_stream << "[8] create_snapshot -n before\n";
+  input_stream << "[9] create_snapshot -n after\n";
+  input_stream << "[10] switch_snapshot -n before\n";
+  input_stream << "[11] query_order -u Texas\n";
+  input_stream << "[12] buy_ticket -u Texas -i HAPPY_TRAIN -d 08-17 -n 800 -f 中院 -t 下院\n";
+  input_stream << "[13] switch_snapshot -n after\n";
+  input_stream << "[14] buy_ticket -u Texas -i HAPPY_TRAIN -d 08-17 -n 800 -f 中院 -t 下院\n";
+  input_stream << "[15] drop_snapshot -n after\n";
+  input_stream << "[16] switch_snapshot -n after\n";
+  input_stream << "[17] exit\n";
+  std::streambuf* originalCinBuf = std::cin.rdbuf();
+  std::streambuf* originalCoutBuf = std::cout.rdbuf();
+  std::cin.rdbuf(input_stream.rdbuf());
+  std::stringstream output_stream;
+  std::cout.rdbuf(output_stream.rdbuf());
+  {
+    System system("sword");
+    system.Run();
+  }
+  std::cin.rdbuf(originalCinBuf);
+  std::cout.rdbuf(originalCoutBuf);
+  EXPECT_EQ(output_stream.str(), "[1] 0\n[2] 0\n[3] 0\n[4] 0\n[5] 0\n[6] 0\n[7] 411200\n[8] -1\n[9] 0\n[10] 0\n"
+                                 "[11] 0\n[12] 411200\n[13] 0\n[14] -1\n[15] 0\n[16] -1\n[17] bye\n");
+}
+}
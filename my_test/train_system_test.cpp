@@ -71,4 +71,39 @@ TEST(TrainSystemTests, BasicQueryTransferTest) {
   std::cout.rdbuf(originalCoutBuf);
 }
 
-}
\ No newline at end of file
+TEST(TrainSystemTests, SeatCacheTest) {
+  constexpr int kTrainCnt = 4;
+  {
+    RecordFile<Train, TRAIN_PAGE_SIZE> trains("seat_cache_test");
+    trains.Clean();
+    for (int i = 1; i <= kTrainCnt; ++i) {
+      Train train;
+      for (int j = 0; j < 23; ++j) {
+        train.seatNum_[0][j] = 100;
+      }
+      trains.Update(train, i);
+    }
+    SeatCache cache(&trains, 2);
+    for (int i = 1; i <= kTrainCnt; ++i) {
+      auto seats = cache.Get(i, 0);
+      seats[0] -= i;
+      cache.Put(i, 0, seats);
+    }
+    // the first rows were written back when evicted, the last ones are still only in the cache
+    EXPECT_EQ(trains.Read(1)->seatNum_[0][0], 99);
+    EXPECT_EQ(trains.Read(kTrainCnt)->seatNum_[0][0], 100);
+    Seats seats;
+    EXPECT_FALSE(cache.Find(1, 0, &seats));
+    EXPECT_TRUE(cache.Find(kTrainCnt, 0, &seats));
+    EXPECT_EQ(seats[0], 100 - kTrainCnt);
+    cache.FlushAll();
+    EXPECT_EQ(trains.Read(kTrainCnt)->seatNum_[0][0], 100 - kTrainCnt);
+  }
+  RecordFile<Train, TRAIN_PAGE_SIZE> trains("seat_cache_test");
+  for (int i = 1; i <= kTrainCnt; ++i) {
+    EXPECT_EQ(trains.Read(i)->seatNum_[0][0], 100 - i);
+    EXPECT_EQ(trains.Read(i)->seatNum_[0][1], 100);
+  }
+}
+
+}
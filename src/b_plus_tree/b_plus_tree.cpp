@@ -1,35 +1,125 @@
 #include "b_plus_tree/b_plus_tree.h"
+
+#include <algorithm>
+
 #include "comparator.h"
 #include "system/user_system/user.h"
 #include "system/train_system/train.h"
 #include "system/ticket_system/ticket.h"
+#include "heap_file/heap_file.h"
 
 namespace sjtu {
 
 INDEX_TEMPLATE_ARGUMENTS
-BPLUSTREE_TYPE::BPlusTree(std::string name, int leaf_max_size, int internal_max_size)
+BPLUSTREE_TYPE::BPlusTree(std::string name, ReplacerType replacer_type, int leaf_max_size, int internal_max_size)
     : index_name_(std::move(name)),
-      disk_manager_(std::make_shared<DiskManager>(index_name_)),
-      bpm_(new BufferPoolManager(100, disk_manager_, 10)),
+      disk_manager_(std::make_shared<DiskManager>(index_name_, DIRECT_IO, PageSize)),
+      bpm_(new BufferPoolManager(INDEX_BUFFER_POOL_SIZE, disk_manager_, LRUK_REPLACER_K, 0, replacer_type)),
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size),
       header_page_id_(bpm_->NewPage()) {
-  WritePageGuard guard = bpm_->WritePage(header_page_id_);
-  auto root_page = guard.AsMut<BPlusTreeHeaderPage>();
-  if (root_page->root_page_id_ == 0) {
-    root_page->root_page_id_ = -1;
+  ResetHints();
+  // an existing header page is only read, so that opening a tree does not copy a header page shared with snapshots
+  auto guard = bpm_->ReadPage(header_page_id_);
+  if (guard.As<BPlusTreeHeaderPage>()->root_page_id_ == 0) {
+    guard.Drop();
+    bpm_->WritePage(header_page_id_).AsMut<BPlusTreeHeaderPage>()->root_page_id_ = -1;
   } else {
-    bpm_->InitPageCnt(root_page->page_cnt_);
+    bpm_->InitPageCnt(guard.As<BPlusTreeHeaderPage>()->page_cnt_);
+    size_ = guard.As<BPlusTreeHeaderPage>()->size_;
   }
+  guard.Drop();
+  RefreshResidentPages();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::~BPlusTree() {
-  bpm_->WritePage(header_page_id_).AsMut<BPlusTreeHeaderPage>()->page_cnt_ = bpm_->PageCnt();
+  SaveHeader();
   bpm_->FlushAllPages();
+  // a tree owned by a System has nothing new here since its final checkpoint
+  disk_manager_->Apply();
   delete bpm_;
 }
 
+/**
+ * @brief First phase of a checkpoint: write back every dirty page and make them durable in the pending file.
+ *
+ * @param epoch the epoch of the checkpoint
+ * @param[out] files the database files prepared by this checkpoint
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::PrepareCheckpoint(size_t epoch, vector<std::string> *files) {
+  SaveHeader();
+  bpm_->FlushAllPages();
+  disk_manager_->Prepare(epoch);
+  files->push_back(disk_manager_->GetFileName());
+}
+
+/**
+ * @brief Second phase of a checkpoint, once it is committed: move the prepared pages into the database file.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ApplyCheckpoint() {
+  disk_manager_->Apply();
+}
+
+/**
+ * @brief Save the page counter and the size in the header page. The header page is left clean if both are unchanged,
+ * so a snapshot of an unchanged tree does not copy it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SaveHeader() {
+  int page_cnt = bpm_->PageCnt();
+  int size = size_;
+  auto guard = bpm_->ReadPage(header_page_id_);
+  if (guard.As<BPlusTreeHeaderPage>()->page_cnt_ == page_cnt && guard.As<BPlusTreeHeaderPage>()->size_ == size) {
+    return;
+  }
+  guard.Drop();
+  auto write_guard = bpm_->WritePage(header_page_id_);
+  write_guard.AsMut<BPlusTreeHeaderPage>()->page_cnt_ = page_cnt;
+  write_guard.AsMut<BPlusTreeHeaderPage>()->size_ = size;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CreateSnapshot(const std::string &name) -> bool {
+  SaveHeader();
+  return bpm_->CreateSnapshot(name);
+}
+
+/**
+ * @brief Switch to a snapshot. Page ids are allocated from where the snapshot left off.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SwitchSnapshot(const std::string &name) -> bool {
+  if (!bpm_->SwitchSnapshot(name)) {
+    return false;
+  }
+  auto guard = bpm_->ReadPage(header_page_id_);
+  bpm_->InitPageCnt(guard.As<BPlusTreeHeaderPage>()->page_cnt_);
+  size_ = guard.As<BPlusTreeHeaderPage>()->size_;
+  guard.Drop();
+  ResetHints();
+  // the pool dropped its resident region together with the replaced pages
+  resident_pages_.clear();
+  height_root_page_id_ = -1;
+  RefreshResidentPages();
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::DropSnapshot(const std::string &name) -> bool {
+  return bpm_->DropSnapshot(name);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CollectStats(vector<FileStats> *stats) {
+  auto file_stats = bpm_->GetStats();
+  file_stats.entry_cnt_ = GetSize();
+  file_stats.height_ = GetHeight();
+  stats->push_back(file_stats);
+}
+
 /**
  * @brief Helper function to decide whether current b+tree is empty
  * @return Returns true if this B+ tree has no keys and values.
@@ -43,7 +133,8 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return GetRootPageId() == -1; }
 /**
  * @brief Return the only value that associated with input key
  *
- * This method is used for point query
+ * This method is used for point query. Read latches are crabbed down the tree: the latch of a parent is released as
+ * soon as the latch of the child is held.
  *
  * @param key input key
  * @param[out] result vector that stores the only value that associated with input key, if the value exists
@@ -53,34 +144,29 @@ INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, vector<ValueType> *result) -> bool {
   // Declaration of context instance. Using the Context is not necessary but advised.
   Context ctx;
-  ctx.root_page_id_ = GetRootPageId();
+  auto normalized_key = Normalizer::Normalize(key);
+  ctx.read_set_.emplace_back(bpm_->ReadPage(header_page_id_, header_swip_));
+  ctx.root_page_id_ = ctx.read_set_.back().As<BPlusTreeHeaderPage>()->root_page_id_;
   if (ctx.root_page_id_ == -1) {
     return false;
   }
-  ctx.read_set_.emplace_back(bpm_->ReadPage(ctx.root_page_id_));
+  ctx.read_set_.emplace_back(bpm_->ReadPage(ctx.root_page_id_, root_swip_));
+  ctx.read_set_.pop_front();
   while (true) {
-    auto it = --ctx.read_set_.end();
+    auto it = &ctx.read_set_.back();
     auto page = it->As<BPlusTreePage>();
-    auto size = page->GetSize();
     if (page->IsLeafPage()) {
       auto leaf_page = it->As<LeafPage>();
-      for (int i = 0; i < size; ++i) {
-        if (comparator_(leaf_page->KeyAt(i), key) == 0) {
-          result->push_back(leaf_page->RidAt(i));
-          return true;
-        }
+      int pos = leaf_page->KeyIndex(normalized_key);
+      if (pos < page->GetSize() && Normalizer::Compare(leaf_page->KeyAt(pos), normalized_key) == 0) {
+        result->push_back(leaf_page->RidAt(pos));
+        return true;
       }
       return false;
     }
     auto internal_page = it->As<InternalPage>();
-    int pos = size;
-    for (int i = 1; i < size; ++i) {
-      if (comparator_(key, internal_page->KeyAt(i)) < 0) {
-        pos = i;
-        break;
-      }
-    }
-    ctx.read_set_.emplace_back(bpm_->ReadPage(internal_page->ValueAt(pos - 1)));
+    ctx.read_set_.emplace_back(ReadChild(*it, ctx.root_page_id_, internal_page->ChildIndex(normalized_key)));
+    ctx.read_set_.pop_front();
   }
 }
 
@@ -90,6 +176,10 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, vector<ValueType> *result) ->
 /**
  * @brief Return all value that satisfied rough comparator
  *
+ * The scan keeps the read latches of the whole root-to-leaf path and moves to the next leaf through the parents, so
+ * every latch is still taken top-down and left-to-right like writers do. The leaves after the first one are read
+ * through a ScanRing, so a long scan does not evict the pages of the lookups.
+ *
  * @param key input key
  * @param[out] result vector that stores all value that satisfied rough comparator
  */
@@ -97,70 +187,241 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::GetAllValue(const KeyType &key, vector<ValueType> *result) {
   // Declaration of context instance. Using the Context is not necessary but advised.
   Context ctx;
-  ctx.root_page_id_ = GetRootPageId();
+  auto header_guard = bpm_->ReadPage(header_page_id_, header_swip_);
+  ctx.root_page_id_ = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
   if (ctx.root_page_id_ == -1) {
     return;
   }
-  ctx.read_set_.emplace_back(bpm_->ReadPage(ctx.root_page_id_));
+  ctx.read_set_.emplace_back(bpm_->ReadPage(ctx.root_page_id_, root_swip_));
+  header_guard.Drop();
   while (true) {
-    auto it = --ctx.read_set_.end();
+    auto it = &ctx.read_set_.back();
     auto page = it->As<BPlusTreePage>();
     auto size = page->GetSize();
-    if (it->GetPageId() == 0) {
-      exit(0);
-    }
     if (page->IsLeafPage()) {
-      auto leaf_page = it->As<LeafPage>();
-      for (int i = 0; i < size; ++i) {
-        if (rough_comparator_(leaf_page->KeyAt(i), key) > 0) {
-          return;
-        }
-        if (rough_comparator_(leaf_page->KeyAt(i), key) == 0) {
-          auto page_id = it->GetPageId();
-          ctx.read_set_.pop_back();
-          auto guard = bpm_->ReadPage(page_id);
-          leaf_page = guard.As<LeafPage>();
-          while (rough_comparator_(leaf_page->KeyAt(i), key) == 0) {
-            result->push_back(leaf_page->RidAt(i));
-            ++i;
-            if (i == size) {
-              auto nxt = leaf_page->GetNextPageId();
-              if (nxt == -1) {
-                return;
-              }
-              page_id = nxt;
-              guard = bpm_->ReadPage(page_id);
-              leaf_page = guard.As<LeafPage>();
-              i = 0;
-              size = leaf_page->GetSize();
-            }
-          }
-          return;
-        }
-        if (i + 1 == size) {
-          int nxt = leaf_page->GetNextPageId();
-          if (nxt == -1) {
-            return;
-          }
-          ctx.read_set_.pop_back();
-          ctx.read_set_.emplace_back(bpm_->ReadPage(nxt));
-          it = --ctx.read_set_.end();
-          leaf_page = it->As<LeafPage>();
-          size = leaf_page->GetSize();
-          i = -1;
-        }
-      }
-      return;
+      break;
     }
+    // the child before the first key not less than the prefix, found by a binary search over the separators
     auto internal_page = it->As<InternalPage>();
-    int pos = size;
-    for (int i = 1; i < size; ++i) {
-      if (rough_comparator_(key, internal_page->KeyAt(i)) <= 0) {
-        pos = i;
-        break;
+    int begin = 1;
+    int end = size;
+    while (begin < end) {
+      int mid = (begin + end) / 2;
+      if (rough_comparator_(key, Normalizer::Denormalize(internal_page->KeyAt(mid))) > 0) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    ctx.which_son_.push_back(begin - 1);
+    ctx.read_set_.emplace_back(ReadChild(*it, ctx.root_page_id_, begin - 1));
+  }
+  ScanRing ring;
+  bool found = false;
+  do {
+    auto leaf_page = ctx.read_set_.back().As<LeafPage>();
+    auto size = leaf_page->GetSize();
+    // until the first match, skip the keys before the prefix by a binary search
+    int begin = 0;
+    int end = found ? 0 : size;
+    while (begin < end) {
+      int mid = (begin + end) / 2;
+      if (rough_comparator_(Normalizer::Denormalize(leaf_page->KeyAt(mid)), key) < 0) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    for (int i = begin; i < size; ++i) {
+      if (rough_comparator_(Normalizer::Denormalize(leaf_page->KeyAt(i)), key) != 0) {
+        return;
+      }
+      found = true;
+      result->push_back(leaf_page->RidAt(i));
+    }
+  } while (NextLeaf(&ctx, &ring));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::GetAll(vector<ValueType> *result) {
+  Context ctx;
+  auto header_guard = bpm_->ReadPage(header_page_id_, header_swip_);
+  ctx.root_page_id_ = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (ctx.root_page_id_ == -1) {
+    return;
+  }
+  ctx.read_set_.emplace_back(bpm_->ReadPage(ctx.root_page_id_, root_swip_));
+  header_guard.Drop();
+  while (!ctx.read_set_.back().As<BPlusTreePage>()->IsLeafPage()) {
+    ctx.which_son_.push_back(0);
+    ctx.read_set_.emplace_back(ReadChild(ctx.read_set_.back(), ctx.root_page_id_, 0));
+  }
+  ScanRing ring;
+  ReadAheadLeaves(&ctx, &ring);
+  do {
+    auto leaf_page = ctx.read_set_.back().As<LeafPage>();
+    auto size = leaf_page->GetSize();
+    for (int i = 0; i < size; ++i) {
+      result->push_back(leaf_page->RidAt(i));
+    }
+  } while (NextLeaf(&ctx, &ring));
+}
+
+/**
+ * @brief Move a scan to the next leaf.
+ *
+ * `ctx->read_set_` holds the read guards of the path from the root to the current leaf and `ctx->which_son_` the
+ * child index taken in each internal page of that path. The current leaf is released before the next one is latched,
+ * while the common ancestor keeps both of them from being split or merged. The pages are read through the ring of
+ * the scan.
+ *
+ * @return false if the current leaf is the last one
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::NextLeaf(Context *ctx, ScanRing *ring) -> bool {
+  ctx->read_set_.pop_back();
+  while (!ctx->read_set_.empty()) {
+    auto internal_page = ctx->read_set_.back().As<InternalPage>();
+    auto son = ctx->which_son_.back() + 1;
+    if (son < internal_page->GetSize()) {
+      ctx->which_son_.pop_back();
+      ctx->which_son_.push_back(son);
+      ctx->read_set_.emplace_back(bpm_->ReadPage(internal_page->ValueAt(son), ring));
+      while (!ctx->read_set_.back().As<BPlusTreePage>()->IsLeafPage()) {
+        internal_page = ctx->read_set_.back().As<InternalPage>();
+        ctx->which_son_.push_back(0);
+        ctx->read_set_.emplace_back(bpm_->ReadPage(internal_page->ValueAt(0), ring));
       }
+      ReadAheadLeaves(ctx, ring);
+      return true;
+    }
+    ctx->read_set_.pop_back();
+    ctx->which_son_.pop_back();
+  }
+  return false;
+}
+
+/**
+ * @brief Read ahead the next READ_AHEAD_PAGE_CNT leaves of a scan under the same parent.
+ *
+ * The parent is still read-latched, so its children cannot be deleted meanwhile.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReadAheadLeaves(Context *ctx, ScanRing *ring) {
+  if (ctx->read_set_.size() < 2) {
+    return;
+  }
+  auto parent_page = ctx->read_set_[ctx->read_set_.size() - 2].As<InternalPage>();
+  int son = ctx->which_son_.back();
+  int end = std::min(son + READ_AHEAD_PAGE_CNT, parent_page->GetSize() - 1);
+  vector<int> page_ids;
+  for (int i = son + 1; i <= end; ++i) {
+    page_ids.push_back(parent_page->ValueAt(i));
+  }
+  if (!page_ids.empty()) {
+    bpm_->ReadAhead(page_ids, ring);
+  }
+}
+
+/**
+ * @brief Find the leaf that may contain `key` for an optimistic update.
+ *
+ * Internal pages are only read-latched. The leaf is read-latched first to learn that it is a leaf, then re-latched in
+ * write mode while its parent is still read-latched, which keeps any other thread from splitting or merging it
+ * in between (structural changes always hold the parent's write latch).
+ *
+ * @param key the key to look for
+ * @param[out] root_page_id the root page id seen by this descent, -1 if the tree is empty
+ * @return the write guard of the leaf, or std::nullopt if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const NormalizedKey &key, int *root_page_id)
+    -> std::optional<WritePageGuard> {
+  Context ctx;
+  ctx.read_set_.emplace_back(bpm_->ReadPage(header_page_id_, header_swip_));
+  ctx.root_page_id_ = ctx.read_set_.back().As<BPlusTreeHeaderPage>()->root_page_id_;
+  *root_page_id = ctx.root_page_id_;
+  if (ctx.root_page_id_ == -1) {
+    return std::nullopt;
+  }
+  auto guard = bpm_->ReadPage(ctx.root_page_id_, root_swip_);
+  while (true) {
+    auto page = guard.template As<BPlusTreePage>();
+    if (page->IsLeafPage()) {
+      int page_id = guard.GetPageId();
+      guard.Drop();
+      return bpm_->WritePage(page_id);
+    }
+    auto internal_page = guard.template As<InternalPage>();
+    auto child_guard = ReadChild(guard, ctx.root_page_id_, internal_page->ChildIndex(key));
+    ctx.read_set_.pop_front();
+    ctx.read_set_.emplace_back(std::move(guard));
+    guard = std::move(child_guard);
+  }
+}
+
+/**
+ * @brief Find the leaf of a key without a descent, from the last leaf of its prefix or the right-most leaf.
+ *
+ * A remembered leaf is only trusted for keys between its first and its last key, or after its last key if it is still
+ * the right-most leaf, so splits and merges of the leaf since do not matter. A deleted leaf may still read as a leaf,
+ * so a hint is dropped once any leaf was deleted after it was taken.
+ *
+ * @param key the key to look for
+ * @param normalized_key the key as stored in the pages
+ * @return the write guard of the leaf, or std::nullopt if no remembered leaf holds the key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafByHint(const KeyType &key, const NormalizedKey &normalized_key)
+    -> std::optional<WritePageGuard> {
+  uint64_t hints[2] = {kNoHint, right_most_leaf_.load(std::memory_order_relaxed)};
+  if constexpr (PrefixHasher<RoughKeyComparator, KeyType>) {
+    hints[0] = prefix_leaves_[rough_comparator_.Hash(key) % APPEND_HINT_SLOT_CNT].load(std::memory_order_relaxed);
+  }
+  for (int i = 0; i < 2; ++i) {
+    auto page_id = static_cast<int>(static_cast<uint32_t>(hints[i]));
+    if (page_id == -1 || (i == 1 && hints[1] == hints[0])) {
+      continue;
+    }
+    auto guard = bpm_->WritePage(page_id);
+    // the latch orders this read after the deletion of the leaf, which counts it while holding the latch
+    if (leaf_delete_cnt_.load(std::memory_order_relaxed) != hints[i] >> 32) {
+      continue;
+    }
+    auto leaf_page = guard.template As<LeafPage>();
+    auto size = leaf_page->GetSize();
+    if (!leaf_page->IsLeafPage() || size == 0 || Normalizer::Compare(leaf_page->KeyAt(0), normalized_key) > 0) {
+      continue;
+    }
+    if (leaf_page->GetNextPageId() == -1 || Normalizer::Compare(normalized_key, leaf_page->KeyAt(size - 1)) < 0) {
+      return guard;
     }
-    ctx.read_set_.emplace_back(bpm_->ReadPage(internal_page->ValueAt(pos - 1)));
+  }
+  return std::nullopt;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RememberLeaf(const KeyType &key, const WritePageGuard &guard) {
+  auto hint = static_cast<uint64_t>(leaf_delete_cnt_.load(std::memory_order_relaxed)) << 32 |
+              static_cast<uint32_t>(guard.GetPageId());
+  // skip the store if nothing changed, so that appends do not keep writing the shared cache line
+  if constexpr (PrefixHasher<RoughKeyComparator, KeyType>) {
+    auto &slot = prefix_leaves_[rough_comparator_.Hash(key) % APPEND_HINT_SLOT_CNT];
+    if (slot.load(std::memory_order_relaxed) != hint) {
+      slot.store(hint, std::memory_order_relaxed);
+    }
+  }
+  if (guard.template As<LeafPage>()->GetNextPageId() == -1 &&
+      right_most_leaf_.load(std::memory_order_relaxed) != hint) {
+    right_most_leaf_.store(hint, std::memory_order_relaxed);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ResetHints() {
+  right_most_leaf_ = kNoHint;
+  for (auto &slot : prefix_leaves_) {
+    slot = kNoHint;
   }
 }
 
@@ -180,57 +441,101 @@ void BPLUSTREE_TYPE::GetAllValue(const KeyType &key, vector<ValueType> *result)
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool {
+  auto normalized_key = Normalizer::Normalize(key);
+  {
+    // optimistic pass: only the leaf is write-latched, which is enough unless the leaf is full. Appends usually find
+    // their leaf from a hint without a descent.
+    int root_page_id;
+    auto leaf_guard = FindLeafByHint(key, normalized_key);
+    if (!leaf_guard.has_value()) {
+      leaf_guard = FindLeafOptimistic(normalized_key, &root_page_id);
+    }
+    if (leaf_guard.has_value()) {
+      // the leaf is only marked dirty once it is about to change
+      auto read_page = leaf_guard->template As<LeafPage>();
+      auto size = read_page->GetSize();
+      int pos = read_page->KeyIndex(normalized_key);
+      if (pos < size && Normalizer::Compare(read_page->KeyAt(pos), normalized_key) == 0) {
+        return false;
+      }
+      if (size < leaf_max_size_) {
+        auto leaf_page = leaf_guard->template AsMut<LeafPage>();
+        leaf_page->ChangeSizeBy(1);
+        for (int i = size - 1; i >= pos; --i) {
+          leaf_page->SetKeyAt(i + 1, leaf_page->KeyAt(i));
+          leaf_page->SetRidAt(i + 1, leaf_page->RidAt(i));
+        }
+        leaf_page->SetKeyAt(pos, normalized_key);
+        leaf_page->SetRidAt(pos, value);
+        RememberLeaf(key, *leaf_guard);
+        ++size_;
+        return true;
+      }
+    }
+  }
+  // a split may change the root or the pages right below it, which are refreshed once the latches are released
+  bool inserted = InsertPessimistic(key, normalized_key, value);
+  RefreshResidentPages();
+  return inserted;
+}
+
+/**
+ * @brief Insert with the latches of the pages that may split, from the header page down to the leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertPessimistic(const KeyType &key, const NormalizedKey &normalized_key, const ValueType &value)
+    -> bool {
   // Declaration of context instance. Using the Context is not necessary but advised.
   Context ctx;
-  ctx.root_page_id_ = GetRootPageId();
+  ctx.header_page_ = bpm_->WritePage(header_page_id_);
+  ctx.root_page_id_ = ctx.header_page_->As<BPlusTreeHeaderPage>()->root_page_id_;
   if (ctx.root_page_id_ == -1) {
     auto root_page_id = bpm_->NewPage();
     auto guard = bpm_->WritePage(root_page_id);
     auto root_page = guard.AsMut<LeafPage>();
     root_page->Init(leaf_max_size_);
     root_page->ChangeSizeBy(1);
-    root_page->SetKeyAt(0, key);
+    root_page->SetKeyAt(0, normalized_key);
     root_page->SetRidAt(0, value);
-    auto head_page = bpm_->WritePage(header_page_id_);
-    head_page.AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
-    ++head_page.AsMut<BPlusTreeHeaderPage>()->size_;
+    auto head_page = ctx.header_page_->AsMut<BPlusTreeHeaderPage>();
+    head_page->root_page_id_ = root_page_id;
+    RememberLeaf(key, guard);
+    ++size_;
     return true;
   }
   ctx.write_set_.emplace_back(bpm_->WritePage(ctx.root_page_id_));
   while (true) {
-    auto it = --ctx.write_set_.end();
+    auto it = &ctx.write_set_.back();
     auto page = it->As<BPlusTreePage>();
     auto size = page->GetSize();
+    if (size < (page->IsLeafPage() ? leaf_max_size_ : internal_max_size_)) {  // this page will not split
+      ReleaseAncestors(&ctx);
+    }
     if (page->IsLeafPage()) {
-      auto leaf_page = it->AsMut<LeafPage>();
-      int pos = size;
-      for (int i = 0; i < size; ++i) {
-        auto res = comparator_(leaf_page->KeyAt(i), key);
-        if (res == 0) {
-          return false;
-        }
-        if (res > 0) {
-          pos = i;
-          break;
-        }
+      auto read_page = it->As<LeafPage>();
+      int pos = read_page->KeyIndex(normalized_key);
+      if (pos < size && Normalizer::Compare(read_page->KeyAt(pos), normalized_key) == 0) {
+        return false;
       }
+      auto leaf_page = it->AsMut<LeafPage>();
       if (size < leaf_max_size_) {
         leaf_page->ChangeSizeBy(1);
         for (int i = size - 1; i >= pos; --i) {
           leaf_page->SetKeyAt(i + 1, leaf_page->KeyAt(i));
           leaf_page->SetRidAt(i + 1, leaf_page->RidAt(i));
         }
-        leaf_page->SetKeyAt(pos, key);
+        leaf_page->SetKeyAt(pos, normalized_key);
         leaf_page->SetRidAt(pos, value);
+        RememberLeaf(key, *it);
       } else {
         // split the leaf node
-        vector<KeyType> leaf_key(leaf_max_size_ + 1);
+        vector<NormalizedKey> leaf_key(leaf_max_size_ + 1);
         vector<ValueType> leaf_rid(leaf_max_size_ + 1);
         for (int i = 0; i < pos; ++i) {
           leaf_key[i] = leaf_page->KeyAt(i);
           leaf_rid[i] = leaf_page->RidAt(i);
         }
-        leaf_key[pos] = key;
+        leaf_key[pos] = normalized_key;
         leaf_rid[pos] = value;
         for (int i = pos; i < leaf_max_size_; ++i) {
           leaf_key[i + 1] = leaf_page->KeyAt(i);
@@ -240,7 +545,13 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
         auto new_leaf_guard = bpm_->WritePage(new_leaf_id);
         auto new_leaf_page = new_leaf_guard.AsMut<LeafPage>();
         new_leaf_page->Init(leaf_max_size_);
-        auto new_size = (leaf_max_size_ + 1) / 2;
+        // more keys will follow an append to the right-most leaf or to the end of its prefix, so the leaf keeps most
+        // of its entries and the pages behind the appends stay nearly full
+        bool append = pos == size &&
+                      (leaf_page->GetNextPageId() == -1 ||
+                       rough_comparator_(Normalizer::Denormalize(leaf_page->KeyAt(size - 1)), key) == 0);
+        auto new_size = append ? leaf_max_size_ + 1 - (leaf_max_size_ + 1) * APPEND_SPLIT_PERCENT / 100
+                               : (leaf_max_size_ + 1) / 2;
         auto remain_size = leaf_max_size_ + 1 - new_size;
         new_leaf_page->SetSize(new_size);
         for (int i = 0; i < new_size; ++i) {
@@ -255,6 +566,7 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
           leaf_page->SetRidAt(i, leaf_rid[i]);
         }
         leaf_page->SetNextPageId(new_leaf_id);
+        RememberLeaf(key, pos < remain_size ? *it : new_leaf_guard);
 
         // try to insert a new node into the chain to the root
         auto new_page_id = new_leaf_id;
@@ -262,7 +574,7 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
         bool flag = false;
         ctx.write_set_.pop_back();
         while (!ctx.write_set_.empty()) {
-          auto cur_page = (--ctx.write_set_.end())->AsMut<InternalPage>();
+          auto cur_page = ctx.write_set_.back().AsMut<InternalPage>();
           auto cur_size = cur_page->GetSize();
           int cur_pos = ctx.which_son_.back();
           if (cur_size < internal_max_size_) {  // stop split
@@ -277,7 +589,7 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
             break;
           }
 
-          vector<KeyType> cur_key_vec(internal_max_size_ + 1);
+          vector<NormalizedKey> cur_key_vec(internal_max_size_ + 1);
           vector<int> cur_page_vec(internal_max_size_ + 1, 0);
           for (int i = 0; i <= cur_pos; ++i) {
             cur_key_vec[i] = cur_page->KeyAt(i);
@@ -294,7 +606,11 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
           auto split_guard = bpm_->WritePage(split_id);
           auto split_page = split_guard.AsMut<InternalPage>();
           split_page->Init(internal_max_size_);
-          new_size = (internal_max_size_ + 1) / 2;
+          // the new child is the last one after an append, and an internal page needs two children
+          append = append && cur_pos + 1 == cur_size;
+          new_size = append ? std::max(2, internal_max_size_ + 1 -
+                                              (internal_max_size_ + 1) * APPEND_SPLIT_PERCENT / 100)
+                            : (internal_max_size_ + 1) / 2;
           remain_size = internal_max_size_ + 1 - new_size;
           split_page->SetSize(new_size);
           for (int i = 0; i < new_size; ++i) {
@@ -322,21 +638,14 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
           new_root_page->SetValueAt(0, ctx.root_page_id_);
           new_root_page->SetKeyAt(1, new_key);
           new_root_page->SetValueAt(1, new_page_id);
-          bpm_->WritePage(header_page_id_).AsMut<BPlusTreeHeaderPage>()->root_page_id_ = new_root_id;
+          ctx.header_page_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = new_root_id;
         }
       }
-      ++bpm_->WritePage(header_page_id_).AsMut<BPlusTreeHeaderPage>()->size_;
+      ++size_;
       return true;
     }
     auto internal_page = it->As<InternalPage>();
-    int pos = size;
-    for (int i = 1; i < size; ++i) {
-      if (comparator_(key, internal_page->KeyAt(i)) < 0) {
-        pos = i;
-        break;
-      }
-    }
-    --pos;
+    int pos = internal_page->ChildIndex(normalized_key);
     ctx.which_son_.push_back(pos);
     ctx.write_set_.emplace_back(bpm_->WritePage(internal_page->ValueAt(pos)));
   }
@@ -356,50 +665,83 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key) {
+  auto normalized_key = Normalizer::Normalize(key);
+  {
+    // optimistic pass: only the leaf is write-latched, which is enough unless the leaf underflows
+    int root_page_id;
+    auto leaf_guard = FindLeafOptimistic(normalized_key, &root_page_id);
+    if (!leaf_guard.has_value()) {
+      return;
+    }
+    auto read_page = leaf_guard->template As<LeafPage>();
+    auto size = read_page->GetSize();
+    int pos = read_page->KeyIndex(normalized_key);
+    if (pos == size || Normalizer::Compare(read_page->KeyAt(pos), normalized_key) != 0) {
+      return;
+    }
+    if (size > (leaf_guard->GetPageId() == root_page_id ? 1 : read_page->GetMinSize())) {
+      auto leaf_page = leaf_guard->template AsMut<LeafPage>();
+      for (int i = pos + 1; i < size; ++i) {
+        leaf_page->SetKeyAt(i - 1, leaf_page->KeyAt(i));
+        leaf_page->SetRidAt(i - 1, leaf_page->RidAt(i));
+      }
+      leaf_page->ChangeSizeBy(-1);
+      return;
+    }
+  }
+  // a merge may change the root or the pages right below it, which are refreshed once the latches are released
+  RemovePessimistic(normalized_key);
+  RefreshResidentPages();
+}
+
+/**
+ * @brief Remove with the latches of the pages that may underflow, from the header page down to the leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemovePessimistic(const NormalizedKey &normalized_key) {
   // Declaration of context instance.
   Context ctx;
-  ctx.root_page_id_ = GetRootPageId();
+  ctx.header_page_ = bpm_->WritePage(header_page_id_);
+  ctx.root_page_id_ = ctx.header_page_->As<BPlusTreeHeaderPage>()->root_page_id_;
   if (ctx.root_page_id_ == -1) {
     return;
   }
   auto guard = bpm_->WritePage(ctx.root_page_id_);
   if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto size = guard.As<LeafPage>()->GetSize();
+    int pos = guard.As<LeafPage>()->KeyIndex(normalized_key);
+    if (pos == size || Normalizer::Compare(guard.As<LeafPage>()->KeyAt(pos), normalized_key) != 0) {
+      return;
+    }
     auto root_page = guard.AsMut<LeafPage>();
-    auto size = root_page->GetSize();
-    for (int i = 0; i < size; ++i) {
-      if (comparator_(root_page->KeyAt(i), key) == 0) {
-        for (int j = i + 1; j < size; ++j) {
-          root_page->SetKeyAt(j - 1, root_page->KeyAt(j));
-          root_page->SetRidAt(j - 1, root_page->RidAt(j));
-        }
-        root_page->ChangeSizeBy(-1);
-        if (root_page->GetSize() == 0) {
-          guard.Drop();
-          bpm_->DeletePage(ctx.root_page_id_);
-          bpm_->WritePage(header_page_id_).AsMut<BPlusTreeHeaderPage>()->root_page_id_ = -1;
-        }
-        return;
-      }
+    for (int i = pos + 1; i < size; ++i) {
+      root_page->SetKeyAt(i - 1, root_page->KeyAt(i));
+      root_page->SetRidAt(i - 1, root_page->RidAt(i));
+    }
+    root_page->ChangeSizeBy(-1);
+    if (root_page->GetSize() == 0) {
+      leaf_delete_cnt_.fetch_add(1, std::memory_order_relaxed);
+      guard.Drop();
+      bpm_->DeletePage(ctx.root_page_id_);
+      ctx.header_page_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = -1;
     }
     return;
   }
   ctx.write_set_.emplace_back(std::move(guard));
   while (true) {
-    auto it = --ctx.write_set_.end();
+    auto it = &ctx.write_set_.back();
     auto page = it->As<BPlusTreePage>();
     auto size = page->GetSize();
+    if (size > (ctx.IsRootPage(it->GetPageId()) ? 2 : page->GetMinSize())) {  // this page will not underflow
+      ReleaseAncestors(&ctx);
+    }
     if (page->IsLeafPage()) {
-      auto leaf_page = it->AsMut<LeafPage>();
-      int pos = -1;
-      for (int i = 0; i < size; ++i) {
-        if (comparator_(leaf_page->KeyAt(i), key) == 0) {
-          pos = i;
-          break;
-        }
-      }
-      if (pos == -1) {
+      auto read_page = it->As<LeafPage>();
+      int pos = read_page->KeyIndex(normalized_key);
+      if (pos == size || Normalizer::Compare(read_page->KeyAt(pos), normalized_key) != 0) {
         return;
       }
+      auto leaf_page = it->AsMut<LeafPage>();
       if (size > leaf_page->GetMinSize()) {
         for (int i = pos + 1; i < size; ++i) {
           leaf_page->SetKeyAt(i - 1, leaf_page->KeyAt(i));
@@ -408,12 +750,12 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
         leaf_page->ChangeSizeBy(-1);
         return;
       }
-      auto fa_page = (--(--ctx.write_set_.end()))->AsMut<InternalPage>();
+      auto fa_page = ctx.write_set_[ctx.write_set_.size() - 2].AsMut<InternalPage>();
+      // the leaf stays latched, so that no append through a hint slips in between the read of its size and the merge
+      auto leaf_guard = std::move(ctx.write_set_.back());
       ctx.write_set_.pop_back();
-      auto son_id = *--ctx.which_son_.end();
-      auto leaf_guard = bpm_->WritePage(fa_page->ValueAt(son_id));
-      leaf_page = leaf_guard.template AsMut<LeafPage>();
-      vector<KeyType> leaf_key(leaf_max_size_ * 2);
+      auto son_id = ctx.which_son_.back();
+      vector<NormalizedKey> leaf_key(leaf_max_size_ * 2);
       vector<ValueType> leaf_rid(leaf_max_size_ * 2);
       if (son_id >= 1) {
         auto sibling_guard = bpm_->WritePage(fa_page->ValueAt(son_id - 1));
@@ -454,6 +796,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
           sibling_page->SetRidAt(i, leaf_rid[i]);
         }
         sibling_page->SetNextPageId(leaf_page->GetNextPageId());
+        leaf_delete_cnt_.fetch_add(1, std::memory_order_relaxed);
         --son_id;
       } else {
         auto sibling_guard = bpm_->WritePage(fa_page->ValueAt(son_id + 1));
@@ -494,17 +837,19 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
           leaf_page->SetRidAt(i, leaf_rid[i]);
         }
         leaf_page->SetNextPageId(sibling_page->GetNextPageId());
+        leaf_delete_cnt_.fetch_add(1, std::memory_order_relaxed);
       }
       // merge page
+      leaf_guard.Drop();
       bpm_->DeletePage(fa_page->ValueAt(son_id + 1));
       auto remove_pos = son_id + 1;
       ctx.which_son_.pop_back();
       while (true) {
-        if (ctx.write_set_.size() == 1) {
-          auto root_page = ctx.write_set_.begin()->AsMut<InternalPage>();
+        if (ctx.write_set_.size() == 1 && ctx.IsRootPage(ctx.write_set_.front().GetPageId())) {
+          auto root_page = ctx.write_set_.front().AsMut<InternalPage>();
           auto root_size = root_page->GetSize();
           if (root_size == 2) {
-            bpm_->WritePage(header_page_id_).AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page->ValueAt(0);
+            ctx.header_page_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page->ValueAt(0);
             bpm_->DeletePage(ctx.root_page_id_);
           } else {
             for (int i = remove_pos + 1; i < root_size; ++i) {
@@ -515,9 +860,8 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
           }
           return;
         }
-        auto cur_page = (--ctx.write_set_.end())->AsMut<InternalPage>();
+        auto cur_page = ctx.write_set_.back().AsMut<InternalPage>();
         auto cur_size = cur_page->GetSize();
-        auto cur_pos = *--ctx.which_son_.end();
         if (cur_size > cur_page->GetMinSize()) {
           for (int i = remove_pos + 1; i < cur_size; ++i) {
             cur_page->SetKeyAt(i - 1, cur_page->KeyAt(i));
@@ -526,8 +870,9 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
           cur_page->ChangeSizeBy(-1);
           return;
         }
-        fa_page = (--(--ctx.write_set_.end()))->AsMut<InternalPage>();
-        vector<KeyType> internal_key_vec(internal_max_size_ * 2);
+        auto cur_pos = ctx.which_son_.back();
+        fa_page = ctx.write_set_[ctx.write_set_.size() - 2].AsMut<InternalPage>();
+        vector<NormalizedKey> internal_key_vec(internal_max_size_ * 2);
         vector<int> internal_page_vec(internal_max_size_ * 2, 0);
         if (cur_pos >= 1) {
           auto sibling_guard = bpm_->WritePage(fa_page->ValueAt(cur_pos - 1));
@@ -614,50 +959,108 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key) {
       }
     }
     auto internal_page = it->As<InternalPage>();
-    int pos = size;
-    for (int i = 1; i < size; ++i) {
-      if (comparator_(key, internal_page->KeyAt(i)) < 0) {
-        pos = i;
-        break;
-      }
-    }
-    --pos;
+    int pos = internal_page->ChildIndex(normalized_key);
     ctx.which_son_.push_back(pos);
     ctx.write_set_.emplace_back(bpm_->WritePage(internal_page->ValueAt(pos)));
   }
 }
 
+/**
+ * @brief Release the header page and every write-latched ancestor of the last page in `ctx->write_set_`.
+ *
+ * Called once a page is known to be safe, i.e. the current operation cannot split or merge it, so no page above it
+ * will be modified.
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::GetAll(vector<ValueType> *result) {
-  Context ctx;
-  ctx.root_page_id_ = GetRootPageId();
-  if (ctx.root_page_id_ == -1) {
-    return;
+void BPLUSTREE_TYPE::ReleaseAncestors(Context *ctx) {
+  ctx->header_page_.reset();
+  while (ctx->write_set_.size() > 1) {
+    ctx->write_set_.pop_front();
+    ctx->which_son_.pop_front();
   }
-  ctx.read_set_.emplace_back(bpm_->ReadPage(ctx.root_page_id_));
-  while (true) {
-    auto it = --ctx.read_set_.end();
-    auto page = it->As<BPlusTreePage>();
-    auto size = page->GetSize();
-    if (page->IsLeafPage()) {
-      auto leaf_page = it->As<LeafPage>();
-      while (true) {
-        for (int i = 0; i < size; ++i) {
-          result->push_back(leaf_page->RidAt(i));
-        }
-        if (leaf_page->GetNextPageId() == -1) {
-          return;
-        }
-        ctx.read_set_.pop_back();
-        ctx.read_set_.emplace_back(bpm_->ReadPage(leaf_page->GetNextPageId()));
-        it = --ctx.read_set_.end();
-        leaf_page = it->As<LeafPage>();
-        size = leaf_page->GetSize();
+}
+
+/**
+ * @brief Check the structural invariants of the tree.
+ *
+ * Keys are strictly increasing inside every page and lie in the range given by the parent, every page is non-empty
+ * and within its max size, all leaves are on the same level, and the leaf chain visits the leaves in key order.
+ * Keys are compared by the comparator, so this also checks the order of the normalized keys that pages search.
+ * Not thread-safe: only call it while no other operation is running.
+ *
+ * @return true if every invariant holds
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CheckIntegrity() -> bool {
+  auto root_page_id = GetRootPageId();
+  if (root_page_id == -1) {
+    return true;
+  }
+  int leaf_depth = -1;
+  vector<int> leaves;
+  if (!CheckSubtree(root_page_id, nullptr, nullptr, 0, &leaf_depth, &leaves)) {
+    return false;
+  }
+  for (size_t i = 0; i < leaves.size(); ++i) {
+    auto next_page_id = bpm_->ReadPage(leaves[i]).As<LeafPage>()->GetNextPageId();
+    if (next_page_id != (i + 1 == leaves.size() ? -1 : leaves[i + 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CheckSubtree(int page_id, const KeyType *lower, const KeyType *upper, int depth,
+                                  int *leaf_depth, vector<int> *leaves) -> bool {
+  auto guard = bpm_->ReadPage(page_id);
+  auto page = guard.As<BPlusTreePage>();
+  auto size = page->GetSize();
+  if (size < 1 || size > page->GetMaxSize()) {
+    return false;
+  }
+  if (page->IsLeafPage()) {
+    if (*leaf_depth != -1 && *leaf_depth != depth) {
+      return false;
+    }
+    *leaf_depth = depth;
+    leaves->push_back(page_id);
+    auto leaf_page = guard.As<LeafPage>();
+    for (int i = 0; i < size; ++i) {
+      auto key = Normalizer::Denormalize(leaf_page->KeyAt(i));
+      if (i > 0 && comparator_(Normalizer::Denormalize(leaf_page->KeyAt(i - 1)), key) >= 0) {
+        return false;
+      }
+      if ((lower != nullptr && comparator_(key, *lower) < 0) || (upper != nullptr && comparator_(key, *upper) >= 0)) {
+        return false;
       }
     }
-    auto internal_page = it->As<InternalPage>();
-    ctx.read_set_.emplace_back(bpm_->ReadPage(internal_page->ValueAt(0)));
+    return true;
+  }
+  auto internal_page = guard.As<InternalPage>();
+  if (size < 2 && page_id == GetRootPageId()) {
+    return false;
+  }
+  vector<KeyType> keys(size);
+  vector<int> children(size);
+  for (int i = 0; i < size; ++i) {
+    keys[i] = Normalizer::Denormalize(internal_page->KeyAt(i));
+    children[i] = internal_page->ValueAt(i);
   }
+  guard.Drop();
+  for (int i = 1; i < size; ++i) {
+    if ((i > 1 && comparator_(keys[i - 1], keys[i]) >= 0) || (lower != nullptr && comparator_(keys[i], *lower) < 0) ||
+        (upper != nullptr && comparator_(keys[i], *upper) >= 0)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < size; ++i) {
+    if (!CheckSubtree(children[i], i == 0 ? lower : &keys[i], i + 1 == size ? upper : &keys[i + 1], depth + 1,
+                      leaf_depth, leaves)) {
+      return false;
+    }
+  }
+  return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -669,6 +1072,12 @@ void BPLUSTREE_TYPE::Clean() {
   root_page->root_page_id_ = -1;
   root_page->page_cnt_ = 0;
   root_page->size_ = 0;
+  guard.Drop();
+  size_ = 0;
+  ResetHints();
+  resident_pages_.clear();
+  height_root_page_id_ = -1;
+  RefreshResidentPages();
 }
 
 /**
@@ -681,17 +1090,120 @@ auto BPLUSTREE_TYPE::GetRootPageId() const -> int {
   return bpm_->ReadPage(header_page_id_).As<BPlusTreeHeaderPage>()->root_page_id_;
 }
 
+// The height measured by RefreshResidentPages, 0 for an empty tree
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetHeight() const -> int {
+  return height_;
+}
+
+/**
+ * @brief Bring the resident pages of this tree up to date with its shape. Must be called with no latch held.
+ *
+ * The header page and the root are always kept. The children of the root are kept too if they are internal pages and
+ * the region has room for all of them, so that a lookup in a tree of up to four levels misses at most twice. The root
+ * stays read-latched until the pool is updated, so its children cannot change meanwhile. The height only changes with
+ * the root, so it is measured again on the left-most path when a new root shows up. Once the pool is updated, the
+ * swips of the tree are pointed at the frames of the resident pages.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RefreshResidentPages() {
+  std::scoped_lock latch(resident_latch_);
+  vector<int> page_ids;
+  page_ids.push_back(header_page_id_);
+  auto header_guard = bpm_->ReadPage(header_page_id_);
+  int root_page_id = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  std::optional<ReadPageGuard> root_guard;
+  if (root_page_id == -1) {
+    height_ = 0;
+  } else {
+    root_guard = bpm_->ReadPage(root_page_id);
+    header_guard.Drop();
+    page_ids.push_back(root_page_id);
+    if (root_page_id != height_root_page_id_) {
+      int height = 1;
+      if (!root_guard->As<BPlusTreePage>()->IsLeafPage()) {
+        auto guard = bpm_->ReadPage(root_guard->As<InternalPage>()->ValueAt(0));
+        for (height = 2; !guard.template As<BPlusTreePage>()->IsLeafPage(); ++height) {
+          guard = bpm_->ReadPage(guard.template As<InternalPage>()->ValueAt(0));
+        }
+      }
+      height_ = height;
+      height_root_page_id_ = root_page_id;
+    }
+    if (height_ >= 3) {
+      auto root_page = root_guard->As<InternalPage>();
+      if (page_ids.size() + root_page->GetSize() <= bpm_->ResidentCapacity()) {
+        for (int i = 0; i < root_page->GetSize(); ++i) {
+          page_ids.push_back(root_page->ValueAt(i));
+        }
+      }
+    }
+  }
+  if (page_ids.size() == resident_pages_.size()) {
+    size_t i = 0;
+    while (i < page_ids.size() && page_ids[i] == resident_pages_[i]) {
+      ++i;
+    }
+    if (i == page_ids.size()) {
+      return;
+    }
+  }
+  auto contains = [](const vector<int> &ids, int id) {
+    for (size_t i = 0; i < ids.size(); ++i) {
+      if (ids[i] == id) {
+        return true;
+      }
+    }
+    return false;
+  };
+  // the pages that left the upper levels are released first, so the region has room for the new ones
+  for (size_t i = 0; i < resident_pages_.size(); ++i) {
+    if (!contains(page_ids, resident_pages_[i])) {
+      bpm_->SetResident(resident_pages_[i], false);
+    }
+  }
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    if (!contains(resident_pages_, page_ids[i])) {
+      bpm_->SetResident(page_ids[i], true);
+    }
+  }
+  resident_pages_ = page_ids;
+  // the readers check the page id of a swip, so they never follow one that is stale meanwhile
+  bpm_->Swizzle(header_page_id_, &header_swip_);
+  if (page_ids.size() > 1) {
+    bpm_->Swizzle(page_ids[1], &root_swip_);
+  } else {
+    root_swip_.Clear();
+  }
+  for (int i = 0; i < kChildSwipCnt; ++i) {
+    if (static_cast<size_t>(i) + 2 < page_ids.size()) {
+      bpm_->Swizzle(page_ids[i + 2], &child_swips_[i]);
+    } else {
+      child_swips_[i].Clear();
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::ReadChild(const ReadPageGuard &guard, int root_page_id, int slot) -> ReadPageGuard {
+  int page_id = guard.template As<InternalPage>()->ValueAt(slot);
+  if (guard.GetPageId() == root_page_id && slot < kChildSwipCnt) {
+    return bpm_->ReadPage(page_id, child_swips_[slot]);
+  }
+  return bpm_->ReadPage(page_id);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetSize() const -> int {
-  return bpm_->ReadPage(header_page_id_).As<BPlusTreeHeaderPage>()->size_;
+  return size_;
 }
 
 template class BPlusTree<Key, int, Comparator, RoughComparator>;
-template class BPlusTree<array<char, 20>, User, UserComparator, UserComparator>;
-template class BPlusTree<array<char, 20>, int, TrainComparator, TrainComparator>;
-template class BPlusTree<array<unsigned int, 10>, int, StationComparator, StationComparator>;
+template class BPlusTree<array<char, 20>, Rid, UserComparator, UserComparator, POINT_INDEX_PAGE_SIZE>;
+template class BPlusTree<array<char, 20>, int, TrainComparator, TrainComparator, POINT_INDEX_PAGE_SIZE>;
+template class BPlusTree<array<unsigned int, 10>, int, StationComparator, StationComparator, POINT_INDEX_PAGE_SIZE>;
 template class BPlusTree<StationTrain, TrainStation, StationTrainComparator, StationIDComparator>;
-template class BPlusTree<BuyInfo, Order, BuyInfoComparator, RoughBuyInfoComparator>;
-template class BPlusTree<int, Order, TimeComparator, TimeComparator>;
+template class BPlusTree<BuyInfo, Rid, BuyInfoComparator, RoughBuyInfoComparator, SCAN_INDEX_PAGE_SIZE>;
+template class BPlusTree<int, Rid, TimeComparator, TimeComparator, SCAN_INDEX_PAGE_SIZE>;
 
 }
\ No newline at end of file
@@ -37,7 +37,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size) {
  * @return Key at index
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType { return key_array_[index]; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> NormalizedKey { return key_array_[index]; }
 
 /**
  * @brief Set key at the specified index.
@@ -46,7 +46,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType { return
  * @param key The new value for key
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { key_array_[index] = key; }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const NormalizedKey &key) { key_array_[index] = key; }
 
 /**
  * @brief Helper method to get the value associated with input "index"(a.k.a array
@@ -61,12 +61,19 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> int { return pa
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const int &value) { page_id_array_[index] = value; }
 
+// the first key is invalid, so the child is the one before the first key greater than key
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ChildIndex(const NormalizedKey &key) const -> int {
+  return SearchNormalized<true, Normalizer>(key_array_, 1, GetSize(), key) - 1;
+}
+
 template class BPlusTreeInternalPage<Key, int, Comparator, RoughComparator>;
-template class BPlusTreeInternalPage<array<char, 20>, int, UserComparator, UserComparator>;
-template class BPlusTreeInternalPage<array<char, 20>, int, TrainComparator, TrainComparator>;
-template class BPlusTreeInternalPage<array<unsigned int, 10>, int, StationComparator, StationComparator>;
+template class BPlusTreeInternalPage<array<char, 20>, int, UserComparator, UserComparator, POINT_INDEX_PAGE_SIZE>;
+template class BPlusTreeInternalPage<array<char, 20>, int, TrainComparator, TrainComparator, POINT_INDEX_PAGE_SIZE>;
+template class BPlusTreeInternalPage<array<unsigned int, 10>, int, StationComparator, StationComparator,
+                                     POINT_INDEX_PAGE_SIZE>;
 template class BPlusTreeInternalPage<StationTrain, int, StationTrainComparator, StationIDComparator>;
-template class BPlusTreeInternalPage<BuyInfo, int, BuyInfoComparator, RoughBuyInfoComparator>;
-template class BPlusTreeInternalPage<int, int, TimeComparator, TimeComparator>;
+template class BPlusTreeInternalPage<BuyInfo, int, BuyInfoComparator, RoughBuyInfoComparator, SCAN_INDEX_PAGE_SIZE>;
+template class BPlusTreeInternalPage<int, int, TimeComparator, TimeComparator, SCAN_INDEX_PAGE_SIZE>;
 
 }
@@ -6,6 +6,7 @@
 #include "system/user_system/user.h"
 #include "system/train_system/train.h"
 #include "system/ticket_system/ticket.h"
+#include "heap_file/heap_file.h"
 
 namespace sjtu {
 
@@ -44,23 +45,29 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(int next_page_id) { next_page_id_
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType { return key_array_[index]; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> NormalizedKey { return key_array_[index]; }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::RidAt(int index) const -> ValueType { return rid_array_[index]; }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { key_array_[index] = key; }
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetKeyAt(int index, const NormalizedKey &key) { key_array_[index] = key; }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::SetRidAt(int index, const ValueType &rid) { rid_array_[index] = rid; }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const NormalizedKey &key) const -> int {
+  return SearchNormalized<false, Normalizer>(key_array_, 0, GetSize(), key);
+}
+
 template class BPlusTreeLeafPage<Key, int, Comparator, RoughComparator>;
-template class BPlusTreeLeafPage<array<char, 20>, User, UserComparator, UserComparator>;
-template class BPlusTreeLeafPage<array<char, 20>, int, TrainComparator, TrainComparator>;
-template class BPlusTreeLeafPage<array<unsigned int, 10>, int, StationComparator, StationComparator>;
+template class BPlusTreeLeafPage<array<char, 20>, Rid, UserComparator, UserComparator, POINT_INDEX_PAGE_SIZE>;
+template class BPlusTreeLeafPage<array<char, 20>, int, TrainComparator, TrainComparator, POINT_INDEX_PAGE_SIZE>;
+template class BPlusTreeLeafPage<array<unsigned int, 10>, int, StationComparator, StationComparator,
+                                 POINT_INDEX_PAGE_SIZE>;
 template class BPlusTreeLeafPage<StationTrain, TrainStation, StationTrainComparator, StationIDComparator>;
-template class BPlusTreeLeafPage<BuyInfo, Order, BuyInfoComparator, RoughBuyInfoComparator>;
-template class BPlusTreeLeafPage<int, Order, TimeComparator, TimeComparator>;
+template class BPlusTreeLeafPage<BuyInfo, Rid, BuyInfoComparator, RoughBuyInfoComparator, SCAN_INDEX_PAGE_SIZE>;
+template class BPlusTreeLeafPage<int, Rid, TimeComparator, TimeComparator, SCAN_INDEX_PAGE_SIZE>;
 
 }
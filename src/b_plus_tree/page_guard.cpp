@@ -1,31 +1,20 @@
 #include "b_plus_tree/page_guard.h"
-#include <memory>
 
 namespace sjtu {
 
 /**
  * @brief The only constructor for an RAII `ReadPageGuard` that creates a valid guard.
  *
- * Note that only the buffer pool manager is allowed to call this constructor.
- *
+ * Note that only the buffer pool manager is allowed to call this constructor. The buffer pool manager pins the frame
+ * while holding its own latch, so the guard only has to take the frame's latch in shared mode.
  *
  * @param page_id The page ID of the page we want to read.
- * @param frame A shared pointer to the frame that holds the page we want to protect.
- * @param replacer A shared pointer to the buffer pool manager's replacer.
- * @param bpm_latch A shared pointer to the buffer pool manager's latch.
- * @param disk_scheduler A shared pointer to the buffer pool manager's disk scheduler.
+ * @param frame The frame that holds the page we want to protect, already pinned.
+ * @param bpm The buffer pool manager that owns the frame.
  */
-ReadPageGuard::ReadPageGuard(int page_id, std::shared_ptr<FrameHeader> frame,
-                             std::shared_ptr<LRUKReplacer> replacer,
-                             std::shared_ptr<DiskManager> disk_manager)
-    : page_id_(page_id),
-      frame_(std::move(frame)),
-      replacer_(std::move(replacer)),
-      disk_manager_(std::move(disk_manager)) {
-  ++frame_->pin_count_;
-  if (frame_->pin_count_ == 1) {
-    replacer_->SetEvictable(frame_->frame_id_, false);
-  }
+ReadPageGuard::ReadPageGuard(int page_id, FrameHeader *frame, BufferPoolManager *bpm)
+    : page_id_(page_id), frame_(frame), bpm_(bpm) {
+  frame_->rwlatch_.lock_shared();
   is_valid_ = true;
 }
 
@@ -38,7 +27,7 @@ ReadPageGuard::ReadPageGuard(int page_id, std::shared_ptr<FrameHeader> frame,
  * great resources (including articles, Microsoft tutorials, YouTube videos) that explain this in depth.
  *
  * Make sure you invalidate the other guard, otherwise you might run into double free problems! For both objects, you
- * need to update _at least_ 5 fields each.
+ * need to update _at least_ 3 fields each.
  *
  * TODO(P1): Add implementation.
  *
@@ -50,13 +39,8 @@ ReadPageGuard::ReadPageGuard(ReadPageGuard &&that) noexcept {
     return;
   }
   page_id_ = that.page_id_;
-
   frame_ = that.frame_;
-  that.frame_.reset();
-  replacer_ = that.replacer_;
-  that.replacer_.reset();
-  disk_manager_ = that.disk_manager_;
-  that.disk_manager_.reset();
+  bpm_ = that.bpm_;
 
   is_valid_ = true;
   that.is_valid_ = false;
@@ -71,7 +55,7 @@ ReadPageGuard::ReadPageGuard(ReadPageGuard &&that) noexcept {
  * great resources (including articles, Microsoft tutorials, YouTube videos) that explain this in depth.
  *
  * Make sure you invalidate the other guard, otherwise you might run into double free problems! For both objects, you
- * need to update _at least_ 5 fields each, and for the current object, make sure you release any resources it might be
+ * need to update _at least_ 3 fields each, and for the current object, make sure you release any resources it might be
  * holding on to.
  *
  * @param that The other page guard.
@@ -87,13 +71,8 @@ auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &
     return *this;
   }
   page_id_ = that.page_id_;
-
   frame_ = that.frame_;
-  that.frame_.reset();
-  replacer_ = that.replacer_;
-  that.replacer_.reset();
-  disk_manager_ = that.disk_manager_;
-  that.disk_manager_.reset();
+  bpm_ = that.bpm_;
 
   is_valid_ = true;
   that.is_valid_ = false;
@@ -134,10 +113,8 @@ auto ReadPageGuard::IsDirty() const -> bool {
  */
 void ReadPageGuard::Drop() {
   if (is_valid_) {
-    --frame_->pin_count_;
-    if (frame_->pin_count_ == 0U) {
-      replacer_->SetEvictable(frame_->frame_id_, true);
-    }
+    frame_->rwlatch_.unlock_shared();
+    bpm_->UnpinFrame(frame_);
     is_valid_ = false;
   }
 }
@@ -152,26 +129,16 @@ ReadPageGuard::~ReadPageGuard() { Drop(); }
 /**
  * @brief The only constructor for an RAII `WritePageGuard` that creates a valid guard.
  *
- * Note that only the buffer pool manager is allowed to call this constructor.
+ * Note that only the buffer pool manager is allowed to call this constructor. The buffer pool manager pins the frame
+ * while holding its own latch, so the guard only has to take the frame's latch in exclusive mode.
  *
  * @param page_id The page ID of the page we want to write to.
- * @param frame A shared pointer to the frame that holds the page we want to protect.
- * @param replacer A shared pointer to the buffer pool manager's replacer.
- * @param bpm_latch A shared pointer to the buffer pool manager's latch.
- * @param disk_scheduler A shared pointer to the buffer pool manager's disk scheduler.
+ * @param frame The frame that holds the page we want to protect, already pinned.
+ * @param bpm The buffer pool manager that owns the frame.
  */
-WritePageGuard::WritePageGuard(int page_id, std::shared_ptr<FrameHeader> frame,
-                               std::shared_ptr<LRUKReplacer> replacer,
-                               std::shared_ptr<DiskManager> disk_manager)
-    : page_id_(page_id),
-      frame_(std::move(frame)),
-      replacer_(std::move(replacer)),
-      disk_manager_(std::move(disk_manager)) {
-  ++frame_->pin_count_;
-  if (frame_->pin_count_ == 1) {
-    replacer_->SetEvictable(frame_->frame_id_, false);
-  }
-  frame_->is_dirty_ = true;
+WritePageGuard::WritePageGuard(int page_id, FrameHeader *frame, BufferPoolManager *bpm)
+    : page_id_(page_id), frame_(frame), bpm_(bpm) {
+  frame_->rwlatch_.lock();
   is_valid_ = true;
 }
 
@@ -184,7 +151,7 @@ WritePageGuard::WritePageGuard(int page_id, std::shared_ptr<FrameHeader> frame,
  * great resources (including articles, Microsoft tutorials, YouTube videos) that explain this in depth.
  *
  * Make sure you invalidate the other guard, otherwise you might run into double free problems! For both objects, you
- * need to update _at least_ 5 fields each.
+ * need to update _at least_ 3 fields each.
  *
  *
  * @param that The other page guard.
@@ -195,13 +162,8 @@ WritePageGuard::WritePageGuard(WritePageGuard &&that) noexcept {
     return;
   }
   page_id_ = that.page_id_;
-
   frame_ = that.frame_;
-  that.frame_.reset();
-  replacer_ = that.replacer_;
-  that.replacer_.reset();
-  disk_manager_ = that.disk_manager_;
-  that.disk_manager_.reset();
+  bpm_ = that.bpm_;
 
   is_valid_ = true;
   that.is_valid_ = false;
@@ -216,7 +178,7 @@ WritePageGuard::WritePageGuard(WritePageGuard &&that) noexcept {
  * great resources (including articles, Microsoft tutorials, YouTube videos) that explain this in depth.
  *
  * Make sure you invalidate the other guard, otherwise you might run into double free problems! For both objects, you
- * need to update _at least_ 5 fields each, and for the current object, make sure you release any resources it might be
+ * need to update _at least_ 3 fields each, and for the current object, make sure you release any resources it might be
  * holding on to.
  *
  *
@@ -233,13 +195,8 @@ auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard
     return *this;
   }
   page_id_ = that.page_id_;
-
   frame_ = that.frame_;
-  that.frame_.reset();
-  replacer_ = that.replacer_;
-  that.replacer_.reset();
-  disk_manager_ = that.disk_manager_;
-  that.disk_manager_.reset();
+  bpm_ = that.bpm_;
 
   is_valid_ = true;
   that.is_valid_ = false;
@@ -261,9 +218,13 @@ auto WritePageGuard::GetData() const -> const char * {
 }
 
 /**
- * @brief Gets a mutable pointer to the page of data this guard is protecting.
+ * @brief Gets a mutable pointer to the page of data this guard is protecting, and marks the page dirty.
+ *
+ * Only this marks the page dirty, so a write guard that ends up only reading (a duplicate key, a latch held just in
+ * case of a split) does not cause a write-back.
  */
 auto WritePageGuard::GetDataMut() -> char * {
+  frame_->is_dirty_ = true;
   return frame_->GetDataMut();
 }
 
@@ -286,10 +247,8 @@ auto WritePageGuard::IsDirty() const -> bool {
  */
 void WritePageGuard::Drop() {
   if (is_valid_) {
-    --frame_->pin_count_;
-    if (frame_->pin_count_ == 0U) {
-      replacer_->SetEvictable(frame_->frame_id_, true);
-    }
+    frame_->rwlatch_.unlock();
+    bpm_->UnpinFrame(frame_);
     is_valid_ = false;
   }
 }
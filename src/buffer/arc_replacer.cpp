@@ -0,0 +1,140 @@
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+namespace sjtu {
+
+ArcReplacer::ArcReplacer(size_t num_frames)
+    : num_frames_(num_frames),
+      recent_(num_frames),
+      frequent_(num_frames),
+      page_ids_(num_frames, -1),
+      evictable_(num_frames, false) {}
+
+void ArcReplacer::Clean() {
+  target_ = 0;
+  recent_.Clear();
+  frequent_.Clear();
+  recent_ghosts_.Clear();
+  frequent_ghosts_.Clear();
+  for (size_t i = 0; i < num_frames_; ++i) {
+    evictable_[i] = false;
+  }
+  evictable_size_ = 0;
+}
+
+auto ArcReplacer::FindVictim(const FrameList &frames) const -> int {
+  int frame_id = frames.Back();
+  while (frame_id != -1 && !evictable_[frame_id]) {
+    frame_id = frames.Prev(frame_id);
+  }
+  return frame_id;
+}
+
+void ArcReplacer::TrimGhosts() {
+  while (recent_.Size() + recent_ghosts_.Size() > num_frames_ && recent_ghosts_.Size() > 0) {
+    recent_ghosts_.PopBack();
+  }
+  while (recent_.Size() + frequent_.Size() + recent_ghosts_.Size() + frequent_ghosts_.Size() > 2 * num_frames_) {
+    if (frequent_ghosts_.Size() > 0) {
+      frequent_ghosts_.PopBack();
+    } else {
+      recent_ghosts_.PopBack();
+    }
+  }
+}
+
+/**
+ * @brief Evict the least recent evictable frame of T1 if T1 is larger than its target, and of T2 otherwise. The other
+ * list is used if the chosen one has no evictable frame. The page of the victim is remembered in B1 or B2.
+ */
+auto ArcReplacer::Evict() -> std::optional<int> {
+  bool from_recent = recent_.Size() > 0 && recent_.Size() > target_;
+  int frame_id = FindVictim(from_recent ? recent_ : frequent_);
+  if (frame_id == -1) {
+    from_recent = !from_recent;
+    frame_id = FindVictim(from_recent ? recent_ : frequent_);
+    if (frame_id == -1) {
+      return std::nullopt;
+    }
+  }
+  if (from_recent) {
+    recent_.Erase(frame_id);
+    recent_ghosts_.PushFront(page_ids_[frame_id]);
+  } else {
+    frequent_.Erase(frame_id);
+    frequent_ghosts_.PushFront(page_ids_[frame_id]);
+  }
+  TrimGhosts();
+  evictable_[frame_id] = false;
+  --evictable_size_;
+  return frame_id;
+}
+
+/**
+ * @brief A hit moves the frame to the front of T2. A loaded page enters T2 if it is remembered in B1 or B2, which
+ * adapts the target size of T1 by the ratio of the ghost lists, and T1 otherwise. A page loaded by a scan enters T1 as
+ * its least recent page and is forgotten by B1 and B2 without adapting the target.
+ */
+void ArcReplacer::RecordAccess(int frame_id, int page_id, AccessType access_type) {
+  if (access_type == AccessType::Scan) {
+    if (!recent_.Contains(frame_id) && !frequent_.Contains(frame_id)) {
+      page_ids_[frame_id] = page_id;
+      recent_ghosts_.Erase(page_id);
+      frequent_ghosts_.Erase(page_id);
+      recent_.PushBack(frame_id);
+      TrimGhosts();
+    }
+    return;
+  }
+  if (recent_.Contains(frame_id) || frequent_.Contains(frame_id)) {
+    (recent_.Contains(frame_id) ? recent_ : frequent_).Erase(frame_id);
+    frequent_.PushFront(frame_id);
+    return;
+  }
+  page_ids_[frame_id] = page_id;
+  size_t recent_ghost_cnt = recent_ghosts_.Size();
+  size_t frequent_ghost_cnt = frequent_ghosts_.Size();
+  if (recent_ghosts_.Erase(page_id)) {
+    target_ = std::min(num_frames_, target_ + std::max<size_t>(frequent_ghost_cnt / recent_ghost_cnt, 1));
+    frequent_.PushFront(frame_id);
+  } else if (frequent_ghosts_.Erase(page_id)) {
+    size_t delta = std::max<size_t>(recent_ghost_cnt / frequent_ghost_cnt, 1);
+    target_ = target_ > delta ? target_ - delta : 0;
+    frequent_.PushFront(frame_id);
+  } else {
+    recent_.PushFront(frame_id);
+    TrimGhosts();
+  }
+}
+
+void ArcReplacer::SetEvictable(int frame_id, bool set_evictable) {
+  if ((!recent_.Contains(frame_id) && !frequent_.Contains(frame_id)) || evictable_[frame_id] == set_evictable) {
+    return;
+  }
+  evictable_[frame_id] = set_evictable;
+  if (set_evictable) {
+    ++evictable_size_;
+  } else {
+    --evictable_size_;
+  }
+}
+
+void ArcReplacer::Remove(int frame_id) {
+  FrameList *frames = recent_.Contains(frame_id) ? &recent_ : frequent_.Contains(frame_id) ? &frequent_ : nullptr;
+  if (frames == nullptr) {
+    return;
+  }
+  if (!evictable_[frame_id]) {
+    throw std::exception();
+  }
+  frames->Erase(frame_id);
+  evictable_[frame_id] = false;
+  --evictable_size_;
+}
+
+auto ArcReplacer::Size() -> size_t {
+  return evictable_size_;
+}
+
+}
@@ -1,5 +1,8 @@
 #include "buffer/buffer_pool_manager.h"
 #include "config.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 namespace sjtu {
@@ -10,10 +13,13 @@ namespace sjtu {
  * See the documentation for `FrameHeader` in "buffer/buffer_pool_manager.h" for more information.
  *
  * @param frame_id The frame ID / index of the frame we are creating a header for.
+ * @param data The memory of the frame.
+ * @param size The size of the frame.
  */
-FrameHeader::FrameHeader(int frame_id, int page_id)
-    : frame_id_(frame_id), data_(BUSTUB_PAGE_SIZE, 0), page_id_(page_id) {
+FrameHeader::FrameHeader(int frame_id, char *data, size_t size, int page_id)
+    : frame_id_(frame_id), data_(data), size_(size), page_id_(page_id) {
   Reset();
+  page_id_ = page_id;
 }
 
 /**
@@ -21,22 +27,25 @@ FrameHeader::FrameHeader(int frame_id, int page_id)
  *
  * @return const char* A pointer to immutable data that the frame stores.
  */
-auto FrameHeader::GetData() const -> const char * { return data_.data(); }
+auto FrameHeader::GetData() const -> const char * { return data_; }
 
 /**
  * @brief Get a raw mutable pointer to the frame's data.
  *
  * @return char* A pointer to mutable data that the frame stores.
  */
-auto FrameHeader::GetDataMut() -> char * { return data_.data(); }
+auto FrameHeader::GetDataMut() -> char * { return data_; }
 
 /**
  * @brief Resets a `FrameHeader`'s member fields.
  */
 void FrameHeader::Reset() {
-  std::fill(data_.begin(), data_.end(), 0);
+  memset(data_, 0, size_);
   pin_count_ = 0;
   is_dirty_ = false;
+  page_id_ = -1;
+  scan_owned_ = false;
+  resident_ = false;
 }
 
 /**
@@ -57,47 +66,104 @@ void FrameHeader::Reset() {
  * @param num_frames The size of the buffer pool.
  * @param disk_manager The disk manager.
  * @param k_dist The backward k-distance for the LRU-K replacer.
- * @param log_manager The log manager. Please ignore this for P1.
+ * @param dirty_high_water The number of dirty frames above which the flusher writes back, DIRTY_HIGH_WATER_PERCENT of
+ * the frames if 0.
+ * @param replacer_type The replacement policy of the pool.
  */
-BufferPoolManager::BufferPoolManager(size_t num_frames, std::shared_ptr<DiskManager> disk_manager, size_t k_dist)
+BufferPoolManager::BufferPoolManager(size_t num_frames, std::shared_ptr<DiskManager> disk_manager, size_t k_dist,
+                                     size_t dirty_high_water, ReplacerType replacer_type)
     : num_frames_(num_frames),
+      page_size_(disk_manager->GetPageSize()),
       next_page_id_(0),
-      replacer_(std::make_shared<LRUKReplacer>(num_frames, k_dist)),
-      disk_manager_(disk_manager) {
+      arena_(static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, num_frames * page_size_)), &std::free),
+      replacer_(MakeReplacer(replacer_type, num_frames, k_dist)),
+      disk_manager_(disk_manager),
+      disk_scheduler_(std::make_shared<DiskScheduler>(disk_manager)),
+      dirty_high_water_(dirty_high_water != 0 ? dirty_high_water : num_frames * DIRTY_HIGH_WATER_PERCENT / 100) {
   // Initialize the monotonically increasing counter at 0.
   next_page_id_ = 0;
 
   // Initialize all of the frame headers, and fill the free frame list with all possible frame IDs (since all frames are
   // initially free).
   for (size_t i = 0; i < num_frames_; i++) {
-    frames_.push_back(std::make_shared<FrameHeader>(i));
+    frames_.push_back(std::make_shared<FrameHeader>(i, arena_.get() + i * page_size_, page_size_));
     free_frames_.push_back(static_cast<int>(i));
   }
+  flusher_ = std::thread(&BufferPoolManager::FlusherLoop, this);
 }
 
 void BufferPoolManager::Clean() {
+  std::scoped_lock latch(write_back_latch_, bpm_latch_, resident_latch_);
+  ReapReadAhead(true);
   next_page_id_ = 0;
   replacer_->Clean();
   disk_manager_->Clean();
   page_table_.clear();
+  resident_cnt_ = 0;
   free_frames_.clear();
   for (size_t i = 0; i < num_frames_; ++i) {
+    frames_[i]->Reset();
     free_frames_.push_back(static_cast<int>(i));
   }
 }
 
+/**
+ * @brief Take a snapshot of every page, see `DiskManager::CreateSnapshot`.
+ *
+ * The dirty pages are written back first, so the snapshot sees them. No page may be modified meanwhile.
+ */
+auto BufferPoolManager::CreateSnapshot(const std::string &name) -> bool {
+  FlushAllPages();
+  return disk_manager_->CreateSnapshot(name);
+}
+
+/**
+ * @brief Replace every page with the pages of a snapshot, see `DiskManager::SwitchSnapshot`.
+ *
+ * The cached pages belong to the replaced state, so they are dropped without being written back. No page may be
+ * pinned meanwhile.
+ */
+auto BufferPoolManager::SwitchSnapshot(const std::string &name) -> bool {
+  std::scoped_lock latch(write_back_latch_, bpm_latch_, resident_latch_);
+  ReapReadAhead(true);
+  if (!disk_manager_->SwitchSnapshot(name)) {
+    return false;
+  }
+  replacer_->Clean();
+  page_table_.clear();
+  resident_cnt_ = 0;
+  free_frames_.clear();
+  for (size_t i = 0; i < num_frames_; ++i) {
+    frames_[i]->Reset();
+    free_frames_.push_back(static_cast<int>(i));
+  }
+  return true;
+}
+
+auto BufferPoolManager::DropSnapshot(const std::string &name) -> bool {
+  return disk_manager_->DropSnapshot(name);
+}
 
 /**
  * @brief Destroys the `BufferPoolManager`, freeing up all memory that the buffer pool was using.
  */
-BufferPoolManager::~BufferPoolManager() = default;
+BufferPoolManager::~BufferPoolManager() {
+  {
+    std::scoped_lock latch(flusher_latch_);
+    stop_flusher_ = true;
+  }
+  flusher_cv_.notify_one();
+  flusher_.join();
+}
 
 void BufferPoolManager::InitPageCnt(int page_cnt) {
+  std::scoped_lock latch(bpm_latch_);
   next_page_id_ = page_cnt;
   disk_manager_->IncreaseDiskSpace(page_cnt);
 }
 
 int BufferPoolManager::PageCnt() {
+  std::scoped_lock latch(bpm_latch_);
   return next_page_id_;
 }
 
@@ -124,6 +190,7 @@ auto BufferPoolManager::Size() const -> size_t { return num_frames_; }
  * @return The page ID of the newly allocated page.
  */
 auto BufferPoolManager::NewPage() -> int {
+  std::scoped_lock latch(bpm_latch_);
   ++next_page_id_;
   disk_manager_->IncreaseDiskSpace(next_page_id_);
   return next_page_id_;
@@ -155,6 +222,8 @@ auto BufferPoolManager::NewPage() -> int {
  * @return `false` if the page exists but could not be deleted, `true` if the page didn't exist or deletion succeeded.
  */
 auto BufferPoolManager::DeletePage(int page_id) -> bool {
+  // the resident latch keeps a resident page from being pinned through a swip meanwhile
+  std::scoped_lock latch(write_back_latch_, bpm_latch_, resident_latch_);
   auto it = page_table_.find(page_id);
   if (it == page_table_.end()) {
     disk_manager_->DeletePage(page_id);
@@ -164,7 +233,12 @@ auto BufferPoolManager::DeletePage(int page_id) -> bool {
   if (frames_[frame_id]->pin_count_ > 0) {
     return false;
   }
+  if (frames_[frame_id]->resident_) {
+    --resident_cnt_;
+    replacer_->SetEvictable(frame_id, true);
+  }
   replacer_->Remove(frame_id);
+  frames_[frame_id]->Reset();
   free_frames_.push_back(frame_id);
   page_table_.erase(it);
   return true;
@@ -209,11 +283,7 @@ auto BufferPoolManager::DeletePage(int page_id) -> bool {
  * returns `std::nullopt`, otherwise returns a `WritePageGuard` ensuring exclusive and mutable access to a page's data.
  */
 auto BufferPoolManager::WritePage(int page_id) -> WritePageGuard {
-  auto frame_opt = FetchPage(page_id);
-  if (!frame_opt.has_value()) {
-    throw std::exception();
-  }
-  return WritePageGuard(page_id, frame_opt.value(), replacer_, disk_manager_);
+  return WritePageGuard(page_id, PinFrame(page_id), this);
 }
 
 /**
@@ -235,16 +305,20 @@ auto BufferPoolManager::WritePage(int page_id) -> WritePageGuard {
  *
  *
  * @param page_id The ID of the page we want to read.
- * @param access_type The type of page access.
+ * @param ring The ring of the scan that reads the page, or nullptr. See `ScanRing`.
  * @return std::optional<ReadPageGuard> An optional latch guard where if there are no more free frames (out of memory)
  * returns `std::nullopt`, otherwise returns a `ReadPageGuard` ensuring shared and read-only access to a page's data.
  */
-auto BufferPoolManager::ReadPage(int page_id) -> ReadPageGuard {
-  auto frame_opt = FetchPage(page_id);
-  if (!frame_opt.has_value()) {
-    throw std::exception();
-  }
-  return ReadPageGuard(page_id, frame_opt.value(), replacer_, disk_manager_);
+auto BufferPoolManager::ReadPage(int page_id, ScanRing *ring) -> ReadPageGuard {
+  return ReadPageGuard(page_id, PinFrame(page_id, ring), this);
+}
+
+/**
+ * @brief Read a page through a swip, and through the page table if the swip is stale. See `Swip`.
+ */
+auto BufferPoolManager::ReadPage(int page_id, const Swip &swip) -> ReadPageGuard {
+  auto frame = PinSwizzled(page_id, swip);
+  return ReadPageGuard(page_id, frame != nullptr ? frame : PinFrame(page_id), this);
 }
 
 /**
@@ -262,14 +336,27 @@ auto BufferPoolManager::ReadPage(int page_id) -> ReadPageGuard {
  * @return `false` if the page could not be found in the page table, otherwise `true`.
  */
 auto BufferPoolManager::FlushPage(int page_id) -> bool {
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end() || !frames_[it->second]->is_dirty_) {
-    return false;
+  FrameHeader *frame;
+  {
+    std::scoped_lock latch(bpm_latch_);
+    auto it = page_table_.find(page_id);
+    if (it == page_table_.end() || !frames_[it->second]->is_dirty_) {
+      return false;
+    }
+    frame = frames_[it->second].get();
+    ++frame->pin_count_;
+    if (frame->pin_count_ == 1) {
+      replacer_->SetEvictable(frame->frame_id_, false);
+    }
   }
-  if (frames_[it->second]->is_dirty_) {
-    disk_manager_->WritePage(page_id, frames_[it->second]->GetDataMut());
-    frames_[it->second]->is_dirty_ = false;
+  // take the frame latch without holding the pool latch, a writer may be waiting for the pool latch while holding it
+  frame->rwlatch_.lock_shared();
+  if (frame->is_dirty_) {
+    frame->is_dirty_ = false;
+    disk_manager_->WritePage(page_id, frame->GetData());
   }
+  frame->rwlatch_.unlock_shared();
+  UnpinFrame(frame);
   return true;
 }
 
@@ -282,14 +369,21 @@ auto BufferPoolManager::FlushPage(int page_id) -> bool {
  * `CheckedWritePage`, and `FlushPage`, as it will likely be much easier to understand what to do.
  */
 void BufferPoolManager::FlushAllPages() {
-  for (auto &frame : frames_) {
-    if (frame != nullptr) {
-      if (frame->is_dirty_) {
-        disk_manager_->WritePage(frame->page_id_, frame->GetDataMut());
-        frame->is_dirty_ = false;
+  std::scoped_lock write_back_latch(write_back_latch_);
+  vector<int> dirty_pages;
+  {
+    std::scoped_lock latch(bpm_latch_);
+    // a checkpoint may follow, which must not race with reads of the pending file
+    ReapReadAhead(true);
+    for (const auto &entry : page_table_) {
+      if (frames_[entry.second]->is_dirty_) {
+        dirty_pages.push_back(entry.first);
       }
     }
   }
+  for (size_t i = 0; i < dirty_pages.size(); ++i) {
+    FlushPage(dirty_pages[i]);
+  }
 }
 
 /**
@@ -315,41 +409,410 @@ void BufferPoolManager::FlushAllPages() {
  * @return std::optional<size_t> The pin count if the page exists, otherwise `std::nullopt`.
  */
 auto BufferPoolManager::GetPinCount(int page_id) -> std::optional<size_t> {
+  std::scoped_lock latch(bpm_latch_);
   if (page_table_.find(page_id) == page_table_.end()) {
     return std::nullopt;
   }
   return frames_[page_table_[page_id]]->pin_count_;
 }
 
-auto BufferPoolManager::FetchPage(int page_id)
-    -> std::optional<std::shared_ptr<FrameHeader>> {
-  if (page_table_.find(page_id) != page_table_.end()) {
-    replacer_->RecordAccess(page_table_[page_id]);
-    return frames_[page_table_[page_id]];
+/**
+ * @brief Move a page into the resident region of the pool, or out of it.
+ *
+ * A resident page is loaded if it misses, and is never evicted until it is released or deleted. Releasing a page that
+ * is not resident does nothing.
+ *
+ * @param page_id the page to keep or to release
+ * @param resident whether the page is kept
+ * @return false if the page could not be kept because the region is full
+ */
+auto BufferPoolManager::SetResident(int page_id, bool resident) -> bool {
+  std::scoped_lock latch(bpm_latch_);
+  std::unique_lock resident_latch(resident_latch_);
+  if (!resident) {
+    auto it = page_table_.find(page_id);
+    if (it != page_table_.end() && frames_[it->second]->resident_) {
+      auto &frame = frames_[it->second];
+      frame->resident_ = false;
+      --resident_cnt_;
+      if (frame->pin_count_ == 0U) {
+        replacer_->SetEvictable(frame->frame_id_, true);
+      }
+    }
+    return true;
   }
-  if (!free_frames_.empty()) {
-    auto new_frame = free_frames_.back();
-    free_frames_.pop_back();
-    frames_[new_frame] = std::make_shared<FrameHeader>(new_frame, page_id);
-    replacer_->RecordAccess(new_frame);
-    page_table_[page_id] = new_frame;
-    disk_manager_->ReadPage(page_id, frames_[new_frame]->GetDataMut());
-    return frames_[new_frame];
+  if (resident_cnt_ >= ResidentCapacity()) {
+    return page_table_.find(page_id) != page_table_.end() && frames_[page_table_[page_id]]->resident_;
   }
-  auto evicted_frame = replacer_->Evict();
-  if (!evicted_frame.has_value()) {
-    return std::nullopt;
+  // the page may have to be read, which does not pin any frame
+  resident_latch.unlock();
+  auto frame = FetchPage(page_id, nullptr);
+  if (frame == nullptr) {
+    return false;
+  }
+  resident_latch.lock();
+  if (!frame->resident_) {
+    frame->resident_ = true;
+    ++resident_cnt_;
+    replacer_->SetEvictable(frame->frame_id_, false);
+  }
+  return true;
+}
+
+// Return the number of frames of the resident region
+auto BufferPoolManager::ResidentCapacity() const -> size_t { return num_frames_ * RESIDENT_FRAME_PERCENT / 100; }
+
+/**
+ * @brief Point a swip at the frame of a resident page, or clear it if the page is not resident or POINTER_SWIZZLING is
+ * not set.
+ */
+void BufferPoolManager::Swizzle(int page_id, Swip *swip) {
+  std::scoped_lock latch(bpm_latch_);
+  auto it = page_table_.find(page_id);
+  if (!POINTER_SWIZZLING || it == page_table_.end() || !frames_[it->second]->resident_) {
+    swip->Clear();
+    return;
+  }
+  swip->Set(page_id, it->second);
+}
+
+auto BufferPoolManager::GetStats() -> FileStats {
+  std::scoped_lock latch(bpm_latch_);
+  FileStats stats;
+  stats.name_ = disk_manager_->GetFileName();
+  stats.page_cnt_ = next_page_id_;
+  stats.swizzled_hit_cnt_ = swizzled_hit_cnt_;
+  stats.hit_cnt_ = hit_cnt_ + stats.swizzled_hit_cnt_;
+  stats.miss_cnt_ = miss_cnt_;
+  stats.evict_cnt_ = evict_cnt_;
+  stats.write_back_cnt_ = write_back_cnt_;
+  stats.read_cnt_ = disk_manager_->GetNumReads();
+  stats.write_cnt_ = disk_manager_->GetNumWrites();
+  stats.flush_cnt_ = disk_manager_->GetNumFlushes();
+  stats.delete_cnt_ = disk_manager_->GetNumDeletes();
+  stats.resident_page_cnt_ = static_cast<int>(resident_cnt_);
+  return stats;
+}
+
+auto BufferPoolManager::FetchPage(int page_id, ScanRing *ring) -> FrameHeader * {
+  auto it = page_table_.find(page_id);
+  if (it != page_table_.end()) {
+    auto frame = frames_[it->second].get();
+    if (frame->read_ahead_.valid()) {
+      frame->read_ahead_.wait();
+      ReapReadAhead(false);
+    }
+    // a scan does not promote the pages it loaded, and any other reader takes them out of the scan
+    if (ring == nullptr) {
+      frame->scan_owned_ = false;
+    }
+    if (!frame->scan_owned_) {
+      replacer_->RecordAccess(frame->frame_id_, page_id);
+    }
+    ++hit_cnt_;
+    return frame;
   }
-  auto frame_id = evicted_frame.value();
-  if (frames_[frame_id]->is_dirty_) {
-    disk_manager_->WritePage(frames_[frame_id]->page_id_, frames_[frame_id]->GetDataMut());
+  ++miss_cnt_;
+  if (free_frames_.empty() && !read_ahead_frames_.empty()) {
+    ReapReadAhead(false);
   }
-  page_table_.erase(page_table_.find(frames_[frame_id]->page_id_));
-  frames_[frame_id] = std::make_shared<FrameHeader>(frame_id, page_id);
+  auto frame_id = TakeFrame(page_id, ring);
+  if (frame_id == -1) {
+    return nullptr;
+  }
+  auto &frame = frames_[frame_id];
+  frame->Reset();
+  frame->page_id_ = page_id;
+  frame->scan_owned_ = ring != nullptr;
   page_table_[page_id] = frame_id;
-  replacer_->RecordAccess(frame_id);
-  disk_manager_->ReadPage(page_id, frames_[frame_id]->GetDataMut());
-  return frames_[frame_id];
+  replacer_->RecordAccess(frame_id, page_id, ring != nullptr ? AccessType::Scan : AccessType::Unknown);
+  disk_manager_->ReadPage(page_id, frame->GetDataMut());
+  return frame.get();
 }
 
-}
\ No newline at end of file
+/**
+ * @brief Take a frame for a page that is not in the pool. Must be called with the pool latch held.
+ *
+ * A scan recycles a frame of its ring if it can. Otherwise the frame is a free one or the victim of the replacer, and
+ * it joins the ring of the scan. The page of a recycled or evicted frame is removed from the page table, and written
+ * back first if it is dirty.
+ *
+ * @param page_id the page that will be loaded into the frame
+ * @param ring the ring of the scan, or nullptr
+ * @return the frame, or -1 if every frame is pinned
+ */
+auto BufferPoolManager::TakeFrame(int page_id, ScanRing *ring) -> int {
+  int frame_id = ring == nullptr ? -1 : RecycleRingFrame(ring);
+  if (frame_id == -1) {
+    if (!free_frames_.empty()) {
+      frame_id = free_frames_.back();
+      free_frames_.pop_back();
+      if (ring != nullptr) {
+        ring->Add(frame_id, page_id);
+      }
+      return frame_id;
+    }
+    auto evicted_frame = replacer_->Evict();
+    if (!evicted_frame.has_value()) {
+      return -1;
+    }
+    frame_id = evicted_frame.value();
+    if (ring != nullptr) {
+      ring->Add(frame_id, page_id);
+    }
+  } else {
+    ring->page_ids_[ring->next_] = page_id;
+    ring->next_ = (ring->next_ + 1) % ring->size_;
+  }
+  ++evict_cnt_;
+  auto &victim = frames_[frame_id];
+  if (victim->is_dirty_) {
+    // the flusher fell behind, so the miss pays for the write. wake it up to refill the clean frames
+    ++write_back_cnt_;
+    disk_manager_->WritePage(victim->page_id_, victim->GetData());
+    flusher_cv_.notify_one();
+  }
+  page_table_.erase(page_table_.find(victim->page_id_));
+  return frame_id;
+}
+
+/**
+ * @brief Find the least recent frame of a full ring, and take it out of the replacer if it can be recycled: it still
+ * holds the page the scan loaded, only the scan read that page and it is not pinned.
+ *
+ * @return the frame, or -1 if the ring is not full or its least recent frame left the scan
+ */
+auto BufferPoolManager::RecycleRingFrame(ScanRing *ring) -> int {
+  if (ring->frame_ids_.size() < ring->size_) {
+    return -1;
+  }
+  int frame_id = ring->frame_ids_[ring->next_];
+  auto &frame = frames_[frame_id];
+  if (!frame->scan_owned_ || frame->page_id_ != ring->page_ids_[ring->next_] || frame->pin_count_ != 0U) {
+    return -1;
+  }
+  replacer_->Remove(frame_id);
+  return frame_id;
+}
+
+/**
+ * @brief Brings a page into the pool and pins it on behalf of a page guard.
+ *
+ * The pin is taken while holding the pool latch, so the frame cannot be evicted between the lookup and the moment the
+ * guard acquires the frame latch. Page guards must never take the pool latch while waiting for a frame latch.
+ *
+ * @param page_id The page to pin.
+ * @param ring The ring of the scan that reads the page, or nullptr.
+ * @return The frame holding the page.
+ */
+auto BufferPoolManager::PinFrame(int page_id, ScanRing *ring) -> FrameHeader * {
+  std::scoped_lock latch(bpm_latch_);
+  auto frame = FetchPage(page_id, ring);
+  if (frame == nullptr) {
+    throw std::exception();
+  }
+  ++frame->pin_count_;
+  if (frame->pin_count_ == 1) {
+    replacer_->SetEvictable(frame->frame_id_, false);
+  }
+  return frame;
+}
+
+/**
+ * @brief Pin the frame of a resident page through a swip, without the pool latch.
+ *
+ * @return the frame, or nullptr if the swip is stale
+ */
+auto BufferPoolManager::PinSwizzled(int page_id, const Swip &swip) -> FrameHeader * {
+  int frame_id = swip.FrameOf(page_id);
+  if (frame_id == -1) {
+    return nullptr;
+  }
+  std::shared_lock latch(resident_latch_);
+  auto frame = frames_[frame_id].get();
+  // the page of a resident frame cannot change while the latch is held
+  if (!frame->resident_ || frame->page_id_ != page_id) {
+    return nullptr;
+  }
+  ++frame->pin_count_;
+  ++swizzled_hit_cnt_;
+  return frame;
+}
+
+/**
+ * @brief Releases a pin taken by `PinFrame`, `PinSwizzled` or by a flush.
+ */
+void BufferPoolManager::UnpinFrame(FrameHeader *frame) {
+  if (frame->resident_) {
+    // a resident frame is never evictable, so only its pin count changes
+    std::shared_lock latch(resident_latch_);
+    if (frame->resident_) {
+      --frame->pin_count_;
+      return;
+    }
+  }
+  std::scoped_lock latch(bpm_latch_);
+  --frame->pin_count_;
+  if (frame->pin_count_ == 0U && !frame->resident_) {
+    replacer_->SetEvictable(frame->frame_id_, true);
+  }
+}
+
+/**
+ * @brief Start reading pages that are likely to be fetched soon, such as the next leaves of a scan.
+ *
+ * Pages already in the pool are skipped. Each read takes a frame like a miss would, but the frame is only recorded
+ * once in the replacer, so a page that is never fetched is among the first victims. Fetching the page waits for its
+ * read to finish.
+ *
+ * @param page_ids the pages to read
+ * @param ring the ring of the scan the pages are read for, or nullptr
+ */
+void BufferPoolManager::ReadAhead(const vector<int> &page_ids, ScanRing *ring) {
+  list<DiskRequest> requests;
+  std::scoped_lock latch(bpm_latch_);
+  size_t size = page_ids.size();
+  for (size_t i = 0; i < size; ++i) {
+    int page_id = page_ids[i];
+    if (page_table_.find(page_id) != page_table_.end()) {
+      continue;
+    }
+    int frame_id = TakeFrame(page_id, ring);
+    if (frame_id == -1) {
+      break;
+    }
+    auto &frame = frames_[frame_id];
+    frame->Reset();
+    frame->page_id_ = page_id;
+    frame->scan_owned_ = ring != nullptr;
+    frame->pin_count_ = 1;
+    page_table_[page_id] = frame_id;
+    replacer_->RecordAccess(frame_id, page_id, ring != nullptr ? AccessType::Scan : AccessType::Unknown);
+    replacer_->SetEvictable(frame_id, false);
+    auto promise = DiskScheduler::CreatePromise();
+    frame->read_ahead_ = promise.get_future().share();
+    requests.emplace_back({false, frame->GetDataMut(), page_id, std::move(promise)});
+    read_ahead_frames_.push_back(frame_id);
+  }
+  disk_scheduler_->Schedule(&requests);
+}
+
+/**
+ * @brief Release the pins of the finished reads ahead. Must be called with the pool latch held.
+ *
+ * @param wait whether to wait for the reads that are not finished yet
+ */
+void BufferPoolManager::ReapReadAhead(bool wait) {
+  for (auto it = read_ahead_frames_.begin(); it != read_ahead_frames_.end();) {
+    auto &frame = frames_[*it];
+    if (!wait && frame->read_ahead_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      ++it;
+      continue;
+    }
+    frame->read_ahead_.get();
+    frame->read_ahead_ = {};
+    if (--frame->pin_count_ == 0U && !frame->resident_) {
+      replacer_->SetEvictable(frame->frame_id_, true);
+    }
+    it = read_ahead_frames_.erase(it);
+  }
+}
+
+/**
+ * @brief The body of the background flusher. It checks the dirty frames every FLUSHER_INTERVAL_MS, or as soon as a miss
+ * had to write back a dirty victim.
+ */
+void BufferPoolManager::FlusherLoop() {
+  std::unique_lock latch(flusher_latch_);
+  while (!stop_flusher_) {
+    flusher_cv_.wait_for(latch, std::chrono::milliseconds(FLUSHER_INTERVAL_MS));
+    if (stop_flusher_) {
+      return;
+    }
+    latch.unlock();
+    WriteBackDirtyFrames();
+    latch.lock();
+  }
+}
+
+/**
+ * @brief Write back dirty unpinned frames once more than `dirty_high_water_` frames are dirty, until only half of the
+ * high-water mark is left.
+ *
+ * The pages are written in the order of their ids, so that the writes are mostly sequential. The flusher never waits for
+ * a frame latch: a page that is latched again before it is written is skipped, it will be back in the next round.
+ *
+ * The frames are written in batches of FLUSHER_BATCH_PERCENT of the pool and unpinned between the batches. A batch also
+ * stops early rather than pin a frame while no more than a batch of frames is evictable, so a miss during the write
+ * back always finds a victim.
+ */
+void BufferPoolManager::WriteBackDirtyFrames() {
+  vector<int> candidates;
+  size_t to_write;
+  {
+    std::scoped_lock latch(bpm_latch_);
+    size_t dirty_cnt = 0;
+    for (const auto &entry : page_table_) {
+      const auto &frame = frames_[entry.second];
+      if (frame->is_dirty_) {
+        ++dirty_cnt;
+        if (frame->pin_count_ == 0U) {
+          candidates.push_back(entry.first);
+        }
+      }
+    }
+    if (dirty_cnt <= dirty_high_water_) {
+      return;
+    }
+    to_write = dirty_cnt - dirty_high_water_ / 2;
+  }
+  std::scoped_lock write_back_latch(write_back_latch_);
+  size_t batch_cap = std::max<size_t>(num_frames_ * FLUSHER_BATCH_PERCENT / 100, 1);
+  size_t size = candidates.size();
+  size_t i = 0;
+  while (i < size && to_write > 0) {
+    // the frames of a batch are pinned and read-latched, then written together
+    list<FrameHeader *> batch;
+    list<DiskRequest> requests;
+    list<std::future<bool>> futures;
+    for (; i < size && batch.size() < std::min(batch_cap, to_write); ++i) {
+      FrameHeader *frame;
+      {
+        std::scoped_lock latch(bpm_latch_);
+        auto it = page_table_.find(candidates[i]);
+        if (it == page_table_.end() || !frames_[it->second]->is_dirty_ || frames_[it->second]->pin_count_ != 0U) {
+          continue;
+        }
+        if (replacer_->Size() <= batch_cap) {
+          break;
+        }
+        frame = frames_[it->second].get();
+        ++frame->pin_count_;
+        replacer_->SetEvictable(frame->frame_id_, false);
+      }
+      if (!frame->rwlatch_.try_lock_shared()) {
+        UnpinFrame(frame);
+        continue;
+      }
+      frame->is_dirty_ = false;
+      auto promise = DiskScheduler::CreatePromise();
+      futures.emplace_back(promise.get_future());
+      requests.emplace_back({true, frame->GetDataMut(), candidates[i], std::move(promise)});
+      batch.push_back(frame);
+    }
+    if (batch.empty()) {
+      return;
+    }
+    disk_scheduler_->Schedule(&requests);
+    for (auto &future : futures) {
+      future.get();
+    }
+    for (auto &frame : batch) {
+      frame->rwlatch_.unlock_shared();
+      UnpinFrame(frame);
+    }
+    to_write -= batch.size();
+  }
+}
+
+}
@@ -0,0 +1,83 @@
+#include "buffer/clock_replacer.h"
+
+namespace sjtu {
+
+ClockReplacer::ClockReplacer(size_t num_frames)
+    : num_frames_(num_frames),
+      tracked_(num_frames, false),
+      evictable_(num_frames, false),
+      referenced_(num_frames, false) {}
+
+void ClockReplacer::Clean() {
+  for (size_t i = 0; i < num_frames_; ++i) {
+    tracked_[i] = evictable_[i] = referenced_[i] = false;
+  }
+  hand_ = 0;
+  evictable_size_ = 0;
+}
+
+/**
+ * @brief Sweep the hand until it finds an evictable frame whose reference bit is clear. Two rounds are enough, since
+ * the first one clears the bits of all the evictable frames.
+ */
+auto ClockReplacer::Evict() -> std::optional<int> {
+  if (evictable_size_ == 0) {
+    return std::nullopt;
+  }
+  while (true) {
+    size_t frame_id = hand_;
+    hand_ = (hand_ + 1) % num_frames_;
+    if (!tracked_[frame_id] || !evictable_[frame_id]) {
+      continue;
+    }
+    if (referenced_[frame_id]) {
+      referenced_[frame_id] = false;
+      continue;
+    }
+    tracked_[frame_id] = evictable_[frame_id] = false;
+    --evictable_size_;
+    return static_cast<int>(frame_id);
+  }
+}
+
+// A scan does not set the reference bit
+void ClockReplacer::RecordAccess(int frame_id, int /*page_id*/, AccessType access_type) {
+  if (access_type == AccessType::Scan) {
+    if (!tracked_[frame_id]) {
+      tracked_[frame_id] = true;
+      referenced_[frame_id] = false;
+    }
+    return;
+  }
+  tracked_[frame_id] = true;
+  referenced_[frame_id] = true;
+}
+
+void ClockReplacer::SetEvictable(int frame_id, bool set_evictable) {
+  if (!tracked_[frame_id] || evictable_[frame_id] == set_evictable) {
+    return;
+  }
+  evictable_[frame_id] = set_evictable;
+  if (set_evictable) {
+    ++evictable_size_;
+  } else {
+    --evictable_size_;
+  }
+}
+
+void ClockReplacer::Remove(int frame_id) {
+  if (!tracked_[frame_id]) {
+    return;
+  }
+  if (!evictable_[frame_id]) {
+    throw std::exception();
+  }
+  tracked_[frame_id] = evictable_[frame_id] = referenced_[frame_id] = false;
+  --evictable_size_;
+}
+
+auto ClockReplacer::Size() -> size_t {
+  return evictable_size_;
+}
+
+}
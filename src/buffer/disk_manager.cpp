@@ -1,118 +1,305 @@
-#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <string>
-#include <iostream>
 
 #include "buffer/disk_manager.h"
 #include "config.h"
 
 namespace sjtu {
 
-static char *buffer_used;
-
 /**
- * Constructor: open/create a single database file & log file
- * @input db_file: database file name
+ * Written at the end of a prepared pending file, right after the slots of its pages and the saved page tables.
  */
-DiskManager::DiskManager(const std::filesystem::path &db_file) : file_name_(db_file) {
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
+struct PendingTrailer {
+  static constexpr uint64_t kMagic = 0x474e49444e4550;  // "PENDING"
+  uint64_t magic_;
+  uint64_t epoch_;
+  uint64_t count_;      // the number of pending pages
+  uint64_t slot_cnt_;   // the number of slots in the database file
+  uint64_t meta_size_;  // the size of the saved page tables, 0 if they are unchanged
+  uint64_t page_size_;
+};
+
+static constexpr uint32_t kMetaMagic = 0x50414e53;  // "SNAP"
+
+static auto PendingFileName(const std::filesystem::path &db_file) -> std::string {
+  return db_file.string() + ".pending";
+}
+
+static auto MetaFileName(const std::filesystem::path &db_file) -> std::string {
+  return db_file.string() + ".meta";
+}
+
+static auto OpenFile(const std::string &file_name) -> int {
+  int fd = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd == -1) {
+    throw std::exception();
+  }
+  return fd;
+}
+
+// return -1 if the file system does not support direct I/O
+static auto OpenDirect(const std::string &file_name) -> int {
+  int fd = open(file_name.c_str(), O_RDWR | O_DIRECT);
+  if (fd == -1 && errno != EINVAL) {
+    throw std::exception();
+  }
+  return fd;
+}
+
+static void WriteAll(int fd, const char *data, size_t len, size_t offset) {
+  while (len > 0) {
+    auto res = pwrite(fd, data, len, offset);
+    if (res <= 0) {
       throw std::exception();
     }
-  } else {
-    db_io_.seekg(BUSTUB_PAGE_SIZE);
-    db_io_.read(reinterpret_cast<char *>(&page_capacity_), 4);
-    if (page_capacity_ < 16) {
-      page_capacity_ = 16;
+    data += res;
+    len -= res;
+    offset += res;
+  }
+}
+
+// bytes beyond the end of file are read as zero
+static void ReadAll(int fd, char *data, size_t len, size_t offset) {
+  while (len > 0) {
+    auto res = pread(fd, data, len, offset);
+    if (res < 0) {
+      throw std::exception();
+    }
+    if (res == 0) {
+      memset(data, 0, len);
+      return;
     }
+    data += res;
+    len -= res;
+    offset += res;
   }
+}
 
-  // Initialize the database file.
-  std::filesystem::resize_file(db_file, (page_capacity_ + 1) * BUSTUB_PAGE_SIZE);
-  assert(static_cast<size_t>(GetFileSize(file_name_)) >= page_capacity_ * BUSTUB_PAGE_SIZE);
-  buffer_used = nullptr;
+// write a whole file through a temporary file, so a crash leaves either the old content or the new one
+static void ReplaceFile(const std::string &file_name, const std::string &content) {
+  auto tmp_file_name = file_name + ".tmp";
+  int fd = open(tmp_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    throw std::exception();
+  }
+  WriteAll(fd, content.c_str(), content.size(), 0);
+  if (fsync(fd) != 0 || rename(tmp_file_name.c_str(), file_name.c_str()) != 0) {
+    throw std::exception();
+  }
+  close(fd);
+  auto dir = std::filesystem::path(file_name).parent_path();
+  fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+  if (fd == -1) {
+    throw std::exception();
+  }
+  fsync(fd);
+  close(fd);
 }
 
 /**
- * Close all file streams
+ * Constructor: open/create a single database file & its pending file
+ * @input db_file: database file name
  */
-void DiskManager::ShutDown() {
-  {
-    db_io_.close();
+DiskManager::DiskManager(const std::filesystem::path &db_file, bool direct_io, size_t page_size)
+    : file_name_(db_file), page_size_(page_size) {
+  db_fd_ = OpenFile(file_name_);
+  // pages left from an uncommitted checkpoint, or written after the last checkpoint, are discarded
+  pending_fd_ = OpenFile(PendingFileName(file_name_));
+  if (ftruncate(pending_fd_, 0) != 0) {
+    throw std::exception();
+  }
+  if (direct_io) {
+    db_direct_fd_ = OpenDirect(file_name_);
+    pending_direct_fd_ = db_direct_fd_ == -1 ? -1 : OpenDirect(PendingFileName(file_name_));
+    if (pending_direct_fd_ != -1) {
+      bounce_buffer_ = static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, page_size_));
+    } else if (db_direct_fd_ != -1) {
+      close(db_direct_fd_);
+      db_direct_fd_ = -1;
+    }
   }
+  LoadMeta();
 }
 
+DiskManager::~DiskManager() { ShutDown(); }
+
 /**
- * @brief Increases the size of the file to fit the specified number of pages.
+ * Close all file descriptors
  */
-void DiskManager::IncreaseDiskSpace(size_t pages) {
-  if (pages < pages_) {
-    return;
+void DiskManager::ShutDown() {
+  if (db_fd_ != -1) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (pending_fd_ != -1) {
+    close(pending_fd_);
+    pending_fd_ = -1;
   }
+  if (db_direct_fd_ != -1) {
+    close(db_direct_fd_);
+    close(pending_direct_fd_);
+    db_direct_fd_ = pending_direct_fd_ = -1;
+  }
+  std::free(bounce_buffer_);
+  bounce_buffer_ = nullptr;
+}
 
-  pages_ = pages;
-  while (page_capacity_ < pages_) {
-    page_capacity_ *= 2;
+/**
+ * @brief Record the number of pages in use. The files grow on demand, so no space is reserved.
+ */
+void DiskManager::IncreaseDiskSpace(size_t pages) {
+  std::scoped_lock latch(db_io_latch_);
+  if (pages > pages_) {
+    pages_ = pages;
   }
+}
 
-  std::filesystem::resize_file(file_name_, (page_capacity_ + 1) * BUSTUB_PAGE_SIZE);
+/**
+ * Write the contents of the specified page into the pending file. It reaches the database file at the next checkpoint.
+ */
+void DiskManager::WritePage(int page_id, const char *page_data) {
+  std::scoped_lock latch(db_io_latch_);
+  WritePageLocked(page_id, page_data);
+}
 
-  assert(static_cast<size_t>(GetFileSize(file_name_)) >= page_capacity_ * BUSTUB_PAGE_SIZE);
+void DiskManager::WritePages(const vector<int> &page_ids, const vector<const char *> &data) {
+  std::scoped_lock latch(db_io_latch_);
+  size_t size = page_ids.size();
+  for (size_t i = 0; i < size; ++i) {
+    WritePageLocked(page_ids[i], data[i]);
+  }
 }
 
 /**
- * Write the contents of the specified page into disk file
+ * Read the contents of the specified page into the given memory area
  */
-void DiskManager::WritePage(int page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+void DiskManager::ReadPage(int page_id, char *page_data) {
+  std::scoped_lock latch(db_io_latch_);
+  ReadPageLocked(page_id, page_data);
+}
 
-  // Set the write cursor to the page offset.
+void DiskManager::WritePageLocked(int page_id, const char *page_data) {
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
+  int slot = SlotForWrite(page_id);
+  auto it = pending_slots_.find(slot);
+  size_t pending_slot;
+  if (it != pending_slots_.end()) {
+    pending_slot = it->second;
+  } else {
+    pending_slot = pending_pages_.size();
+    pending_slots_[slot] = pending_slot;
+    pending_pages_.push_back(slot);
+  }
+  WriteSlot(true, page_data, pending_slot * page_size_);
+}
 
-  if (db_io_.bad()) {
-    throw std::exception();
+void DiskManager::ReadPageLocked(int page_id, char *page_data) {
+  num_reads_ += 1;
+  auto &page_table = *page_table_;
+  int slot = static_cast<size_t>(page_id) < page_table.size() ? page_table[page_id] : -1;
+  if (slot == -1) {
+    memset(page_data, 0, page_size_);
     return;
   }
+  auto it = pending_slots_.find(slot);
+  if (it != pending_slots_.end()) {
+    ReadSlot(true, page_data, it->second * page_size_);
+  } else {
+    ReadSlot(false, page_data, static_cast<size_t>(slot) * page_size_);
+  }
+}
 
-  // Flush the write to disk.
-  db_io_.flush();
+void DiskManager::ReadSlot(bool pending, char *page_data, size_t offset) {
+  int fd = pending ? pending_direct_fd_ : db_direct_fd_;
+  if (fd == -1) {
+    ReadAll(pending ? pending_fd_ : db_fd_, page_data, page_size_, offset);
+  } else if (reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0) {
+    ReadAll(fd, bounce_buffer_, page_size_, offset);
+    memcpy(page_data, bounce_buffer_, page_size_);
+  } else {
+    ReadAll(fd, page_data, page_size_, offset);
+  }
+}
+
+void DiskManager::WriteSlot(bool pending, const char *page_data, size_t offset) {
+  int fd = pending ? pending_direct_fd_ : db_direct_fd_;
+  if (fd == -1) {
+    WriteAll(pending ? pending_fd_ : db_fd_, page_data, page_size_, offset);
+    return;
+  }
+  if (reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0) {
+    memcpy(bounce_buffer_, page_data, page_size_);
+    page_data = bounce_buffer_;
+  }
+  WriteAll(fd, page_data, page_size_, offset);
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * A page keeps its slot unless the slot is shared with a snapshot. The page table itself is shared with the snapshots
+ * taken since the last write, so it is copied first.
  */
-void DiskManager::ReadPage(int page_id, char *page_data) {
-  int offset = page_id * BUSTUB_PAGE_SIZE;
+auto DiskManager::SlotForWrite(int page_id) -> int {
+  if (page_table_.use_count() > 1) {
+    page_table_ = std::make_shared<PageTable>(*page_table_);
+    auto &page_table = *page_table_;
+    size_t size = page_table.size();
+    for (size_t i = 0; i < size; ++i) {
+      if (page_table[i] != -1) {
+        ++ref_cnt_[page_table[i]];
+      }
+    }
+  }
+  auto &page_table = *page_table_;
+  while (page_table.size() <= static_cast<size_t>(page_id)) {
+    page_table.push_back(-1);
+  }
+  int slot = page_table[page_id];
+  if (slot != -1 && ref_cnt_[slot] == 1) {
+    return slot;
+  }
+  if (slot != -1) {
+    UnrefSlot(slot);
+  }
+  slot = AllocateSlot();
+  page_table[page_id] = slot;
+  meta_dirty_ = true;
+  return slot;
+}
 
-  // Check if we have read beyond the file length.
-  if (offset > GetFileSize(file_name_)) {
-    throw std::exception();
-    return;
+auto DiskManager::AllocateSlot() -> int {
+  int slot;
+  if (free_slots_.empty()) {
+    slot = ref_cnt_.size();
+    ref_cnt_.push_back(0);
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
   }
+  ref_cnt_[slot] = 1;
+  return slot;
+}
 
-  // Set the read cursor to the page offset.
-  db_io_.seekg(offset);
-  db_io_.read(page_data, BUSTUB_PAGE_SIZE);
+void DiskManager::UnrefSlot(int slot) {
+  if (--ref_cnt_[slot] == 0) {
+    free_slots_.push_back(slot);
+  }
+}
 
-  if (db_io_.bad()) {
-    throw std::exception();
+void DiskManager::ReleaseTable(std::shared_ptr<PageTable> table) {
+  if (table.use_count() > 1) {
     return;
   }
-
-  // Check if the file ended before we could read a full page.
-  int read_count = db_io_.gcount();
-  if (read_count < BUSTUB_PAGE_SIZE) {
-    throw std::exception();
-    db_io_.clear();
-    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  size_t size = table->size();
+  for (size_t i = 0; i < size; ++i) {
+    if ((*table)[i] != -1) {
+      UnrefSlot((*table)[i]);
+    }
   }
 }
 
@@ -120,23 +307,314 @@ void DiskManager::ReadPage(int page_id, char *page_data) {
  * Note: This is a no-op for now without a more complex data structure to
  * track deallocated pages.
  */
-void DiskManager::DeletePage(int page_id) { num_deletes_ += 1; }
+void DiskManager::DeletePage(int page_id) {
+  std::scoped_lock latch(db_io_latch_);
+  num_deletes_ += 1;
+}
 
+/**
+ * Drop every page and every snapshot. Like any other write, the database file only shrinks at the next checkpoint.
+ */
 void DiskManager::Clean() {
-  db_io_.close();
-  db_io_.open(file_name_, std::ios::out);
-  db_io_.close();
-  db_io_.open(file_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-  page_capacity_ = 16;
+  std::scoped_lock latch(db_io_latch_);
+  page_table_ = std::make_shared<PageTable>();
+  snapshots_.clear();
+  ref_cnt_.clear();
+  free_slots_.clear();
+  pending_slots_.clear();
+  pending_pages_.clear();
+  if (ftruncate(pending_fd_, 0) != 0) {
+    throw std::exception();
+  }
+  meta_dirty_ = true;
   pages_ = 0;
   num_deletes_ = 0;
   num_flushes_ = 0;
   num_writes_ = 0;
-  std::filesystem::resize_file(file_name_, (page_capacity_ + 1) * BUSTUB_PAGE_SIZE);
-  assert(static_cast<size_t>(GetFileSize(file_name_)) >= page_capacity_ * BUSTUB_PAGE_SIZE);
-  buffer_used = nullptr;
+  num_reads_ = 0;
+}
+
+auto DiskManager::CreateSnapshot(const std::string &name) -> bool {
+  std::scoped_lock latch(db_io_latch_);
+  if (snapshots_.find(name) != snapshots_.end()) {
+    return false;
+  }
+  snapshots_[name] = page_table_;
+  meta_dirty_ = true;
+  return true;
+}
+
+auto DiskManager::SwitchSnapshot(const std::string &name) -> bool {
+  std::scoped_lock latch(db_io_latch_);
+  auto it = snapshots_.find(name);
+  if (it == snapshots_.end()) {
+    return false;
+  }
+  auto page_table = page_table_;
+  page_table_ = it->second;
+  ReleaseTable(std::move(page_table));
+  meta_dirty_ = true;
+  return true;
+}
+
+auto DiskManager::DropSnapshot(const std::string &name) -> bool {
+  std::scoped_lock latch(db_io_latch_);
+  auto it = snapshots_.find(name);
+  if (it == snapshots_.end()) {
+    return false;
+  }
+  auto page_table = it->second;
+  snapshots_.erase(it);
+  ReleaseTable(std::move(page_table));
+  meta_dirty_ = true;
+  return true;
+}
+
+auto DiskManager::GetSlotCnt() -> size_t {
+  std::scoped_lock latch(db_io_latch_);
+  return ref_cnt_.size();
+}
+
+/**
+ * Load the page tables saved by the last checkpoint. A database file without them is mapped page by page.
+ *
+ * Saved format: magic, the number of slots, the number of distinct page tables followed by each of them (the first one
+ * is the current state), then the number of snapshots followed by the name and the page table of each of them.
+ */
+void DiskManager::LoadMeta() {
+  page_table_ = std::make_shared<PageTable>();
+  snapshots_.clear();
+  auto meta_file_name = MetaFileName(file_name_);
+  size_t slot_cnt;
+  if (!std::filesystem::exists(meta_file_name)) {
+    slot_cnt = std::filesystem::file_size(file_name_) / page_size_;
+    for (size_t i = 0; i < slot_cnt; ++i) {
+      page_table_->push_back(i);
+    }
+  } else {
+    int fd = OpenFile(meta_file_name);
+    std::string meta(std::filesystem::file_size(meta_file_name), '\0');
+    ReadAll(fd, meta.data(), meta.size(), 0);
+    close(fd);
+    size_t pos = 0;
+    auto next = [&meta, &pos]() -> uint32_t {
+      uint32_t res;
+      memcpy(&res, meta.data() + pos, sizeof(res));
+      pos += sizeof(res);
+      return res;
+    };
+    if (next() != kMetaMagic) {
+      throw std::exception();
+    }
+    slot_cnt = next();
+    vector<std::shared_ptr<PageTable>> tables;
+    size_t table_cnt = next();
+    for (size_t i = 0; i < table_cnt; ++i) {
+      auto table = std::make_shared<PageTable>(next());
+      for (size_t j = 0; j < table->size(); ++j) {
+        (*table)[j] = static_cast<int>(next());
+      }
+      tables.push_back(table);
+    }
+    page_table_ = tables[0];
+    size_t snapshot_cnt = next();
+    for (size_t i = 0; i < snapshot_cnt; ++i) {
+      size_t len = next();
+      std::string name = meta.substr(pos, len);
+      pos += len;
+      snapshots_[name] = tables[next()];
+    }
+  }
+  ref_cnt_ = vector<int>(slot_cnt, 0);
+  // count every distinct page table once
+  vector<PageTable *> counted;
+  auto count = [this, &counted](PageTable *table) {
+    for (size_t i = 0; i < counted.size(); ++i) {
+      if (counted[i] == table) {
+        return;
+      }
+    }
+    counted.push_back(table);
+    for (size_t i = 0; i < table->size(); ++i) {
+      if ((*table)[i] != -1) {
+        ++ref_cnt_[(*table)[i]];
+      }
+    }
+  };
+  count(page_table_.get());
+  for (auto it = snapshots_.begin(); it != snapshots_.end(); ++it) {
+    count(it->second.get());
+  }
+  free_slots_.clear();
+  for (size_t i = slot_cnt; i > 0; --i) {
+    if (ref_cnt_[i - 1] == 0) {
+      free_slots_.push_back(i - 1);
+    }
+  }
+}
+
+auto DiskManager::SerializeMeta() -> std::string {
+  std::string meta;
+  auto append = [&meta](uint32_t value) { meta.append(reinterpret_cast<const char *>(&value), sizeof(value)); };
+  vector<PageTable *> tables;
+  auto find = [&tables](PageTable *table) -> uint32_t {
+    for (size_t i = 0; i < tables.size(); ++i) {
+      if (tables[i] == table) {
+        return i;
+      }
+    }
+    tables.push_back(table);
+    return tables.size() - 1;
+  };
+  find(page_table_.get());
+  for (auto it = snapshots_.begin(); it != snapshots_.end(); ++it) {
+    find(it->second.get());
+  }
+  append(kMetaMagic);
+  append(ref_cnt_.size());
+  append(tables.size());
+  for (size_t i = 0; i < tables.size(); ++i) {
+    append(tables[i]->size());
+    for (size_t j = 0; j < tables[i]->size(); ++j) {
+      append(static_cast<uint32_t>((*tables[i])[j]));
+    }
+  }
+  append(snapshots_.size());
+  for (auto it = snapshots_.begin(); it != snapshots_.end(); ++it) {
+    append(it->first.size());
+    meta += it->first;
+    append(find(it->second.get()));
+  }
+  return meta;
+}
+
+void DiskManager::TrimSlots() {
+  size_t slot_cnt = ref_cnt_.size();
+  while (slot_cnt > 0 && ref_cnt_[slot_cnt - 1] == 0) {
+    --slot_cnt;
+  }
+  if (slot_cnt == ref_cnt_.size()) {
+    return;
+  }
+  while (ref_cnt_.size() > slot_cnt) {
+    ref_cnt_.pop_back();
+  }
+  vector<int> free_slots;
+  for (size_t i = 0; i < free_slots_.size(); ++i) {
+    if (static_cast<size_t>(free_slots_[i]) < slot_cnt) {
+      free_slots.push_back(free_slots_[i]);
+    }
+  }
+  free_slots_ = free_slots;
+  for (size_t i = 0; i < pending_pages_.size(); ++i) {
+    if (pending_pages_[i] >= static_cast<int>(slot_cnt)) {
+      pending_slots_.erase(pending_slots_.find(pending_pages_[i]));
+      pending_pages_[i] = -1;
+    }
+  }
+}
+
+void DiskManager::Prepare(size_t epoch) {
+  std::scoped_lock latch(db_io_latch_);
+  if (pending_pages_.empty() && !meta_dirty_) {
+    return;
+  }
+  TrimSlots();
+  std::string meta = meta_dirty_ ? SerializeMeta() : "";
+  size_t count = pending_pages_.size();
+  size_t offset = count * page_size_;
+  WriteAll(pending_fd_, reinterpret_cast<const char *>(pending_pages_.data()), count * sizeof(int), offset);
+  offset += count * sizeof(int);
+  WriteAll(pending_fd_, meta.c_str(), meta.size(), offset);
+  offset += meta.size();
+  PendingTrailer trailer{PendingTrailer::kMagic, epoch, count, ref_cnt_.size(), meta.size(), page_size_};
+  WriteAll(pending_fd_, reinterpret_cast<const char *>(&trailer), sizeof(trailer), offset);
+  if (fsync(pending_fd_) != 0) {
+    throw std::exception();
+  }
+  num_flushes_ += 1;
+}
+
+void DiskManager::Apply() {
+  std::scoped_lock latch(db_io_latch_);
+  if (pending_pages_.empty() && !meta_dirty_) {
+    return;
+  }
+  TrimSlots();
+  ApplyPending(db_fd_, pending_fd_, pending_pages_, ref_cnt_.size(), page_size_, file_name_,
+               meta_dirty_ ? SerializeMeta() : "");
+  if (db_direct_fd_ != -1) {
+    // the copy went through the page cache, drop it again
+    posix_fadvise(db_fd_, 0, 0, POSIX_FADV_DONTNEED);
+  }
+  num_flushes_ += 2;
+  pending_slots_.clear();
+  pending_pages_.clear();
+  meta_dirty_ = false;
+}
+
+void DiskManager::Recover(const std::filesystem::path &db_file, size_t epoch) {
+  auto pending_file_name = PendingFileName(db_file);
+  if (!std::filesystem::exists(pending_file_name)) {
+    return;
+  }
+  size_t size = std::filesystem::file_size(pending_file_name);
+  if (size < sizeof(PendingTrailer)) {
+    return;
+  }
+  int pending_fd = OpenFile(pending_file_name);
+  PendingTrailer trailer;
+  ReadAll(pending_fd, reinterpret_cast<char *>(&trailer), sizeof(trailer), size - sizeof(trailer));
+  if (trailer.magic_ == PendingTrailer::kMagic && trailer.epoch_ == epoch &&
+      size == trailer.count_ * (trailer.page_size_ + sizeof(int)) + trailer.meta_size_ + sizeof(trailer)) {
+    vector<int> slots(trailer.count_);
+    size_t offset = trailer.count_ * trailer.page_size_;
+    ReadAll(pending_fd, reinterpret_cast<char *>(slots.data()), trailer.count_ * sizeof(int), offset);
+    offset += trailer.count_ * sizeof(int);
+    std::string meta(trailer.meta_size_, '\0');
+    ReadAll(pending_fd, meta.data(), meta.size(), offset);
+    int db_fd = OpenFile(db_file);
+    ApplyPending(db_fd, pending_fd, slots, trailer.slot_cnt_, trailer.page_size_, db_file, meta);
+    close(db_fd);
+  }
+  close(pending_fd);
 }
 
+/**
+ * Copy the pending pages into the database file in slot order, cut the free slots at the end, save the page tables if
+ * they changed, make it all durable, then empty the pending file. Applying the same pending file twice gives the same
+ * result, so a crash in the middle is harmless.
+ */
+void DiskManager::ApplyPending(int db_fd, int pending_fd, const vector<int> &slots, size_t slot_cnt, size_t page_size,
+                               const std::filesystem::path &db_file, const std::string &meta) {
+  map<int, size_t> pending_slots;
+  size_t count = slots.size();
+  for (size_t i = 0; i < count; ++i) {
+    if (slots[i] != -1) {
+      pending_slots[slots[i]] = i;
+    }
+  }
+  std::string page_data(page_size, '\0');
+  for (auto it = pending_slots.begin(); it != pending_slots.end(); ++it) {
+    ReadAll(pending_fd, page_data.data(), page_size, it->second * page_size);
+    WriteAll(db_fd, page_data.data(), page_size, static_cast<size_t>(it->first) * page_size);
+  }
+  if (ftruncate(db_fd, slot_cnt * page_size) != 0 || fsync(db_fd) != 0) {
+    throw std::exception();
+  }
+  if (!meta.empty()) {
+    ReplaceFile(MetaFileName(db_file), meta);
+  }
+  // the pending file must not be reused before the database file is durable, or a crash would lose pages
+  if (ftruncate(pending_fd, 0) != 0 || fsync(pending_fd) != 0) {
+    throw std::exception();
+  }
+}
+
+auto DiskManager::GetFileName() const -> std::string { return file_name_.string(); }
+
+auto DiskManager::GetPageSize() const -> size_t { return page_size_; }
+
 /**
  * Returns number of flushes made so far
  */
@@ -148,17 +626,13 @@ auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
 auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
 
 /**
- * Returns number of deletions made so far
+ * Returns number of reads made so far
  */
-auto DiskManager::GetNumDeletes() const -> int { return num_deletes_; }
+auto DiskManager::GetNumReads() const -> int { return num_reads_; }
 
 /**
- * Private helper function to get disk file size
+ * Returns number of deletions made so far
  */
-auto DiskManager::GetFileSize(const std::string &file_name) -> int {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
-}
+auto DiskManager::GetNumDeletes() const -> int { return num_deletes_; }
 
-}
\ No newline at end of file
+}
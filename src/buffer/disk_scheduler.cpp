@@ -0,0 +1,90 @@
+#include "buffer/disk_scheduler.h"
+
+namespace sjtu {
+
+DiskScheduler::DiskScheduler(std::shared_ptr<DiskManager> disk_manager, size_t worker_cnt)
+    : disk_manager_(std::move(disk_manager)) {
+  for (size_t i = 0; i < worker_cnt; ++i) {
+    workers_.emplace_back(std::thread(&DiskScheduler::WorkerLoop, this));
+  }
+}
+
+DiskScheduler::~DiskScheduler() {
+  {
+    std::scoped_lock latch(latch_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void DiskScheduler::Schedule(DiskRequest r) {
+  {
+    std::scoped_lock latch(latch_);
+    queue_.emplace_back(std::move(r));
+  }
+  queue_cv_.notify_one();
+}
+
+void DiskScheduler::Schedule(list<DiskRequest> *requests) {
+  {
+    std::scoped_lock latch(latch_);
+    for (auto &request : *requests) {
+      queue_.emplace_back(std::move(request));
+    }
+  }
+  queue_cv_.notify_one();
+}
+
+void DiskScheduler::WorkerLoop() {
+  std::unique_lock latch(latch_);
+  while (true) {
+    queue_cv_.wait(latch, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    list<DiskRequest> requests;
+    while (!queue_.empty()) {
+      requests.emplace_back(std::move(*queue_.begin()));
+      queue_.pop_front();
+    }
+    latch.unlock();
+    Run(&requests);
+    latch.lock();
+  }
+}
+
+/**
+ * @brief Run the requests in order. Consecutive writes are handed to the DiskManager at once.
+ */
+void DiskScheduler::Run(list<DiskRequest> *requests) {
+  vector<int> page_ids;
+  vector<const char *> data;
+  auto batch_begin = requests->begin();
+  for (auto it = requests->begin(); ; ++it) {
+    if (it != requests->end() && it->is_write_) {
+      page_ids.push_back(it->page_id_);
+      data.push_back(it->data_);
+      continue;
+    }
+    if (!page_ids.empty()) {
+      disk_manager_->WritePages(page_ids, data);
+      for (; batch_begin != it; ++batch_begin) {
+        batch_begin->callback_.set_value(true);
+      }
+      page_ids.clear();
+      data.clear();
+    }
+    if (it == requests->end()) {
+      return;
+    }
+    disk_manager_->ReadPage(it->page_id_, it->data_);
+    it->callback_.set_value(true);
+    batch_begin = it;
+    ++batch_begin;
+  }
+}
+
+}
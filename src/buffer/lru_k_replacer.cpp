@@ -72,10 +72,10 @@ auto LRUKReplacer::Evict() -> std::optional<int> {
  * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
  *
  * @param frame_id id of frame that received a new access.
- * @param access_type type of access that was received. This parameter is only needed for
- * leaderboard tests.
+ * @param page_id the page held by the frame, which LRU-k does not need.
+ * @param access_type a scan access is only recorded when it loads the frame, as the oldest possible one.
  */
-void LRUKReplacer::RecordAccess(int frame_id) {
+void LRUKReplacer::RecordAccess(int frame_id, int /*page_id*/, AccessType access_type) {
   ++current_timestamp_;
   if (frame_id > static_cast<int>(replacer_size_)) {
     throw std::exception();
@@ -83,8 +83,10 @@ void LRUKReplacer::RecordAccess(int frame_id) {
   if (node_store_.find(frame_id) == node_store_.end()) {
     node_store_[frame_id] = LRUKNode(k_);
     ++curr_size_;
+  } else if (access_type == AccessType::Scan) {
+    return;
   }
-  node_store_[frame_id].AddVisit(current_timestamp_);
+  node_store_[frame_id].AddVisit(access_type == AccessType::Scan ? 0 : current_timestamp_);
 }
 
 /**
@@ -0,0 +1,23 @@
+#include "buffer/replacer.h"
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
+
+namespace sjtu {
+
+auto MakeReplacer(ReplacerType type, size_t num_frames, size_t k) -> std::unique_ptr<Replacer> {
+  switch (type) {
+    case ReplacerType::CLOCK:
+      return std::make_unique<ClockReplacer>(num_frames);
+    case ReplacerType::TWO_Q:
+      return std::make_unique<TwoQueueReplacer>(num_frames);
+    case ReplacerType::ARC:
+      return std::make_unique<ArcReplacer>(num_frames);
+    default:
+      return std::make_unique<LRUKReplacer>(num_frames, k);
+  }
+}
+
+}
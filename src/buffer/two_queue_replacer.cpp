@@ -0,0 +1,122 @@
+#include "buffer/two_queue_replacer.h"
+
+#include <algorithm>
+
+#include "config.h"
+
+namespace sjtu {
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_frames)
+    : in_size_(std::max<size_t>(num_frames * TWO_Q_IN_PERCENT / 100, 1)),
+      out_size_(std::max<size_t>(num_frames * TWO_Q_OUT_PERCENT / 100, 1)),
+      in_(num_frames),
+      main_(num_frames),
+      page_ids_(num_frames, -1),
+      evictable_(num_frames, false) {}
+
+void TwoQueueReplacer::Clean() {
+  in_.Clear();
+  main_.Clear();
+  out_.Clear();
+  for (size_t i = 0; i < evictable_.size(); ++i) {
+    evictable_[i] = false;
+  }
+  evictable_size_ = 0;
+}
+
+auto TwoQueueReplacer::FindVictim(const FrameList &frames) const -> int {
+  int frame_id = frames.Back();
+  while (frame_id != -1 && !evictable_[frame_id]) {
+    frame_id = frames.Prev(frame_id);
+  }
+  return frame_id;
+}
+
+/**
+ * @brief Evict from A1in while it holds more than its share of the frames, and from Am otherwise. The victim of A1in
+ * is remembered in A1out.
+ */
+auto TwoQueueReplacer::Evict() -> std::optional<int> {
+  bool from_in = in_.Size() > in_size_;
+  int frame_id = FindVictim(from_in ? in_ : main_);
+  if (frame_id == -1) {
+    from_in = !from_in;
+    frame_id = FindVictim(from_in ? in_ : main_);
+    if (frame_id == -1) {
+      return std::nullopt;
+    }
+  }
+  if (from_in) {
+    in_.Erase(frame_id);
+    out_.PushFront(page_ids_[frame_id]);
+    if (out_.Size() > out_size_) {
+      out_.PopBack();
+    }
+  } else {
+    main_.Erase(frame_id);
+  }
+  evictable_[frame_id] = false;
+  --evictable_size_;
+  return frame_id;
+}
+
+/**
+ * @brief A hit in Am makes the frame the most recent one, a hit in A1in changes nothing. A page loaded into the frame
+ * enters Am if A1out remembers it, and A1in otherwise. A page loaded by a scan enters A1in as its oldest page, and
+ * is forgotten by A1out without being promoted.
+ */
+void TwoQueueReplacer::RecordAccess(int frame_id, int page_id, AccessType access_type) {
+  if (access_type == AccessType::Scan) {
+    if (!in_.Contains(frame_id) && !main_.Contains(frame_id)) {
+      page_ids_[frame_id] = page_id;
+      out_.Erase(page_id);
+      in_.PushBack(frame_id);
+    }
+    return;
+  }
+  if (main_.Contains(frame_id)) {
+    main_.Erase(frame_id);
+    main_.PushFront(frame_id);
+    return;
+  }
+  if (in_.Contains(frame_id)) {
+    return;
+  }
+  page_ids_[frame_id] = page_id;
+  if (out_.Erase(page_id)) {
+    main_.PushFront(frame_id);
+  } else {
+    in_.PushFront(frame_id);
+  }
+}
+
+void TwoQueueReplacer::SetEvictable(int frame_id, bool set_evictable) {
+  if ((!in_.Contains(frame_id) && !main_.Contains(frame_id)) || evictable_[frame_id] == set_evictable) {
+    return;
+  }
+  evictable_[frame_id] = set_evictable;
+  if (set_evictable) {
+    ++evictable_size_;
+  } else {
+    --evictable_size_;
+  }
+}
+
+void TwoQueueReplacer::Remove(int frame_id) {
+  FrameList *frames = in_.Contains(frame_id) ? &in_ : main_.Contains(frame_id) ? &main_ : nullptr;
+  if (frames == nullptr) {
+    return;
+  }
+  if (!evictable_[frame_id]) {
+    throw std::exception();
+  }
+  frames->Erase(frame_id);
+  evictable_[frame_id] = false;
+  --evictable_size_;
+}
+
+auto TwoQueueReplacer::Size() -> size_t {
+  return evictable_size_;
+}
+
+}
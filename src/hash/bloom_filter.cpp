@@ -0,0 +1,88 @@
+#include "hash/bloom_filter.h"
+
+#include <cstring>
+
+#include "config.h"
+
+namespace sjtu {
+
+// Odd multipliers that pick the bit of a key in each word of its block
+static constexpr uint32_t kSalts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                       0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+// The hashes of the index also pick its directories and buckets, so they are remixed before picking a block
+static auto Mix(unsigned hash) -> uint64_t {
+  uint64_t x = hash + 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+void BloomFilter::Reset(int capacity) {
+  capacity_ = capacity;
+  size_t bit_cnt = static_cast<size_t>(capacity) * BLOOM_FILTER_BITS_PER_KEY;
+  block_cnt_ = (bit_cnt + kBlockWords * 64 - 1) / (kBlockWords * 64);
+  words_ = std::make_unique<std::atomic<uint64_t>[]>(block_cnt_ * kBlockWords);
+  for (size_t i = 0; i < block_cnt_ * kBlockWords; ++i) {
+    words_[i].store(0, std::memory_order_relaxed);
+  }
+  key_cnt_ = 0;
+  is_dirty_ = true;
+}
+
+void BloomFilter::Add(unsigned hash) {
+  uint64_t mixed = Mix(hash);
+  auto block = &words_[((mixed >> 32) * block_cnt_ >> 32) * kBlockWords];
+  auto low = static_cast<uint32_t>(mixed);
+  bool changed = false;
+  for (int i = 0; i < kBlockWords; ++i) {
+    uint64_t bit = 1ULL << ((low * kSalts[i]) >> 26);
+    changed |= (block[i].fetch_or(bit) & bit) == 0;
+  }
+  key_cnt_.fetch_add(1, std::memory_order_relaxed);
+  if (changed && !is_dirty_.load(std::memory_order_relaxed)) {
+    is_dirty_ = true;
+  }
+}
+
+auto BloomFilter::MayContain(unsigned hash) const -> bool {
+  uint64_t mixed = Mix(hash);
+  auto block = &words_[((mixed >> 32) * block_cnt_ >> 32) * kBlockWords];
+  auto low = static_cast<uint32_t>(mixed);
+  for (int i = 0; i < kBlockWords; ++i) {
+    uint64_t bit = 1ULL << ((low * kSalts[i]) >> 26);
+    if ((block[i].load(std::memory_order_acquire) & bit) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto BloomFilter::GetCapacity() const -> int { return capacity_; }
+
+auto BloomFilter::GetKeyCnt() const -> int { return key_cnt_; }
+
+void BloomFilter::SetKeyCnt(int key_cnt) { key_cnt_ = key_cnt; }
+
+auto BloomFilter::GetByteCnt() const -> size_t { return block_cnt_ * kBlockWords * sizeof(uint64_t); }
+
+void BloomFilter::CopyTo(size_t offset, size_t size, char *data) const {
+  for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+    uint64_t word = words_[(offset + i) / sizeof(uint64_t)].load(std::memory_order_relaxed);
+    memcpy(data + i, &word, sizeof(uint64_t));
+  }
+}
+
+void BloomFilter::CopyFrom(size_t offset, size_t size, const char *data) {
+  for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(uint64_t));
+    words_[(offset + i) / sizeof(uint64_t)].store(word, std::memory_order_relaxed);
+  }
+}
+
+auto BloomFilter::IsDirty() const -> bool { return is_dirty_; }
+
+void BloomFilter::SetClean() { is_dirty_ = false; }
+
+}
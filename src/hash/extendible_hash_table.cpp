@@ -0,0 +1,609 @@
+#include "hash/extendible_hash_table.h"
+
+#include <cstring>
+#include <string>
+
+#include "comparator.h"
+#include "system/user_system/user.h"
+#include "system/train_system/train.h"
+#include "heap_file/heap_file.h"
+
+namespace sjtu {
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+HASH_TABLE_TYPE::ExtendibleHashTable(std::string name, ReplacerType replacer_type, int bucket_max_size,
+                                          int directory_max_depth)
+    : index_name_(std::move(name)),
+      disk_manager_(std::make_shared<DiskManager>(index_name_, DIRECT_IO, PageSize)),
+      bpm_(new BufferPoolManager(INDEX_BUFFER_POOL_SIZE, disk_manager_, LRUK_REPLACER_K, 0, replacer_type)),
+      bucket_max_size_(bucket_max_size),
+      directory_max_depth_(directory_max_depth),
+      header_page_id_(bpm_->NewPage()) {
+  // an existing header page is only read, so that opening a table does not copy a header page shared with snapshots
+  auto guard = bpm_->ReadPage(header_page_id_);
+  if (guard.As<HashTableHeaderPage>()->max_depth_ == 0) {
+    guard.Drop();
+    bpm_->WritePage(header_page_id_).AsMut<HashTableHeaderPage>()->Init();
+  } else {
+    bpm_->InitPageCnt(guard.As<HashTableHeaderPage>()->page_cnt_);
+    size_ = guard.As<HashTableHeaderPage>()->size_;
+    entry_cnt_ = guard.As<HashTableHeaderPage>()->entry_cnt_;
+    guard.Drop();
+  }
+  LoadFilter();
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+HASH_TABLE_TYPE::~ExtendibleHashTable() {
+  SaveFilter();
+  SaveHeader();
+  bpm_->FlushAllPages();
+  // a table owned by a System has nothing new here since its final checkpoint
+  disk_manager_->Apply();
+  delete bpm_;
+}
+
+/**
+ * @brief First phase of a checkpoint: write back every dirty page and make them durable in the pending file.
+ *
+ * @param epoch the epoch of the checkpoint
+ * @param[out] files the database files prepared by this checkpoint
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::PrepareCheckpoint(size_t epoch, vector<std::string> *files) {
+  SaveFilter();
+  SaveHeader();
+  bpm_->FlushAllPages();
+  disk_manager_->Prepare(epoch);
+  files->push_back(disk_manager_->GetFileName());
+}
+
+/**
+ * @brief Second phase of a checkpoint, once it is committed: move the prepared pages into the database file.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::ApplyCheckpoint() {
+  disk_manager_->Apply();
+}
+
+/**
+ * @brief Save the page counter and the entry counters in the header page. The header page is left clean if they are
+ * unchanged, so a snapshot of an unchanged table does not copy it.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::SaveHeader() {
+  int page_cnt = bpm_->PageCnt();
+  int size = size_;
+  int entry_cnt = entry_cnt_;
+  auto guard = bpm_->ReadPage(header_page_id_);
+  auto header_page = guard.As<HashTableHeaderPage>();
+  if (header_page->page_cnt_ == page_cnt && header_page->size_ == size && header_page->entry_cnt_ == entry_cnt) {
+    return;
+  }
+  guard.Drop();
+  auto write_guard = bpm_->WritePage(header_page_id_);
+  write_guard.AsMut<HashTableHeaderPage>()->page_cnt_ = page_cnt;
+  write_guard.AsMut<HashTableHeaderPage>()->size_ = size;
+  write_guard.AsMut<HashTableHeaderPage>()->entry_cnt_ = entry_cnt;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::CreateSnapshot(const std::string &name) -> bool {
+  SaveFilter();
+  SaveHeader();
+  return bpm_->CreateSnapshot(name);
+}
+
+/**
+ * @brief Switch to a snapshot. Page ids are allocated from where the snapshot left off.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::SwitchSnapshot(const std::string &name) -> bool {
+  if (!bpm_->SwitchSnapshot(name)) {
+    return false;
+  }
+  auto guard = bpm_->ReadPage(header_page_id_);
+  bpm_->InitPageCnt(guard.As<HashTableHeaderPage>()->page_cnt_);
+  size_ = guard.As<HashTableHeaderPage>()->size_;
+  entry_cnt_ = guard.As<HashTableHeaderPage>()->entry_cnt_;
+  guard.Drop();
+  LoadFilter();
+  return true;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::DropSnapshot(const std::string &name) -> bool {
+  return bpm_->DropSnapshot(name);
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::CollectStats(vector<FileStats> *stats) {
+  auto file_stats = bpm_->GetStats();
+  file_stats.entry_cnt_ = entry_cnt_;
+  file_stats.filter_byte_cnt_ = static_cast<int>(filter_.GetByteCnt());
+  file_stats.filter_negative_cnt_ = filter_negative_cnt_;
+  file_stats.filter_false_positive_cnt_ = filter_false_positive_cnt_;
+  stats->push_back(file_stats);
+}
+
+/**
+ * @brief Save the filter in consecutive pages of the table. A resized filter gets new pages, and only the pages whose
+ * bits changed are written, so a snapshot of an unchanged filter does not copy them.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::SaveFilter() {
+  if (filter_.GetKeyCnt() > filter_.GetCapacity()) {
+    RebuildFilter();
+  }
+  auto guard = bpm_->ReadPage(header_page_id_);
+  auto header_page = guard.As<HashTableHeaderPage>();
+  int filter_page_id = header_page->filter_page_id_;
+  int filter_page_cnt = header_page->filter_page_cnt_;
+  guard.Drop();
+  if (filter_.IsDirty()) {
+    size_t byte_cnt = filter_.GetByteCnt();
+    int page_cnt = static_cast<int>((byte_cnt + PageSize - 1) / PageSize);
+    if (filter_page_id == -1 || page_cnt != filter_page_cnt) {
+      for (int i = 0; i < filter_page_cnt; ++i) {
+        bpm_->DeletePage(filter_page_id + i);
+      }
+      // no other operation runs meanwhile, so the new pages are consecutive
+      filter_page_id = bpm_->NewPage();
+      for (int i = 1; i < page_cnt; ++i) {
+        bpm_->NewPage();
+      }
+      filter_page_cnt = page_cnt;
+    }
+    char buffer[PageSize];
+    for (int i = 0; i < page_cnt; ++i) {
+      size_t offset = static_cast<size_t>(i) * PageSize;
+      size_t size = std::min(static_cast<size_t>(PageSize), byte_cnt - offset);
+      filter_.CopyTo(offset, size, buffer);
+      auto read_guard = bpm_->ReadPage(filter_page_id + i);
+      if (memcmp(read_guard.GetData(), buffer, size) == 0) {
+        continue;
+      }
+      read_guard.Drop();
+      memcpy(bpm_->WritePage(filter_page_id + i).GetDataMut(), buffer, size);
+    }
+    filter_.SetClean();
+  }
+  guard = bpm_->ReadPage(header_page_id_);
+  header_page = guard.As<HashTableHeaderPage>();
+  if (header_page->filter_page_id_ == filter_page_id && header_page->filter_page_cnt_ == filter_page_cnt &&
+      header_page->filter_capacity_ == filter_.GetCapacity() && header_page->filter_key_cnt_ == filter_.GetKeyCnt()) {
+    return;
+  }
+  guard.Drop();
+  auto write_guard = bpm_->WritePage(header_page_id_);
+  auto mut_header_page = write_guard.AsMut<HashTableHeaderPage>();
+  mut_header_page->filter_page_id_ = filter_page_id;
+  mut_header_page->filter_page_cnt_ = filter_page_cnt;
+  mut_header_page->filter_capacity_ = filter_.GetCapacity();
+  mut_header_page->filter_key_cnt_ = filter_.GetKeyCnt();
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::LoadFilter() {
+  auto guard = bpm_->ReadPage(header_page_id_);
+  auto header_page = guard.As<HashTableHeaderPage>();
+  if (header_page->filter_page_id_ == -1) {
+    guard.Drop();
+    RebuildFilter();
+    return;
+  }
+  int filter_page_id = header_page->filter_page_id_;
+  filter_.Reset(header_page->filter_capacity_);
+  filter_.SetKeyCnt(header_page->filter_key_cnt_);
+  guard.Drop();
+  size_t byte_cnt = filter_.GetByteCnt();
+  for (size_t offset = 0; offset < byte_cnt; offset += PageSize) {
+    size_t size = std::min(static_cast<size_t>(PageSize), byte_cnt - offset);
+    filter_.CopyFrom(offset, size, bpm_->ReadPage(filter_page_id + static_cast<int>(offset / PageSize)).GetData());
+  }
+  filter_.SetClean();
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::RebuildFilter() {
+  filter_.Reset(std::max(2 * entry_cnt_.load(), BLOOM_FILTER_MIN_KEYS));
+  auto header_guard = bpm_->ReadPage(header_page_id_);
+  auto header_page = header_guard.As<HashTableHeaderPage>();
+  for (int directory_idx = 0; directory_idx < HASH_TABLE_HEADER_ARRAY_SIZE; ++directory_idx) {
+    int directory_page_id = header_page->directory_page_ids_[directory_idx];
+    if (directory_page_id == -1 ||
+        (directory_idx > 0 && header_page->directory_page_ids_[directory_idx - 1] == directory_page_id)) {
+      continue;
+    }
+    auto directory_guard = bpm_->ReadPage(directory_page_id);
+    auto directory = directory_guard.As<DirectoryPage>();
+    for (int i = 0; i < directory->Size(); ++i) {
+      // a bucket is shared by the slots with the same lowest local depth bits, visit it from the first one
+      if (static_cast<unsigned>(i) >> directory->GetLocalDepth(i) != 0) {
+        continue;
+      }
+      ReadPageGuard bucket_guard = bpm_->ReadPage(directory->GetBucketPageId(i));
+      auto bucket = bucket_guard.As<BucketPage>();
+      for (int j = 0; j < bucket->Size(); ++j) {
+        filter_.Add(Hash(bucket->KeyAt(j)));
+      }
+    }
+  }
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::IsEmpty() const -> bool { return entry_cnt_ == 0; }
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::Hash(const KeyType &key) const -> unsigned { return hasher_(key); }
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/**
+ * @brief Return the only value that associated with input key
+ *
+ * The read latch of a page is released as soon as the latch of the next one is held, so a lookup holds at most two
+ * latches and reads exactly one bucket.
+ *
+ * @param key input key
+ * @param[out] result vector that stores the only value that associated with input key, if the value exists
+ * @return : true means key exists
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::GetValue(const KeyType &key, vector<ValueType> *result) -> bool {
+  unsigned hash = Hash(key);
+  if (!filter_.MayContain(hash)) {
+    filter_negative_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  auto header_guard = bpm_->ReadPage(header_page_id_);
+  auto header_page = header_guard.As<HashTableHeaderPage>();
+  int directory_page_id = header_page->directory_page_ids_[header_page->HashToDirectoryIndex(hash)];
+  if (directory_page_id == -1) {
+    filter_false_positive_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  auto directory_guard = bpm_->ReadPage(directory_page_id);
+  header_guard.Drop();
+  auto directory = directory_guard.As<DirectoryPage>();
+  ReadPageGuard bucket_guard = bpm_->ReadPage(directory->GetBucketPageId(directory->HashToBucketIndex(hash)));
+  directory_guard.Drop();
+  ValueType value;
+  if (!bucket_guard.As<BucketPage>()->Lookup(key, &value, comparator_)) {
+    filter_false_positive_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  result->push_back(value);
+  return true;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/**
+ * @brief Insert constant key & value pair into the hash table
+ *
+ * A full bucket is split in two by the next bit of the hashes, doubling the directory first if the bucket is already
+ * as deep as it. A directory that cannot grow any more is split in two by the next highest bit of the hashes, which
+ * changes the header page: the insert then starts over with the header page write latched. Pages are only made dirty
+ * when they change, so a failed insert leaves every page clean.
+ *
+ * @param key the key to insert
+ * @param value the value associated with key
+ * @return false if the key exists, or if its bucket is full and neither the directory nor the header can grow
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool {
+  unsigned hash = Hash(key);
+  bool pessimistic = false;
+  WritePageGuard header_write_guard;
+  while (true) {
+    ReadPageGuard header_guard;
+    const HashTableHeaderPage *header_page;
+    if (pessimistic) {
+      header_page = header_write_guard.As<HashTableHeaderPage>();
+    } else {
+      header_guard = bpm_->ReadPage(header_page_id_);
+      header_page = header_guard.As<HashTableHeaderPage>();
+    }
+    int directory_page_id = header_page->directory_page_ids_[header_page->HashToDirectoryIndex(hash)];
+    if (directory_page_id == -1 && !pessimistic) {
+      header_guard.Drop();
+      header_write_guard = bpm_->WritePage(header_page_id_);
+      pessimistic = true;
+      continue;
+    }
+    if (directory_page_id == -1) {
+      // the first key of the table: a single directory holds every key until it is full
+      int bucket_page_id = bpm_->NewPage();
+      bpm_->WritePage(bucket_page_id).AsMut<BucketPage>()->Init(bucket_max_size_);
+      directory_page_id = bpm_->NewPage();
+      bpm_->WritePage(directory_page_id).AsMut<DirectoryPage>()->Init(bucket_page_id, directory_max_depth_);
+      auto mut_header_page = header_write_guard.AsMut<HashTableHeaderPage>();
+      for (int i = 0; i < HASH_TABLE_HEADER_ARRAY_SIZE; ++i) {
+        mut_header_page->directory_page_ids_[i] = directory_page_id;
+      }
+    }
+    WritePageGuard directory_guard = bpm_->WritePage(directory_page_id);
+    header_guard.Drop();
+    auto directory = directory_guard.As<DirectoryPage>();
+    int bucket_idx = directory->HashToBucketIndex(hash);
+    WritePageGuard bucket_guard = bpm_->WritePage(directory->GetBucketPageId(bucket_idx));
+    ValueType tmp;
+    if (bucket_guard.As<BucketPage>()->Lookup(key, &tmp, comparator_)) {
+      return false;
+    }
+    bool directory_full = false;
+    while (bucket_guard.As<BucketPage>()->IsFull()) {
+      int local_depth = directory->GetLocalDepth(bucket_idx);
+      if (local_depth == directory->GetGlobalDepth()) {
+        if (local_depth == directory->GetMaxDepth()) {
+          directory_full = true;
+          break;
+        }
+        directory_guard.AsMut<DirectoryPage>()->IncrGlobalDepth();
+      }
+      // the slots and the entries whose bit local_depth is set move to the split image
+      unsigned mask = 1U << local_depth;
+      int bucket_page_id = bucket_guard.GetPageId();
+      int image_page_id = bpm_->NewPage();
+      auto image_guard = bpm_->WritePage(image_page_id);
+      auto image = image_guard.AsMut<BucketPage>();
+      image->Init(bucket_max_size_);
+      auto mut_directory = directory_guard.AsMut<DirectoryPage>();
+      for (int i = 0; i < mut_directory->Size(); ++i) {
+        if (mut_directory->GetBucketPageId(i) == bucket_page_id) {
+          mut_directory->SetLocalDepth(i, local_depth + 1);
+          if ((i & mask) != 0) {
+            mut_directory->SetBucketPageId(i, image_page_id);
+          }
+        }
+      }
+      auto bucket = bucket_guard.AsMut<BucketPage>();
+      for (int i = 0; i < bucket->Size();) {
+        if ((Hash(bucket->KeyAt(i)) & mask) != 0) {
+          image->Insert(bucket->KeyAt(i), bucket->ValueAt(i), comparator_);
+          bucket->RemoveAt(i);
+        } else {
+          ++i;
+        }
+      }
+      if ((hash & mask) != 0) {
+        bucket_guard = std::move(image_guard);
+      }
+      bucket_idx = directory->HashToBucketIndex(hash);
+    }
+    if (!directory_full) {
+      // the key is in the filter before it is in the bucket, so a lookup never misses it
+      filter_.Add(hash);
+      bucket_guard.AsMut<BucketPage>()->Insert(key, value, comparator_);
+      ++size_;
+      ++entry_cnt_;
+      return true;
+    }
+    bucket_guard.Drop();
+    if (!pessimistic) {
+      directory_guard.Drop();
+      header_write_guard = bpm_->WritePage(header_page_id_);
+      pessimistic = true;
+      continue;
+    }
+    if (directory->GetHeaderDepth() == header_page->max_depth_) {
+      return false;
+    }
+    SplitDirectory(header_write_guard.AsMut<HashTableHeaderPage>(), &directory_guard);
+  }
+}
+
+/**
+ * @brief Split a directory by the next highest bit of the hashes. The image copies the shape of the directory, and
+ * every bucket gives the keys whose bit is set to a new bucket of the image, so both directories keep their depths.
+ *
+ * The caller holds the write latches of the header page and of the directory, so no one else can reach its buckets.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::SplitDirectory(HashTableHeaderPage *header_page, WritePageGuard *directory_guard) {
+  int directory_page_id = directory_guard->GetPageId();
+  auto directory = directory_guard->AsMut<DirectoryPage>();
+  int header_depth = directory->GetHeaderDepth();
+  int image_page_id = bpm_->NewPage();
+  auto image_guard = bpm_->WritePage(image_page_id);
+  memcpy(image_guard.GetDataMut(), directory, sizeof(DirectoryPage));
+  auto image = image_guard.AsMut<DirectoryPage>();
+  directory->SetHeaderDepth(header_depth + 1);
+  image->SetHeaderDepth(header_depth + 1);
+  unsigned mask = 1U << (31 - header_depth);
+  for (int i = 0; i < directory->Size(); ++i) {
+    int local_depth = directory->GetLocalDepth(i);
+    if ((i >> local_depth) != 0) {
+      continue;
+    }
+    int image_bucket_page_id = bpm_->NewPage();
+    auto image_bucket_guard = bpm_->WritePage(image_bucket_page_id);
+    auto image_bucket = image_bucket_guard.AsMut<BucketPage>();
+    image_bucket->Init(bucket_max_size_);
+    WritePageGuard bucket_guard = bpm_->WritePage(directory->GetBucketPageId(i));
+    auto bucket = bucket_guard.AsMut<BucketPage>();
+    for (int j = 0; j < bucket->Size();) {
+      if ((Hash(bucket->KeyAt(j)) & mask) != 0) {
+        image_bucket->Insert(bucket->KeyAt(j), bucket->ValueAt(j), comparator_);
+        bucket->RemoveAt(j);
+      } else {
+        ++j;
+      }
+    }
+    for (int j = i; j < image->Size(); j += 1 << local_depth) {
+      image->SetBucketPageId(j, image_bucket_page_id);
+    }
+  }
+  int shift = header_page->max_depth_ - 1 - header_depth;
+  for (int i = 0; i < HASH_TABLE_HEADER_ARRAY_SIZE; ++i) {
+    if (header_page->directory_page_ids_[i] == directory_page_id && ((i >> shift) & 1) != 0) {
+      header_page->directory_page_ids_[i] = image_page_id;
+    }
+  }
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/**
+ * @brief Delete key & value pair associated with input key
+ *
+ * A bucket is merged with its split image while both have the same local depth and their entries fit in half a
+ * bucket, so that a remove and an insert around the threshold do not split and merge the same bucket again and again.
+ * The directory shrinks once no bucket is as deep as it.
+ *
+ * @param key input key
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::Remove(const KeyType &key) {
+  unsigned hash = Hash(key);
+  if (!filter_.MayContain(hash)) {
+    filter_negative_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto header_guard = bpm_->ReadPage(header_page_id_);
+  auto header_page = header_guard.As<HashTableHeaderPage>();
+  int directory_page_id = header_page->directory_page_ids_[header_page->HashToDirectoryIndex(hash)];
+  if (directory_page_id == -1) {
+    return;
+  }
+  auto directory_guard = bpm_->WritePage(directory_page_id);
+  header_guard.Drop();
+  auto directory = directory_guard.As<DirectoryPage>();
+  int bucket_idx = directory->HashToBucketIndex(hash);
+  WritePageGuard bucket_guard = bpm_->WritePage(directory->GetBucketPageId(bucket_idx));
+  ValueType tmp;
+  if (!bucket_guard.As<BucketPage>()->Lookup(key, &tmp, comparator_)) {
+    return;
+  }
+  bucket_guard.AsMut<BucketPage>()->Remove(key, comparator_);
+  --entry_cnt_;
+  while (true) {
+    int local_depth = directory->GetLocalDepth(bucket_idx);
+    if (local_depth == 0) {
+      return;
+    }
+    int image_idx = bucket_idx ^ (1 << (local_depth - 1));
+    if (directory->GetLocalDepth(image_idx) != local_depth) {
+      return;
+    }
+    int bucket_page_id = bucket_guard.GetPageId();
+    int image_page_id = directory->GetBucketPageId(image_idx);
+    auto image_guard = bpm_->WritePage(image_page_id);
+    auto image = image_guard.As<BucketPage>();
+    if (bucket_guard.As<BucketPage>()->Size() + image->Size() > bucket_max_size_ / 2) {
+      return;
+    }
+    auto bucket = bucket_guard.AsMut<BucketPage>();
+    for (int i = 0; i < image->Size(); ++i) {
+      bucket->Insert(image->KeyAt(i), image->ValueAt(i), comparator_);
+    }
+    image_guard.Drop();
+    auto mut_directory = directory_guard.AsMut<DirectoryPage>();
+    for (int i = 0; i < mut_directory->Size(); ++i) {
+      if (mut_directory->GetBucketPageId(i) == bucket_page_id || mut_directory->GetBucketPageId(i) == image_page_id) {
+        mut_directory->SetBucketPageId(i, bucket_page_id);
+        mut_directory->SetLocalDepth(i, local_depth - 1);
+      }
+    }
+    // no one else can reach the image any more: every path to it goes through the directory we hold
+    bpm_->DeletePage(image_page_id);
+    while (mut_directory->CanShrink()) {
+      mut_directory->DecrGlobalDepth();
+    }
+    bucket_idx = directory->HashToBucketIndex(hash);
+  }
+}
+
+/**
+ * @brief Check that every directory is consistent with the local depths of its buckets, that every key is in the
+ * bucket its hash leads to and in the filter, and that the entry counter matches the entries.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::CheckIntegrity() -> bool {
+  auto header_guard = bpm_->ReadPage(header_page_id_);
+  auto header_page = header_guard.As<HashTableHeaderPage>();
+  int entry_cnt = 0;
+  for (int directory_idx = 0; directory_idx < HASH_TABLE_HEADER_ARRAY_SIZE; ++directory_idx) {
+    int directory_page_id = header_page->directory_page_ids_[directory_idx];
+    // the slots of a directory are consecutive, and the first of them checks it
+    if (directory_page_id == -1 ||
+        (directory_idx > 0 && header_page->directory_page_ids_[directory_idx - 1] == directory_page_id)) {
+      continue;
+    }
+    auto directory_guard = bpm_->ReadPage(directory_page_id);
+    auto directory = directory_guard.As<DirectoryPage>();
+    if (directory->GetGlobalDepth() > directory->GetMaxDepth() || directory->CanShrink()) {
+      return false;
+    }
+    int slot_cnt = 1 << (header_page->max_depth_ - directory->GetHeaderDepth());
+    if (directory_idx % slot_cnt != 0 || (directory_idx + slot_cnt < HASH_TABLE_HEADER_ARRAY_SIZE &&
+                                          header_page->directory_page_ids_[directory_idx + slot_cnt] == directory_page_id)) {
+      return false;
+    }
+    for (int i = directory_idx; i < directory_idx + slot_cnt; ++i) {
+      if (header_page->directory_page_ids_[i] != directory_page_id) {
+        return false;
+      }
+    }
+    for (int i = 0; i < directory->Size(); ++i) {
+      int local_depth = directory->GetLocalDepth(i);
+      int bucket_page_id = directory->GetBucketPageId(i);
+      if (local_depth > directory->GetGlobalDepth()) {
+        return false;
+      }
+      // the slots sharing the lowest local_depth bits share the bucket, and the first of them checks its entries
+      unsigned local_mask = (1U << local_depth) - 1;
+      for (int j = 0; j < directory->Size(); ++j) {
+        bool same_bucket = directory->GetBucketPageId(j) == bucket_page_id;
+        if (same_bucket != ((j & local_mask) == (i & local_mask)) ||
+            (same_bucket && directory->GetLocalDepth(j) != local_depth)) {
+          return false;
+        }
+      }
+      if (static_cast<unsigned>(i) != (i & local_mask)) {
+        continue;
+      }
+      ReadPageGuard bucket_guard = bpm_->ReadPage(bucket_page_id);
+      auto bucket = bucket_guard.As<BucketPage>();
+      if (bucket->Size() > bucket->GetMaxSize()) {
+        return false;
+      }
+      for (int j = 0; j < bucket->Size(); ++j) {
+        unsigned hash = Hash(bucket->KeyAt(j));
+        if (header_page->directory_page_ids_[header_page->HashToDirectoryIndex(hash)] != directory_page_id ||
+            (hash & local_mask) != (i & local_mask) ||
+            !filter_.MayContain(hash)) {
+          return false;
+        }
+      }
+      entry_cnt += bucket->Size();
+    }
+  }
+  return entry_cnt == entry_cnt_;
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::Clean() {
+  bpm_->Clean();
+  header_page_id_ = bpm_->NewPage();
+  bpm_->WritePage(header_page_id_).AsMut<HashTableHeaderPage>()->Init();
+  size_ = 0;
+  entry_cnt_ = 0;
+  filter_.Reset(BLOOM_FILTER_MIN_KEYS);
+}
+
+HASH_TABLE_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_TYPE::GetSize() const -> int {
+  return size_;
+}
+
+template class ExtendibleHashTable<Key, int, Comparator>;
+template class ExtendibleHashTable<array<char, 20>, Rid, UserComparator>;
+template class ExtendibleHashTable<array<char, 20>, int, TrainComparator>;
+template class ExtendibleHashTable<array<unsigned int, 10>, int, StationComparator>;
+
+}
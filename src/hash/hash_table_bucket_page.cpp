@@ -0,0 +1,85 @@
+#include <string>
+
+#include "hash/hash_table_bucket_page.h"
+
+#include "comparator.h"
+#include "system/user_system/user.h"
+#include "system/train_system/train.h"
+#include "heap_file/heap_file.h"
+
+namespace sjtu {
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::Init(int max_size) {
+  size_ = 0;
+  max_size_ = max_size;
+}
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, KeyComparator &comparator) const
+    -> bool {
+  for (int i = 0; i < size_; ++i) {
+    if (comparator(key_array_[i], key) == 0) {
+      *value = value_array_[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, KeyComparator &comparator)
+    -> bool {
+  for (int i = 0; i < size_; ++i) {
+    if (comparator(key_array_[i], key) == 0) {
+      return false;
+    }
+  }
+  key_array_[size_] = key;
+  value_array_[size_] = value;
+  ++size_;
+  return true;
+}
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::Remove(const KeyType &key, KeyComparator &comparator) -> bool {
+  for (int i = 0; i < size_; ++i) {
+    if (comparator(key_array_[i], key) == 0) {
+      RemoveAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::RemoveAt(int index) {
+  --size_;
+  key_array_[index] = key_array_[size_];
+  value_array_[index] = value_array_[size_];
+}
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::KeyAt(int index) const -> KeyType { return key_array_[index]; }
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::ValueAt(int index) const -> ValueType { return value_array_[index]; }
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::Size() const -> int { return size_; }
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::GetMaxSize() const -> int { return max_size_; }
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::IsFull() const -> bool { return size_ == max_size_; }
+
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+auto HASH_TABLE_BUCKET_PAGE_TYPE::IsEmpty() const -> bool { return size_ == 0; }
+
+template class HashTableBucketPage<Key, int, Comparator, POINT_INDEX_PAGE_SIZE>;
+template class HashTableBucketPage<array<char, 20>, Rid, UserComparator, POINT_INDEX_PAGE_SIZE>;
+template class HashTableBucketPage<array<char, 20>, int, TrainComparator, POINT_INDEX_PAGE_SIZE>;
+template class HashTableBucketPage<array<unsigned int, 10>, int, StationComparator, POINT_INDEX_PAGE_SIZE>;
+
+}
@@ -0,0 +1,95 @@
+#include "hash/hash_table_directory_page.h"
+
+namespace sjtu {
+
+template <int PageSize>
+void HashTableDirectoryPage<PageSize>::Init(int bucket_page_id, int max_depth) {
+  max_depth_ = max_depth;
+  global_depth_ = 0;
+  header_depth_ = 0;
+  local_depths_[0] = 0;
+  bucket_page_ids_[0] = bucket_page_id;
+}
+
+template <int PageSize>
+auto HashTableDirectoryPage<PageSize>::HashToBucketIndex(unsigned hash) const -> int {
+  return static_cast<int>(hash & ((1U << global_depth_) - 1));
+}
+
+template <int PageSize>
+auto HashTableDirectoryPage<PageSize>::GetBucketPageId(int bucket_idx) const -> int {
+  return bucket_page_ids_[bucket_idx];
+}
+
+template <int PageSize>
+void HashTableDirectoryPage<PageSize>::SetBucketPageId(int bucket_idx, int bucket_page_id) {
+  bucket_page_ids_[bucket_idx] = bucket_page_id;
+}
+
+template <int PageSize>
+auto HashTableDirectoryPage<PageSize>::GetLocalDepth(int bucket_idx) const -> int {
+  return local_depths_[bucket_idx];
+}
+
+template <int PageSize>
+void HashTableDirectoryPage<PageSize>::SetLocalDepth(int bucket_idx, int local_depth) {
+  local_depths_[bucket_idx] = static_cast<uint8_t>(local_depth);
+}
+
+template <int PageSize>
+auto HashTableDirectoryPage<PageSize>::GetGlobalDepth() const -> int {
+  return global_depth_;
+}
+
+template <int PageSize>
+auto HashTableDirectoryPage<PageSize>::GetMaxDepth() const -> int {
+  return max_depth_;
+}
+
+template <int PageSize>
+auto HashTableDirectoryPage<PageSize>::GetHeaderDepth() const -> int {
+  return header_depth_;
+}
+
+template <int PageSize>
+void HashTableDirectoryPage<PageSize>::SetHeaderDepth(int header_depth) {
+  header_depth_ = header_depth;
+}
+
+template <int PageSize>
+void HashTableDirectoryPage<PageSize>::IncrGlobalDepth() {
+  int size = Size();
+  for (int i = 0; i < size; ++i) {
+    local_depths_[size + i] = local_depths_[i];
+    bucket_page_ids_[size + i] = bucket_page_ids_[i];
+  }
+  ++global_depth_;
+}
+
+template <int PageSize>
+void HashTableDirectoryPage<PageSize>::DecrGlobalDepth() {
+  --global_depth_;
+}
+
+template <int PageSize>
+auto HashTableDirectoryPage<PageSize>::CanShrink() const -> bool {
+  if (global_depth_ == 0) {
+    return false;
+  }
+  int size = Size();
+  for (int i = 0; i < size; ++i) {
+    if (local_depths_[i] == global_depth_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <int PageSize>
+auto HashTableDirectoryPage<PageSize>::Size() const -> int {
+  return 1 << global_depth_;
+}
+
+template class HashTableDirectoryPage<POINT_INDEX_PAGE_SIZE>;
+
+}
@@ -0,0 +1,114 @@
+#include "heap_file/heap_file.h"
+
+#include <cstring>
+
+namespace sjtu {
+
+HeapFile::HeapFile(std::string name, ReplacerType replacer_type, size_t page_size)
+    : disk_manager_(std::make_shared<DiskManager>(std::move(name), DIRECT_IO, page_size)),
+      bpm_(std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_, LRUK_REPLACER_K, 0, replacer_type)),
+      page_size_(page_size),
+      header_page_id_(bpm_->NewPage()) {
+  // a fresh header page is all zero, and page 0 is never a heap page
+  auto guard = bpm_->ReadPage(header_page_id_);
+  if (guard.As<HeapFileHeaderPage>()->last_page_id_ == 0) {
+    guard.Drop();
+    bpm_->WritePage(header_page_id_).AsMut<HeapFileHeaderPage>()->last_page_id_ = -1;
+  } else {
+    bpm_->InitPageCnt(guard.As<HeapFileHeaderPage>()->page_cnt_);
+  }
+}
+
+HeapFile::~HeapFile() {
+  SavePageCnt();
+  bpm_->FlushAllPages();
+  disk_manager_->Apply();
+}
+
+/**
+ * @brief Append a record to the last page, or to a new page if the last one is full.
+ *
+ * @return the record id of the record
+ */
+auto HeapFile::Insert(const char *data, size_t size) -> Rid {
+  std::scoped_lock latch(latch_);
+  int last_page_id = bpm_->ReadPage(header_page_id_).As<HeapFileHeaderPage>()->last_page_id_;
+  if (last_page_id != -1) {
+    int slot = bpm_->WritePage(last_page_id).AsMut<HeapPage>()->InsertRecord(data, size);
+    if (slot != -1) {
+      return {last_page_id, slot};
+    }
+  }
+  int page_id = bpm_->NewPage();
+  auto guard = bpm_->WritePage(page_id);
+  auto page = guard.AsMut<HeapPage>();
+  page->Init(page_size_);
+  int slot = page->InsertRecord(data, size);
+  if (slot == -1) {
+    throw std::exception();
+  }
+  bpm_->WritePage(header_page_id_).AsMut<HeapFileHeaderPage>()->last_page_id_ = page_id;
+  return {page_id, slot};
+}
+
+void HeapFile::Read(const Rid &rid, char *data, size_t offset, size_t size) {
+  auto guard = bpm_->ReadPage(rid.page_id_);
+  memcpy(data, guard.As<HeapPage>()->GetRecord(rid.slot_) + offset, size);
+}
+
+void HeapFile::Update(const Rid &rid, const char *data, size_t offset, size_t size) {
+  auto guard = bpm_->WritePage(rid.page_id_);
+  memcpy(guard.AsMut<HeapPage>()->GetRecordMut(rid.slot_) + offset, data, size);
+}
+
+void HeapFile::Clean() {
+  std::scoped_lock latch(latch_);
+  bpm_->Clean();
+  header_page_id_ = bpm_->NewPage();
+  auto guard = bpm_->WritePage(header_page_id_);
+  auto header_page = guard.AsMut<HeapFileHeaderPage>();
+  header_page->page_cnt_ = 0;
+  header_page->last_page_id_ = -1;
+}
+
+void HeapFile::PrepareCheckpoint(size_t epoch, vector<std::string> *files) {
+  SavePageCnt();
+  bpm_->FlushAllPages();
+  disk_manager_->Prepare(epoch);
+  files->push_back(disk_manager_->GetFileName());
+}
+
+void HeapFile::ApplyCheckpoint() {
+  disk_manager_->Apply();
+}
+
+// see BPlusTree::SaveHeader
+void HeapFile::SavePageCnt() {
+  int page_cnt = bpm_->PageCnt();
+  if (bpm_->ReadPage(header_page_id_).As<HeapFileHeaderPage>()->page_cnt_ != page_cnt) {
+    bpm_->WritePage(header_page_id_).AsMut<HeapFileHeaderPage>()->page_cnt_ = page_cnt;
+  }
+}
+
+auto HeapFile::CreateSnapshot(const std::string &name) -> bool {
+  SavePageCnt();
+  return bpm_->CreateSnapshot(name);
+}
+
+auto HeapFile::SwitchSnapshot(const std::string &name) -> bool {
+  if (!bpm_->SwitchSnapshot(name)) {
+    return false;
+  }
+  bpm_->InitPageCnt(bpm_->ReadPage(header_page_id_).As<HeapFileHeaderPage>()->page_cnt_);
+  return true;
+}
+
+auto HeapFile::DropSnapshot(const std::string &name) -> bool {
+  return bpm_->DropSnapshot(name);
+}
+
+void HeapFile::CollectStats(vector<FileStats> *stats) {
+  stats->push_back(bpm_->GetStats());
+}
+
+}
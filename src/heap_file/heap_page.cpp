@@ -0,0 +1,49 @@
+#include "heap_file/heap_page.h"
+
+#include <cstring>
+
+namespace sjtu {
+
+static constexpr uint32_t kRecordAlignment = 8;
+
+void HeapPage::Init(size_t page_size) {
+  slot_cnt_ = 0;
+  free_space_end_ = page_size;
+}
+
+auto HeapPage::InsertRecord(const char *data, size_t size) -> int {
+  uint32_t slots_end = sizeof(HeapPage) + (slot_cnt_ + 1) * sizeof(Slot);
+  if (free_space_end_ < slots_end + size) {
+    return -1;
+  }
+  uint32_t offset = (free_space_end_ - size) / kRecordAlignment * kRecordAlignment;
+  if (offset < slots_end) {
+    return -1;
+  }
+  memcpy(reinterpret_cast<char *>(this) + offset, data, size);
+  GetSlotsMut()[slot_cnt_] = {offset, static_cast<uint32_t>(size)};
+  free_space_end_ = offset;
+  return slot_cnt_++;
+}
+
+auto HeapPage::GetRecord(int slot) const -> const char * {
+  return reinterpret_cast<const char *>(this) + GetSlots()[slot].offset_;
+}
+
+auto HeapPage::GetRecordMut(int slot) -> char * {
+  return reinterpret_cast<char *>(this) + GetSlots()[slot].offset_;
+}
+
+auto HeapPage::GetRecordSize(int slot) const -> size_t { return GetSlots()[slot].size_; }
+
+auto HeapPage::GetSlotCnt() const -> int { return slot_cnt_; }
+
+auto HeapPage::GetSlots() const -> const Slot * {
+  return reinterpret_cast<const Slot *>(reinterpret_cast<const char *>(this) + sizeof(HeapPage));
+}
+
+auto HeapPage::GetSlotsMut() -> Slot * {
+  return reinterpret_cast<Slot *>(reinterpret_cast<char *>(this) + sizeof(HeapPage));
+}
+
+}
@@ -11,8 +11,13 @@
 #ifndef B_PLUS_TREE_H
 #define B_PLUS_TREE_H
 
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <string>
 
@@ -21,6 +26,7 @@
 #include "b_plus_tree/b_plus_tree_leaf_page.h"
 #include "b_plus_tree/page_guard.h"
 #include "my_stl/list.hpp"
+#include "my_stl/small_vector.hpp"
 
 namespace sjtu {
 
@@ -39,27 +45,59 @@ class Context {
   // Save the root page id here so that it's easier to know if the current page is the root page.
   int root_page_id_{-1};
 
-  // Store the write guards of the pages that you're modifying here.
-  list<WritePageGuard> write_set_;
+  // Store the write guards of the pages that you're modifying here. The sets hold a root-to-leaf path, so they stay
+  // inline and a descent does not allocate.
+  SmallVector<WritePageGuard, MAX_TREE_HEIGHT> write_set_;
 
   // You may want to use this when getting value, but not necessary.
-  list<ReadPageGuard> read_set_;
+  SmallVector<ReadPageGuard, MAX_TREE_HEIGHT> read_set_;
 
-  list<int> which_son_;
+  SmallVector<int, MAX_TREE_HEIGHT> which_son_;
 
   auto IsRootPage(int page_id) -> bool { return page_id == root_page_id_; }
 };
 
-#define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator, RoughKeyComparator>
+#define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator, RoughKeyComparator, PageSize>
 
-// Main class providing the API for the Interactive B+ Tree.
+/**
+ * A rough comparator that can also hash the prefix it compares. The tree then remembers the last leaf of each prefix,
+ * so that keys increasing within their prefix are appended without a descent.
+ */
+template <typename RoughKeyComparator, typename KeyType>
+concept PrefixHasher = requires(const RoughKeyComparator &comparator, const KeyType &key) {
+  { comparator.Hash(key) } -> std::convertible_to<unsigned>;
+};
+
+INDEX_TEMPLATE_DECLARATION
+class BPlusTree;
+
+/**
+ * Main class providing the API for the Interactive B+ Tree.
+ *
+ * Every page of the tree has PageSize bytes, so indexes used for point lookups can use small pages while scanned
+ * indexes use large ones. The number of slots of the pages is derived from it.
+ *
+ * Indexes such as the order queue only receive increasing keys. The tree remembers the right-most leaf and the last
+ * leaf of each prefix, so such inserts skip the descent, and a leaf split by an append keeps most of its entries
+ * instead of being left half-empty for good.
+ *
+ * The header page, the root and, when they fit, the internal pages right below the root stay in the resident region of
+ * the buffer pool, so that a lookup in a tree of up to four levels misses at most twice. They are refreshed after the
+ * splits and merges that may change them. The tree keeps a swip to each of them, so the descents of the lookups and
+ * of the optimistic writes pin them directly instead of going through the page table.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
-  using InternalPage = BPlusTreeInternalPage<KeyType, int, KeyComparator, RoughKeyComparator>;
-  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator, RoughKeyComparator>;
+  static_assert(PageSize % DIRECT_IO_ALIGNMENT == 0, "pages must be aligned for direct I/O");
+  using InternalPage = BPlusTreeInternalPage<KeyType, int, KeyComparator, RoughKeyComparator, PageSize>;
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator, RoughKeyComparator, PageSize>;
+  using Normalizer = KeyNormalizer<KeyType, KeyComparator>;
+  using NormalizedKey = typename Normalizer::Type;
+  static_assert(sizeof(LeafPage) <= PageSize && sizeof(InternalPage) <= PageSize, "tree pages must fit in a page");
 
  public:
   explicit BPlusTree(std::string name,
+                     ReplacerType replacer_type = ReplacerType::LRU_K,
                      int leaf_max_size = LEAF_PAGE_SLOT_CNT,
                      int internal_max_size = INTERNAL_PAGE_SLOT_CNT);
 
@@ -77,7 +115,7 @@ class BPlusTree {
   // Return the value associated with a given key
   auto GetValue(const KeyType &key, vector<ValueType> *result) -> bool;
 
-  // Return all value satisfied rough comparator
+  // Return all value satisfied rough comparator. Scans read their leaves through a ScanRing.
   void GetAllValue(const KeyType &key, vector<ValueType> *result);
 
   void GetAll(vector<ValueType> *result);
@@ -88,9 +126,58 @@ class BPlusTree {
   // Return the size of bpt
   auto GetSize() const -> int;
 
+  // Return the number of levels, 1 for a tree whose root is a leaf. It is tracked as the root changes.
+  auto GetHeight() const -> int;
+
   void Clean();
 
+  // Two phases of a checkpoint, see DiskManager
+  void PrepareCheckpoint(size_t epoch, vector<std::string> *files);
+
+  void ApplyCheckpoint();
+
+  // Snapshots of the whole tree, see DiskManager. No other operation may run meanwhile.
+  auto CreateSnapshot(const std::string &name) -> bool;
+
+  auto SwitchSnapshot(const std::string &name) -> bool;
+
+  auto DropSnapshot(const std::string &name) -> bool;
+
+  // Append the storage statistics of this tree
+  void CollectStats(vector<FileStats> *stats);
+
+  // Check the structural invariants of this B+ tree, only used in tests
+  auto CheckIntegrity() -> bool;
+
  private:
+  void SaveHeader();
+
+  auto InsertPessimistic(const KeyType &key, const NormalizedKey &normalized_key, const ValueType &value) -> bool;
+
+  void RemovePessimistic(const NormalizedKey &normalized_key);
+
+  void RefreshResidentPages();
+
+  // Read a child of an internal page, through its swip if the page is the root
+  auto ReadChild(const ReadPageGuard &guard, int root_page_id, int slot) -> ReadPageGuard;
+
+  auto NextLeaf(Context *ctx, ScanRing *ring) -> bool;
+
+  void ReadAheadLeaves(Context *ctx, ScanRing *ring);
+
+  auto FindLeafOptimistic(const NormalizedKey &key, int *root_page_id) -> std::optional<WritePageGuard>;
+
+  auto FindLeafByHint(const KeyType &key, const NormalizedKey &normalized_key) -> std::optional<WritePageGuard>;
+
+  // Remember the write-latched leaf that just took key
+  void RememberLeaf(const KeyType &key, const WritePageGuard &guard);
+
+  void ResetHints();
+
+  void ReleaseAncestors(Context *ctx);
+
+  auto CheckSubtree(int page_id, const KeyType *lower, const KeyType *upper, int depth, int *leaf_depth,
+                    vector<int> *leaves) -> bool;
 
   // member variable
   std::string index_name_;
@@ -101,6 +188,23 @@ class BPlusTree {
   int leaf_max_size_;
   int internal_max_size_;
   int header_page_id_;
+  // the number of inserted entries, saved to the header page only by SaveHeader so that inserts do not dirty it
+  std::atomic<int> size_{0};
+  // A hint packs a leaf page id with the number of deleted leaves when it was taken, see FindLeafByHint
+  static constexpr uint64_t kNoHint = 0xffffffffULL;
+  std::atomic<uint64_t> right_most_leaf_{kNoHint};
+  std::array<std::atomic<uint64_t>, APPEND_HINT_SLOT_CNT> prefix_leaves_;
+  std::atomic<uint32_t> leaf_delete_cnt_{0};
+  // the pages kept in the resident region of the pool, and the root whose height was measured
+  std::mutex resident_latch_;
+  vector<int> resident_pages_;
+  int height_root_page_id_{-1};
+  std::atomic<int> height_{0};
+  // the swips of the resident pages, the children of the root by their slot in it
+  static constexpr int kChildSwipCnt = INDEX_BUFFER_POOL_SIZE * RESIDENT_FRAME_PERCENT / 100;
+  Swip header_swip_;
+  Swip root_swip_;
+  std::array<Swip, kChildSwipCnt> child_swips_;
 };
 
 }
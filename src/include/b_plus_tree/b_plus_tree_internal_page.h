@@ -4,14 +4,19 @@
 #include <string>
 
 #include "b_plus_tree/b_plus_tree_page.h"
+#include "b_plus_tree/normalized_key.h"
 #include "config.h"
 
 namespace sjtu {
 
-#define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator, RoughKeyComparator>
+#define B_PLUS_TREE_INTERNAL_PAGE_TYPE \
+  BPlusTreeInternalPage<KeyType, ValueType, KeyComparator, RoughKeyComparator, PageSize>
 #define INTERNAL_PAGE_HEADER_SIZE 12
 #define INTERNAL_PAGE_SLOT_CNT \
-  ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / ((int)(sizeof(KeyType) + sizeof(int))))  // NOLINT
+  ((PageSize - INTERNAL_PAGE_HEADER_SIZE) / ((int)(NORMALIZED_KEY_SIZE + sizeof(int))))  // NOLINT
+
+INDEX_TEMPLATE_DECLARATION
+class BPlusTreeInternalPage;
 
 /**
  * Store `n` indexed keys and `n + 1` child pointers (page_id) within internal page.
@@ -31,9 +36,14 @@ namespace sjtu {
  *  ---------------------------------------------
  * | PAGE_ID(1) | PAGE_ID(2) | ... | PAGE_ID(n) |
  *  ---------------------------------------------
+ *
+ * Keys are stored normalized, see KeyNormalizer.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
+  using Normalizer = KeyNormalizer<KeyType, KeyComparator>;
+  using NormalizedKey = typename Normalizer::Type;
+
  public:
   // Delete all constructor / destructor to ensure memory safety
   BPlusTreeInternalPage() = delete;
@@ -41,16 +51,19 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   void Init(int max_size);
 
-  auto KeyAt(int index) const -> KeyType;
+  auto KeyAt(int index) const -> NormalizedKey;
 
-  void SetKeyAt(int index, const KeyType &key);
+  void SetKeyAt(int index, const NormalizedKey &key);
 
   auto ValueAt(int index) const -> int;
 
   void SetValueAt(int index, const int &value);
 
+  // The index of the child whose subtree holds key
+  auto ChildIndex(const NormalizedKey &key) const -> int;
+
  private:
-  KeyType key_array_[INTERNAL_PAGE_SLOT_CNT];
+  NormalizedKey key_array_[INTERNAL_PAGE_SLOT_CNT];
   int page_id_array_[INTERNAL_PAGE_SLOT_CNT];
 };
 
@@ -4,12 +4,16 @@
 #include <string>
 
 #include "b_plus_tree/b_plus_tree_page.h"
+#include "b_plus_tree/normalized_key.h"
 
 namespace sjtu {
 
-#define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator, RoughKeyComparator>
+#define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator, RoughKeyComparator, PageSize>
 #define LEAF_PAGE_HEADER_SIZE 16
-#define LEAF_PAGE_SLOT_CNT ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)))
+#define LEAF_PAGE_SLOT_CNT ((PageSize - LEAF_PAGE_HEADER_SIZE) / (NORMALIZED_KEY_SIZE + sizeof(ValueType)))
+
+INDEX_TEMPLATE_DECLARATION
+class BPlusTreeLeafPage;
 
 /**
  * Store indexed key and record id (record id = page id combined with slot id,
@@ -32,9 +36,14 @@ namespace sjtu {
  *  -----------------
  * | NextPageId (4) |
  *  -----------------
+ *
+ * The number of slots is derived from the page size of the index. Keys are stored normalized, see KeyNormalizer.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
+  using Normalizer = KeyNormalizer<KeyType, KeyComparator>;
+  using NormalizedKey = typename Normalizer::Type;
+
  public:
   // Delete all constructor / destructor to ensure memory safety
   BPlusTreeLeafPage() = delete;
@@ -45,14 +54,16 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   // Helper methods
   auto GetNextPageId() const -> int;
   void SetNextPageId(int next_page_id);
-  auto KeyAt(int index) const -> KeyType;
+  auto KeyAt(int index) const -> NormalizedKey;
   auto RidAt(int index) const -> ValueType;
-  void SetKeyAt(int index, const KeyType &key);
+  void SetKeyAt(int index, const NormalizedKey &key);
   void SetRidAt(int index, const ValueType &rid);
+  // The index of the first key that is not less than key, or the size if there is none
+  auto KeyIndex(const NormalizedKey &key) const -> int;
 
  private:
   int next_page_id_;
-  KeyType key_array_[LEAF_PAGE_SLOT_CNT];
+  NormalizedKey key_array_[LEAF_PAGE_SLOT_CNT];
   ValueType rid_array_[LEAF_PAGE_SLOT_CNT];
 };
 
@@ -7,7 +7,12 @@
 
 namespace sjtu {
 
-#define INDEX_TEMPLATE_ARGUMENTS template <typename KeyType, typename ValueType, typename KeyComparator, typename RoughKeyComparator>
+// PageSize is the page size of the index in byte, defaulting to BUSTUB_PAGE_SIZE
+#define INDEX_TEMPLATE_ARGUMENTS \
+  template <typename KeyType, typename ValueType, typename KeyComparator, typename RoughKeyComparator, int PageSize>
+#define INDEX_TEMPLATE_DECLARATION \
+  template <typename KeyType, typename ValueType, typename KeyComparator, typename RoughKeyComparator, \
+            int PageSize = BUSTUB_PAGE_SIZE>
 
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
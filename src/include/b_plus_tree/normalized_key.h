@@ -0,0 +1,163 @@
+#ifndef NORMALIZED_KEY_H
+#define NORMALIZED_KEY_H
+
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "my_stl/array.hpp"
+
+namespace sjtu {
+
+/**
+ * A fixed-width byte string ordered by memcmp, the normalized form of keys that do not fit in an integer.
+ */
+template <int N>
+struct NormalizedBytes {
+  unsigned char bytes_[N];
+};
+
+// Encode a field into a normalized byte string, so that memcmp orders the bytes like the field
+inline void EncodeUnsigned(unsigned value, unsigned char *dst) {
+  dst[0] = static_cast<unsigned char>(value >> 24);
+  dst[1] = static_cast<unsigned char>(value >> 16);
+  dst[2] = static_cast<unsigned char>(value >> 8);
+  dst[3] = static_cast<unsigned char>(value);
+}
+
+inline auto DecodeUnsigned(const unsigned char *src) -> unsigned {
+  return static_cast<unsigned>(src[0]) << 24 | static_cast<unsigned>(src[1]) << 16 |
+         static_cast<unsigned>(src[2]) << 8 | static_cast<unsigned>(src[3]);
+}
+
+// signed integers are biased so that negative ones come first
+inline void EncodeInt(int value, unsigned char *dst) {
+  EncodeUnsigned(static_cast<unsigned>(value) ^ 0x80000000U, dst);
+}
+
+inline auto DecodeInt(const unsigned char *src) -> int { return static_cast<int>(DecodeUnsigned(src) ^ 0x80000000U); }
+
+// chars are compared as char, which is signed on some platforms
+inline auto EncodeChar(char value) -> unsigned char {
+  return static_cast<unsigned char>(value) ^ (std::is_signed_v<char> ? 0x80 : 0);
+}
+
+inline auto DecodeChar(unsigned char value) -> char {
+  return static_cast<char>(value ^ (std::is_signed_v<char> ? 0x80 : 0));
+}
+
+template <int N>
+inline void EncodeChars(const array<char, N> &value, unsigned char *dst) {
+  for (int i = 0; i < N; ++i) {
+    dst[i] = EncodeChar(value[i]);
+  }
+}
+
+template <int N>
+inline void DecodeChars(const unsigned char *src, array<char, N> *value) {
+  for (int i = 0; i < N; ++i) {
+    (*value)[i] = DecodeChar(src[i]);
+  }
+}
+
+// The bias of an int in a packed unsigned key
+inline auto BiasInt(int value) -> uint64_t { return static_cast<unsigned>(value) ^ 0x80000000U; }
+
+inline auto UnbiasInt(uint64_t value) -> int { return static_cast<int>(static_cast<unsigned>(value) ^ 0x80000000U); }
+
+/**
+ * A comparator that can normalize its keys: Normalize maps a key to an integer or a NormalizedBytes whose own order
+ * is the order of the comparator, and Denormalize maps it back.
+ */
+template <typename KeyComparator, typename KeyType>
+concept NormalizingComparator = requires(const KeyType &key) {
+  { KeyComparator::Denormalize(KeyComparator::Normalize(key)) } -> std::same_as<KeyType>;
+};
+
+/**
+ * The keys of a B+ tree as stored in its pages. Keys of a normalizing comparator are stored normalized, so that
+ * searching a page compares integers or runs memcmp instead of calling the comparator field by field. Other keys are
+ * stored as they are and compared by the comparator.
+ */
+template <typename KeyType, typename KeyComparator>
+struct KeyNormalizer {
+  static constexpr bool kIsNormalized = false;
+  using Type = KeyType;
+  static auto Normalize(const KeyType &key) -> Type { return key; }
+  static auto Denormalize(const Type &key) -> KeyType { return key; }
+  static auto Compare(const Type &x, const Type &y) -> int { return KeyComparator()(x, y); }
+};
+
+template <typename KeyType, typename KeyComparator>
+  requires NormalizingComparator<KeyComparator, KeyType>
+struct KeyNormalizer<KeyType, KeyComparator> {
+  static constexpr bool kIsNormalized = true;
+  using Type = decltype(KeyComparator::Normalize(std::declval<const KeyType &>()));
+  static auto Normalize(const KeyType &key) -> Type { return KeyComparator::Normalize(key); }
+  static auto Denormalize(const Type &key) -> KeyType { return KeyComparator::Denormalize(key); }
+  static auto Compare(const Type &x, const Type &y) -> int {
+    if constexpr (std::is_integral_v<Type>) {
+      return (x > y) - (x < y);
+    } else {
+      return memcmp(x.bytes_, y.bytes_, sizeof(x.bytes_));
+    }
+  }
+};
+
+// The size of a key in the pages of a B+ tree
+#define NORMALIZED_KEY_SIZE sizeof(typename KeyNormalizer<KeyType, KeyComparator>::Type)
+
+/**
+ * @brief Count the keys of a sorted array that are less than key, or not greater than it if kUpper is set.
+ *
+ * A binary search narrows the range down to a few keys, which are then scanned in order. The 32-bit keys are
+ * compared four at a time with SSE2.
+ *
+ * @return the lower bound, or the upper bound if kUpper is set, of key in [begin, end)
+ */
+template <bool kUpper, typename Normalizer>
+auto SearchNormalized(const typename Normalizer::Type *keys, int begin, int end, const typename Normalizer::Type &key)
+    -> int {
+  constexpr int kScanWidth = 16;
+  while (end - begin > kScanWidth) {
+    int mid = begin + (end - begin) / 2;
+    int res = Normalizer::Compare(keys[mid], key);
+    if (kUpper ? res <= 0 : res < 0) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  int pos = begin;
+#ifdef __SSE2__
+  if constexpr (Normalizer::kIsNormalized && std::is_same_v<typename Normalizer::Type, int>) {
+    auto probe = _mm_set1_epi32(key);
+    for (; pos + 4 <= end; pos += 4) {
+      auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + pos));
+      // before the key: less than it, or not greater than it for the upper bound
+      auto before = kUpper ? _mm_xor_si128(_mm_cmpgt_epi32(block, probe), _mm_set1_epi32(-1))
+                           : _mm_cmplt_epi32(block, probe);
+      int mask = _mm_movemask_ps(_mm_castsi128_ps(before));
+      if (mask != 0xf) {
+        return pos + __builtin_popcount(mask);
+      }
+    }
+  }
+#endif
+  for (; pos < end; ++pos) {
+    int res = Normalizer::Compare(keys[pos], key);
+    if (kUpper ? res > 0 : res >= 0) {
+      break;
+    }
+  }
+  return pos;
+}
+
+}
+
+#endif
@@ -1,10 +1,7 @@
 #ifndef PAGE_GUARD_H
 #define PAGE_GUARD_H
 
-#include <memory>
-
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/disk_manager.h"
 
 namespace sjtu {
 
@@ -54,8 +51,7 @@ class ReadPageGuard {
 
  private:
   /** @brief Only the buffer pool manager is allowed to construct a valid `ReadPageGuard.` */
-  explicit ReadPageGuard(int page_id, std::shared_ptr<FrameHeader> frame, std::shared_ptr<LRUKReplacer> replacer,
-                         std::shared_ptr<DiskManager> disk_manager);
+  explicit ReadPageGuard(int page_id, FrameHeader *frame, BufferPoolManager *bpm);
 
   /** @brief The page ID of the page we are guarding. */
   int page_id_;
@@ -63,24 +59,12 @@ class ReadPageGuard {
   /**
    * @brief The frame that holds the page this guard is protecting.
    *
-   * Almost all operations of this page guard should be done via this shared pointer to a `FrameHeader`.
-   */
-  std::shared_ptr<FrameHeader> frame_;
-
-  /**
-   * @brief A shared pointer to the buffer pool's replacer.
-   *
-   * Since the buffer pool cannot know when this `ReadPageGuard` gets destructed, we maintain a pointer to the buffer
-   * pool's replacer in order to set the frame as evictable on destruction.
+   * The buffer pool owns its frames, and a pinned frame is never reused, so a raw pointer is enough.
    */
-  std::shared_ptr<LRUKReplacer> replacer_;
+  FrameHeader *frame_{nullptr};
 
-  /**
-   * @brief A shared pointer to the buffer pool's disk scheduler.
-   *
-   * Used when flushing pages to disk.
-   */
-  std::shared_ptr<DiskManager> disk_manager_;
+  /** @brief The buffer pool of the frame, which unpins it when the guard is dropped. */
+  BufferPoolManager *bpm_{nullptr};
 
   /**
    * @brief The validity flag for this `ReadPageGuard`.
@@ -145,8 +129,7 @@ class WritePageGuard {
 
  private:
   /** @brief Only the buffer pool manager is allowed to construct a valid `WritePageGuard.` */
-  explicit WritePageGuard(int page_id, std::shared_ptr<FrameHeader> frame, std::shared_ptr<LRUKReplacer> replacer,
-                          std::shared_ptr<DiskManager> disk_manager);
+  explicit WritePageGuard(int page_id, FrameHeader *frame, BufferPoolManager *bpm);
 
   /** @brief The page ID of the page we are guarding. */
   int page_id_;
@@ -154,24 +137,12 @@ class WritePageGuard {
   /**
    * @brief The frame that holds the page this guard is protecting.
    *
-   * Almost all operations of this page guard should be done via this shared pointer to a `FrameHeader`.
+   * The buffer pool owns its frames, and a pinned frame is never reused, so a raw pointer is enough.
    */
-  std::shared_ptr<FrameHeader> frame_;
+  FrameHeader *frame_{nullptr};
 
-  /**
-   * @brief A shared pointer to the buffer pool's replacer.
-   *
-   * Since the buffer pool cannot know when this `WritePageGuard` gets destructed, we maintain a pointer to the buffer
-   * pool's replacer in order to set the frame as evictable on destruction.
-   */
-  std::shared_ptr<LRUKReplacer> replacer_;
-
-  /**
-   * @brief A shared pointer to the buffer pool's disk scheduler.
-   *
-   * Used when flushing pages to disk.
-   */
-  std::shared_ptr<DiskManager> disk_manager_;
+  /** @brief The buffer pool of the frame, which unpins it when the guard is dropped. */
+  BufferPoolManager *bpm_{nullptr};
 
   /**
    * @brief The validity flag for this `WritePageGuard`.
@@ -0,0 +1,60 @@
+#ifndef ARC_REPLACER_H
+#define ARC_REPLACER_H
+
+#include <optional>
+#include "my_stl/vector.hpp"
+#include "buffer/replacer.h"
+
+namespace sjtu {
+
+/**
+ * ArcReplacer implements the Adaptive Replacement Cache policy.
+ *
+ * T1 is an LRU list of the frames whose page was read once since it was loaded, T2 one of the frames whose page was
+ * read again. B1 and B2 remember the pages evicted from T1 and T2. A miss on a page of B1 means that T1 is too small,
+ * so the target size of T1 grows, and a miss on a page of B2 shrinks it. Evict takes the victim from T1 while T1 is
+ * larger than its target, and from T2 otherwise. A scan only goes through T1, so it cannot flush the pages of T2.
+ *
+ * The buffer pool picks the victim before it tells which page is loaded, so unlike the original policy the target is
+ * adapted after the eviction, and it only takes effect at the next one.
+ */
+class ArcReplacer : public Replacer {
+ public:
+  explicit ArcReplacer(size_t num_frames);
+
+  ~ArcReplacer() override = default;
+
+  auto Evict() -> std::optional<int> override;
+
+  void RecordAccess(int frame_id, int page_id, AccessType access_type = AccessType::Unknown) override;
+
+  void SetEvictable(int frame_id, bool set_evictable) override;
+
+  void Remove(int frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void Clean() override;
+
+ private:
+  // Return the least recent evictable frame of a list, or -1
+  auto FindVictim(const FrameList &frames) const -> int;
+
+  // Keep |T1| + |B1| within the frames and the four lists within twice the frames
+  void TrimGhosts();
+
+  size_t num_frames_;
+  // the target size of T1
+  size_t target_{0};
+  FrameList recent_;
+  FrameList frequent_;
+  GhostList recent_ghosts_;
+  GhostList frequent_ghosts_;
+  vector<int> page_ids_;
+  vector<bool> evictable_;
+  size_t evictable_size_{0};
+};
+
+}
+
+#endif
@@ -1,13 +1,22 @@
 #ifndef BUFFER_POOL_MANAGER_H
 #define BUFFER_POOL_MANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include "my_stl/map.hpp"
 #include "my_stl/vector.hpp"
 #include "my_stl/list.hpp"
 
-#include "buffer/lru_k_replacer.h"
+#include "buffer/replacer.h"
+#include "config.h"
 #include "buffer/disk_manager.h"
+#include "buffer/disk_scheduler.h"
 #include "b_plus_tree/page_guard.h"
 
 namespace sjtu {
@@ -16,6 +25,29 @@ class BufferPoolManager;
 class ReadPageGuard;
 class WritePageGuard;
 
+/**
+ * @brief The storage statistics of a database file and of its buffer pool.
+ */
+struct FileStats {
+  std::string name_;
+  int page_cnt_{0};
+  int entry_cnt_{-1};  // the entries of an index, -1 for other files
+  size_t hit_cnt_{0};
+  size_t miss_cnt_{0};
+  size_t evict_cnt_{0};
+  size_t write_back_cnt_{0};  // dirty victims written back by a miss instead of the flusher
+  size_t read_cnt_{0};
+  size_t write_cnt_{0};
+  size_t flush_cnt_{0};
+  size_t delete_cnt_{0};
+  int height_{-1};  // the height of an index, -1 for other files
+  int filter_byte_cnt_{-1};  // the size of the Bloom filter of an index, -1 for files without one
+  size_t filter_negative_cnt_{0};  // lookups answered by the Bloom filter without fetching a page
+  size_t filter_false_positive_cnt_{0};  // lookups let through by the Bloom filter that found nothing
+  int resident_page_cnt_{0};  // pages kept in the resident region of the pool
+  size_t swizzled_hit_cnt_{0};  // hits on resident pages pinned through a swip, counted in the hits too
+};
+
 /**
  * @brief A helper class for `BufferPoolManager` that manages a frame of memory and related metadata.
  *
@@ -25,21 +57,9 @@ class WritePageGuard;
  *
  * ---
  *
- * Something that may (or may not) be of interest to you is why the field `data_` is stored as a vector that is
- * allocated on the fly instead of as a direct pointer to some pre-allocated chunk of memory.
- *
- * In a traditional production buffer pool manager, all memory that the buffer pool is intended to manage is allocated
- * in one large contiguous array (think of a very large `malloc` call that allocates several gigabytes of memory up
- * front). This large contiguous block of memory is then divided into contiguous frames. In other words, frames are
- * defined by an offset from the base of the array in page-sized (4 KB) intervals.
- *
- * In BusTub, we instead allocate each frame on its own (via a `std::vector<char>`) in order to easily detect buffer
- * overflow with address sanitizer. Since C++ has no notion of memory safety, it would be very easy to cast a page's
- * data pointer into some large data type and start overwriting other pages of data if they were all contiguous.
- *
- * If you would like to attempt to use more efficient data structures for your buffer pool manager, you are free to do
- * so. However, you will likely benefit significantly from detecting buffer overflow in future projects (especially
- * project 2).
+ * Like in a production buffer pool manager, all the frames are carved out of one contiguous arena allocated up front by
+ * the `BufferPoolManager`, in page-sized intervals. The page size is the one of its `DiskManager`. The arena is aligned to DIRECT_IO_ALIGNMENT, so every frame can be
+ * transferred with direct I/O without a bounce buffer (see `DiskManager`).
  */
 class FrameHeader {
   friend class BufferPoolManager;
@@ -47,7 +67,7 @@ class FrameHeader {
   friend class WritePageGuard;
 
  public:
-  explicit FrameHeader(int frame_id, int page_id = -1);
+  FrameHeader(int frame_id, char *data, size_t size, int page_id = -1);
 
  private:
   auto GetData() const -> const char *;
@@ -58,17 +78,23 @@ class FrameHeader {
   const int frame_id_;
 
   /** @brief The number of pins on this frame keeping the page in memory. */
-  size_t pin_count_;
+  std::atomic<size_t> pin_count_;
 
   /** @brief The dirty flag. */
-  bool is_dirty_;
+  std::atomic<bool> is_dirty_;
+
+  /** @brief The reader-writer latch protecting the page data held by this frame. */
+  std::shared_mutex rwlatch_;
 
   /**
-   * @brief A pointer to the data of the page that this frame holds.
+   * @brief A pointer to the data of the page that this frame holds, inside the arena of the buffer pool.
    *
    * If the frame does not hold any page data, the frame contains all null bytes.
    */
-  vector<char> data_;
+  char *const data_;
+
+  /** @brief The size of the frame, which is the page size of the buffer pool. */
+  const size_t size_;
 
   /**
    *
@@ -77,6 +103,83 @@ class FrameHeader {
    * else in the buffer pool manager...
    */
   int page_id_;
+
+  /** @brief Valid while the page is read ahead. The read holds a pin until it is reaped by the buffer pool. */
+  std::shared_future<bool> read_ahead_;
+
+  /** @brief Set while the page was only read by the scan that loaded it, see `ScanRing`. */
+  bool scan_owned_{false};
+
+  /**
+   * @brief Set while the page is in the resident region. The frame is never evictable then. It only changes while
+   * the resident latch of the pool is held exclusively, see `Swip`.
+   */
+  std::atomic<bool> resident_{false};
+};
+
+/**
+ * @brief The private frames of a sequential scan, like the buffer access strategies of PostgreSQL.
+ *
+ * The pages that a scan misses are loaded into the frames of its ring. Once the ring holds `size` frames, the next miss
+ * recycles the least recent frame of the ring instead of evicting a frame of the working set. A frame that another
+ * reader fetched, or that is pinned, has left the scan and is replaced in the ring by a frame taken as usual. The pages
+ * loaded by the scan are recorded as scan accesses, which enter at the cold end of the replacer, and its later hits on
+ * them are not recorded, so they are never promoted and remain the first victims once the scan is over.
+ */
+class ScanRing {
+  friend class BufferPoolManager;
+
+ public:
+  explicit ScanRing(size_t size = SCAN_RING_SIZE) : size_(size) {}
+
+ private:
+  // Put a frame loaded with a page into the slot of the least recent frame, or into a new slot while the ring is not full
+  void Add(int frame_id, int page_id) {
+    if (frame_ids_.size() < size_) {
+      frame_ids_.push_back(frame_id);
+      page_ids_.push_back(page_id);
+      return;
+    }
+    frame_ids_[next_] = frame_id;
+    page_ids_[next_] = page_id;
+    next_ = (next_ + 1) % size_;
+  }
+
+  const size_t size_;
+  // the frames of the ring and the pages the scan loaded into them
+  vector<int> frame_ids_;
+  vector<int> page_ids_;
+  // the slot of the least recent frame once the ring is full
+  size_t next_{0};
+};
+
+/**
+ * @brief A swizzled reference to a resident page, like the swips of LeanStore.
+ *
+ * A swip packs the id of a page with the frame that holds it. A page read through a swip that still holds it is
+ * pinned directly in its frame, without the page table, the replacer or the pool latch. Resident frames are never
+ * evicted, so only their pin count changes. A swip goes stale when its page leaves the resident region, or when the
+ * owner of the swip links another page there, and the read then falls back to the page table. Swips live beside the
+ * pages that hold the references, so the pages themselves are written back as they are.
+ */
+class Swip {
+ public:
+  void Set(int page_id, int frame_id) {
+    value_.store(static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32 | static_cast<uint32_t>(frame_id),
+                 std::memory_order_relaxed);
+  }
+
+  void Clear() { value_.store(kNone, std::memory_order_relaxed); }
+
+  // Return the frame of the page, or -1 if the swip refers to another page
+  auto FrameOf(int page_id) const -> int {
+    auto value = value_.load(std::memory_order_relaxed);
+    return static_cast<int>(value >> 32) == page_id ? static_cast<int>(static_cast<uint32_t>(value)) : -1;
+  }
+
+ private:
+  static constexpr uint64_t kNone = ~0ULL;
+  std::atomic<uint64_t> value_{kNone};
 };
 
 /**
@@ -87,11 +190,24 @@ class FrameHeader {
  * faster access, and evicting unused or cold pages back out to storage.
  *
  * Make sure you read the writeup in its entirety before attempting to implement the buffer pool manager. You also need
- * to have completed the implementation of both the `LRUKReplacer` and `DiskManager` classes.
+ * to have completed the implementation of both the `LRUKReplacer` and `DiskManager` classes. The replacement policy
+ * is chosen when the pool is created, see `ReplacerType`.
+ *
+ * A background flusher writes dirty unpinned frames back once more than `dirty_high_water` frames are dirty, so that a
+ * miss usually finds a clean victim and only pays for its read.
+ *
+ * Up to RESIDENT_FRAME_PERCENT of the frames form a resident region, whose pages stay in the pool until they are
+ * released or deleted. The indexes keep their header and upper levels there, see `SetResident`, and read them through
+ * swips when POINTER_SWIZZLING is set, see `Swip`.
  */
 class BufferPoolManager {
+  /** @brief Page guards unpin their frame through `UnpinFrame` when they are dropped. */
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
  public:
-  BufferPoolManager(size_t num_frames, std::shared_ptr<DiskManager> disk_manager, size_t k_dist);
+  BufferPoolManager(size_t num_frames, std::shared_ptr<DiskManager> disk_manager, size_t k_dist,
+                    size_t dirty_high_water = 0, ReplacerType replacer_type = ReplacerType::LRU_K);
   ~BufferPoolManager();
 
   void InitPageCnt(int page_cnt);
@@ -100,19 +216,41 @@ class BufferPoolManager {
   auto NewPage() -> int;
   auto DeletePage(int page_id) -> bool;
   auto WritePage(int page_id) -> WritePageGuard;
-  auto ReadPage(int page_id) -> ReadPageGuard;
+  auto ReadPage(int page_id, ScanRing *ring = nullptr) -> ReadPageGuard;
+  auto ReadPage(int page_id, const Swip &swip) -> ReadPageGuard;
   auto FlushPage(int page_id) -> bool;
   void FlushAllPages();
+  void ReadAhead(const vector<int> &page_ids, ScanRing *ring = nullptr);
   auto GetPinCount(int page_id) -> std::optional<size_t>;
+  auto SetResident(int page_id, bool resident) -> bool;
+  auto ResidentCapacity() const -> size_t;
+  void Swizzle(int page_id, Swip *swip);
   void Clean();
+  auto CreateSnapshot(const std::string &name) -> bool;
+  auto SwitchSnapshot(const std::string &name) -> bool;
+  auto DropSnapshot(const std::string &name) -> bool;
+  auto GetStats() -> FileStats;
 
  private:
   /** @brief The number of frames in the buffer pool. */
   const size_t num_frames_;
 
+  /** @brief The size of a page, taken from the disk manager. */
+  const size_t page_size_;
+
   /** @brief The next page ID to be allocated.  */
   int next_page_id_;
 
+  /**
+   * @brief The latch protecting the buffer pool's inner data structures.
+   *
+   * The page table, the free list, the replacer and the pin counts are only touched while holding this latch.
+   */
+  std::mutex bpm_latch_;
+
+  /** @brief The memory of all the frames, aligned to DIRECT_IO_ALIGNMENT. */
+  std::unique_ptr<char, decltype(&std::free)> arena_;
+
   /** @brief The frame headers of the frames that this buffer pool manages. */
   vector<std::shared_ptr<FrameHeader>> frames_;
 
@@ -123,11 +261,54 @@ class BufferPoolManager {
   list<int> free_frames_;
 
   /** @brief The replacer to find unpinned / candidate pages for eviction. */
-  std::shared_ptr<LRUKReplacer> replacer_;
+  std::unique_ptr<Replacer> replacer_;
 
   /** @brief A pointer to the disk scheduler. */
   std::shared_ptr<DiskManager> disk_manager_;
 
+  /** @brief Runs the read-ahead and the write-backs of the flusher. It is declared after the frames it reads into. */
+  std::shared_ptr<DiskScheduler> disk_scheduler_;
+
+  /** @brief The frames being read ahead. */
+  list<int> read_ahead_frames_;
+
+  /** @brief The number of page fetches that found the page in the pool, and that had to read it from disk. */
+  size_t hit_cnt_{0};
+  size_t miss_cnt_{0};
+
+  /** @brief The number of evicted frames, and of dirty victims written back on the spot. */
+  size_t evict_cnt_{0};
+  size_t write_back_cnt_{0};
+
+  /** @brief The number of frames in the resident region. */
+  size_t resident_cnt_{0};
+
+  /**
+   * @brief Held shared while a frame is pinned through a swip or unpinned without the pool latch, and exclusively
+   * while a frame enters or leaves the resident region. It is always taken after the pool latch.
+   */
+  std::shared_mutex resident_latch_;
+
+  /** @brief The number of pins taken through a swip. */
+  std::atomic<size_t> swizzled_hit_cnt_{0};
+
+  /** @brief The flusher writes back dirty frames while more than this many frames are dirty. */
+  const size_t dirty_high_water_;
+
+  /**
+   * @brief Held while a page is written back by the flusher.
+   *
+   * `FlushAllPages`, `DeletePage`, `Clean` and `SwitchSnapshot` take it before the pool latch, so they never run in the
+   * middle of a background write-back.
+   */
+  std::mutex write_back_latch_;
+
+  /** @brief The latch protecting `stop_flusher_`, used with `flusher_cv_` to wake up the flusher. */
+  std::mutex flusher_latch_;
+  std::condition_variable flusher_cv_;
+  bool stop_flusher_{false};
+  std::thread flusher_;
+
   /**
    *
    * There will likely be a lot of code duplication between the different modes of accessing a page.
@@ -137,8 +318,21 @@ class BufferPoolManager {
    * pointer to a `FrameHeader` that already has a page's data stored inside of it, or an index to said `FrameHeader`.
    */
 
-  auto FetchPage(int page_id)
-      -> std::optional<std::shared_ptr<FrameHeader>>;
+  auto FetchPage(int page_id, ScanRing *ring) -> FrameHeader *;
+
+  // Take a frame for a page that misses, and remove its old page from the pool. Return -1 if every frame is pinned.
+  auto TakeFrame(int page_id, ScanRing *ring) -> int;
+
+  auto RecycleRingFrame(ScanRing *ring) -> int;
+
+  auto PinFrame(int page_id, ScanRing *ring = nullptr) -> FrameHeader *;
+  auto PinSwizzled(int page_id, const Swip &swip) -> FrameHeader *;
+  void UnpinFrame(FrameHeader *frame);
+
+  void ReapReadAhead(bool wait);
+
+  void FlusherLoop();
+  void WriteBackDirtyFrames();
 };
 }
 
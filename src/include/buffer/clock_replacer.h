@@ -0,0 +1,45 @@
+#ifndef CLOCK_REPLACER_H
+#define CLOCK_REPLACER_H
+
+#include <optional>
+#include "my_stl/vector.hpp"
+#include "buffer/replacer.h"
+
+namespace sjtu {
+
+/**
+ * ClockReplacer implements the CLOCK policy, an approximation of LRU that costs a bit per frame.
+ *
+ * Every access sets the reference bit of the frame. The hand sweeps the frames in order: an evictable frame whose bit
+ * is set gets a second chance and its bit is cleared, the first one whose bit is clear is the victim.
+ */
+class ClockReplacer : public Replacer {
+ public:
+  explicit ClockReplacer(size_t num_frames);
+
+  ~ClockReplacer() override = default;
+
+  auto Evict() -> std::optional<int> override;
+
+  void RecordAccess(int frame_id, int page_id, AccessType access_type = AccessType::Unknown) override;
+
+  void SetEvictable(int frame_id, bool set_evictable) override;
+
+  void Remove(int frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void Clean() override;
+
+ private:
+  size_t num_frames_;
+  vector<bool> tracked_;
+  vector<bool> evictable_;
+  vector<bool> referenced_;
+  size_t hand_{0};
+  size_t evictable_size_{0};
+};
+
+}
+
+#endif
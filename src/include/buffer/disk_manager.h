@@ -1,28 +1,54 @@
 #ifndef DISK_MANAGER_H
 #define DISK_MANAGER_H
 
+#include <atomic>
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include "my_stl/map.hpp"
+#include "my_stl/vector.hpp"
+
+#include "config.h"
 
 namespace sjtu {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * The database file only changes at checkpoints. Between two checkpoints, written pages go to a pending file
+ * (`<db_file>.pending`) and are read back from there. A checkpoint first makes the pending file durable together with
+ * its directory and the checkpoint epoch (`Prepare`), then, once the checkpoint is committed by the log manager, copies
+ * the pending pages into the database file in page id order (`Apply`). After a crash, `Recover` re-applies the pending
+ * file of the committed checkpoint, while pending pages written after it are discarded, so the database file always
+ * holds the state of the last checkpoint.
+ *
+ * Pages are shadow paged: a page table maps each page id to a slot of the database file, and every snapshot keeps the
+ * page table of the state it was taken on. A slot shared by several page tables is never overwritten in place, writing
+ * the page moves it to a new slot instead (copy-on-write), so a snapshot only costs its page table, and taking many
+ * snapshots of the same state shares a single one. The page tables are saved in `<db_file>.meta` at checkpoints.
+ *
+ * With direct I/O, pages are read from and written to both files with `O_DIRECT`, so that they are only cached by the
+ * buffer pool and not by the kernel again. Page buffers should then be aligned to DIRECT_IO_ALIGNMENT, others go
+ * through a bounce buffer. Checkpoints and metadata still use buffered I/O. A file system without `O_DIRECT` support
+ * falls back to buffered I/O.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io whether pages bypass the page cache of the kernel
+   * @param page_size the size of a page in byte, a multiple of DIRECT_IO_ALIGNMENT
    */
-  explicit DiskManager(const std::filesystem::path &db_file);
+  explicit DiskManager(const std::filesystem::path &db_file, bool direct_io = false,
+                       size_t page_size = BUSTUB_PAGE_SIZE);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -45,6 +71,13 @@ class DiskManager {
    */
   virtual void WritePage(int page_id, const char *page_data);
 
+  /**
+   * Write several pages with a single acquisition of the io latch.
+   * @param page_ids ids of the pages
+   * @param data raw data of each page
+   */
+  void WritePages(const vector<int> &page_ids, const vector<const char *> &data);
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
@@ -58,30 +91,119 @@ class DiskManager {
    */
   virtual void DeletePage(int page_id);
 
+  // Drop every page and every snapshot
   void Clean();
 
+  /**
+   * @brief Take a snapshot of the current state.
+   * @param name the name of the snapshot
+   * @return false if the snapshot already exists
+   */
+  auto CreateSnapshot(const std::string &name) -> bool;
+
+  /**
+   * @brief Replace the current state with a snapshot. The snapshot itself is kept.
+   * @param name the name of the snapshot
+   * @return false if the snapshot does not exist
+   */
+  auto SwitchSnapshot(const std::string &name) -> bool;
+
+  /**
+   * @brief Drop a snapshot and free the slots only used by it.
+   * @param name the name of the snapshot
+   * @return false if the snapshot does not exist
+   */
+  auto DropSnapshot(const std::string &name) -> bool;
+
+  /**
+   * @brief First phase of a checkpoint: make the pending pages durable, tagged with the checkpoint epoch.
+   * @param epoch the epoch of the checkpoint
+   */
+  void Prepare(size_t epoch);
+
+  /**
+   * @brief Second phase of a checkpoint, after it is committed: move the pending pages into the database file.
+   */
+  void Apply();
+
+  /**
+   * @brief Re-apply the pending file of a database file if it was prepared by the committed checkpoint.
+   * @param db_file the database file
+   * @param epoch the epoch of the last committed checkpoint
+   */
+  static void Recover(const std::filesystem::path &db_file, size_t epoch);
+
+  /** @return the database file name */
+  auto GetFileName() const -> std::string;
+
+  /** @return the size of a page in byte */
+  auto GetPageSize() const -> size_t;
+
+  /** @return the number of slots in the database file */
+  auto GetSlotCnt() -> size_t;
+
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
 
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of disk reads */
+  auto GetNumReads() const -> int;
+
   /** @return the number of deletions */
   auto GetNumDeletes() const -> int;
 
  protected:
-  auto GetFileSize(const std::string &file_name) -> int;
-  // stream to write db file
-  std::fstream db_io_;
+  using PageTable = vector<int>;
+
+  // Transfer a page at `offset` of the database file, or of the pending file if `pending`
+  void ReadSlot(bool pending, char *page_data, size_t offset);
+  void WriteSlot(bool pending, const char *page_data, size_t offset);
+  void ReadPageLocked(int page_id, char *page_data);
+  void WritePageLocked(int page_id, const char *page_data);
+  // Return the slot to write a page to, moving the page to a new slot if its slot is shared
+  auto SlotForWrite(int page_id) -> int;
+  auto AllocateSlot() -> int;
+  void UnrefSlot(int slot);
+  // Drop a reference to a page table, freeing its slots if it was the last one
+  void ReleaseTable(std::shared_ptr<PageTable> table);
+  void LoadMeta();
+  auto SerializeMeta() -> std::string;
+  // Give the free slots at the end of the file back to the file system
+  void TrimSlots();
+  static void ApplyPending(int db_fd, int pending_fd, const vector<int> &slots, size_t slot_cnt, size_t page_size,
+                           const std::filesystem::path &db_file, const std::string &meta);
+
+  int db_fd_{-1};
+  int pending_fd_{-1};
+  // opened with O_DIRECT for page transfers, -1 without direct I/O
+  int db_direct_fd_{-1};
+  int pending_direct_fd_{-1};
+  char *bounce_buffer_{nullptr};
+  // pread / pwrite do not share a cursor, but the pending directory and the page tables do
+  std::mutex db_io_latch_;
   std::filesystem::path file_name_;
+  size_t page_size_{BUSTUB_PAGE_SIZE};
+  // slot -> slot in the pending file
+  map<int, size_t> pending_slots_;
+  // slot in the pending file -> slot, -1 if the slot is freed
+  vector<int> pending_pages_;
+  // page id -> slot of the current state, -1 if the page is never written
+  std::shared_ptr<PageTable> page_table_;
+  map<std::string, std::shared_ptr<PageTable>> snapshots_;
+  // slot -> number of page tables using it
+  vector<int> ref_cnt_;
+  vector<int> free_slots_;
+  // whether the page tables changed since the last checkpoint
+  bool meta_dirty_{false};
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};  // read without the io latch while pages are written back
+  std::atomic<int> num_reads_{0};
   int num_deletes_{0};
 
   /** @brief The number of pages allocated to the DBMS on disk. */
   size_t pages_{0};
-  /** @brief The capacity of the file used for storage on disk. */
-  size_t page_capacity_{16};
 };
 
 }
@@ -0,0 +1,81 @@
+#ifndef DISK_SCHEDULER_H
+#define DISK_SCHEDULER_H
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "my_stl/list.hpp"
+#include "my_stl/vector.hpp"
+
+#include "buffer/disk_manager.h"
+#include "config.h"
+
+namespace sjtu {
+
+/**
+ * @brief Represents a Write or Read request for the DiskManager to execute.
+ */
+struct DiskRequest {
+  /** Flag indicating whether the request is a write or a read. */
+  bool is_write_;
+
+  /**
+   * Pointer to the start of the memory location where a page is either:
+   *   1. being read into from disk (on a read).
+   *   2. being written out to disk (on a write).
+   */
+  char *data_;
+
+  /** ID of the page being read from / written to disk. */
+  int page_id_;
+
+  /** Callback used to signal to the request issuer when the request has been completed. */
+  std::promise<bool> callback_;
+};
+
+/**
+ * @brief The DiskScheduler runs read and write requests on a pool of background workers.
+ *
+ * A request is scheduled with `Schedule` and completes through the future of its promise, so the issuer can go on
+ * while the page is transferred. A worker takes every request queued at once and hands consecutive writes to the
+ * DiskManager as a single batch.
+ *
+ * The buffer pool uses it for what can overlap with the caller: reading ahead the next leaves of a scan and the
+ * write-backs of the flusher. A miss still reads its page directly, since it has to wait for it anyway.
+ */
+class DiskScheduler {
+ public:
+  explicit DiskScheduler(std::shared_ptr<DiskManager> disk_manager, size_t worker_cnt = DISK_SCHEDULER_WORKER_CNT);
+
+  // Finish every scheduled request, then stop the workers
+  ~DiskScheduler();
+
+  /**
+   * @brief Schedule a request. The pages of pending requests must be distinct.
+   * @param r the request, its promise is set once the request is done
+   */
+  void Schedule(DiskRequest r);
+
+  // Schedule several requests at once, so that a worker sees them as a single batch
+  void Schedule(list<DiskRequest> *requests);
+
+  static auto CreatePromise() -> std::promise<bool> { return {}; }
+
+ private:
+  void WorkerLoop();
+
+  void Run(list<DiskRequest> *requests);
+
+  std::shared_ptr<DiskManager> disk_manager_;
+  std::mutex latch_;
+  std::condition_variable queue_cv_;
+  list<DiskRequest> queue_;
+  bool stop_{false};
+  list<std::thread> workers_;
+};
+
+}
+
+#endif //DISK_SCHEDULER_H
@@ -4,6 +4,7 @@
 #include <optional>
 #include "my_stl/map.hpp"
 #include "my_stl/list.hpp"
+#include "buffer/replacer.h"
 
 namespace sjtu {
 
@@ -42,7 +43,7 @@ class LRUKNode {
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
  */
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   explicit LRUKReplacer(size_t num_frames, size_t k);
 
@@ -50,19 +51,19 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
-  auto Evict() -> std::optional<int>;
+  auto Evict() -> std::optional<int> override;
 
-  void RecordAccess(int frame_id);
+  void RecordAccess(int frame_id, int page_id, AccessType access_type = AccessType::Unknown) override;
 
-  void SetEvictable(int frame_id, bool set_evictable);
+  void SetEvictable(int frame_id, bool set_evictable) override;
 
-  void Remove(int frame_id);
+  void Remove(int frame_id) override;
 
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
 
-  void Clean();
+  void Clean() override;
 
  private:
   // Remove maybe_unused if you start using them.
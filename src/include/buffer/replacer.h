@@ -0,0 +1,178 @@
+#ifndef REPLACER_H
+#define REPLACER_H
+
+#include <memory>
+#include <optional>
+#include "my_stl/map.hpp"
+#include "my_stl/vector.hpp"
+
+namespace sjtu {
+
+/**
+ * The replacement policies of a buffer pool. Each index picks the one that suits its accesses when it is opened.
+ */
+enum class ReplacerType { LRU_K, CLOCK, TWO_Q, ARC };
+
+/**
+ * The kind of a page access. A page loaded by a scan enters at the cold end of the policy, see `ScanRing`.
+ */
+enum class AccessType { Unknown, Scan };
+
+/**
+ * The interface of the replacement policies.
+ *
+ * The buffer pool records every fetch of a frame together with the page it holds. A frame that the replacer does not
+ * track yet was just loaded, so a policy can tell a miss from a hit, and the page id lets 2Q and ARC remember the pages
+ * they evicted. A frame starts non-evictable. Only evictable frames may be returned by Evict, which stops tracking the
+ * victim. Remove stops tracking an evictable frame whose page is deleted.
+ *
+ * A frame loaded by a scan is the next victim among the frames of its kind, and a scan access to a tracked frame
+ * changes nothing, so scans never promote a page.
+ */
+class Replacer {
+ public:
+  virtual ~Replacer() = default;
+
+  virtual auto Evict() -> std::optional<int> = 0;
+
+  virtual void RecordAccess(int frame_id, int page_id, AccessType access_type = AccessType::Unknown) = 0;
+
+  virtual void SetEvictable(int frame_id, bool set_evictable) = 0;
+
+  virtual void Remove(int frame_id) = 0;
+
+  // Return the number of evictable frames
+  virtual auto Size() -> size_t = 0;
+
+  virtual void Clean() = 0;
+};
+
+/**
+ * @brief Create a replacer of the given policy for num_frames frames. k is only used by LRU-K.
+ */
+auto MakeReplacer(ReplacerType type, size_t num_frames, size_t k) -> std::unique_ptr<Replacer>;
+
+/**
+ * A doubly linked list of frame ids, threaded through arrays indexed by the frame id, so that a frame is moved or
+ * removed in constant time. A frame is in one list at most. The front is the most recent end.
+ */
+class FrameList {
+ public:
+  explicit FrameList(size_t num_frames) : prev_(num_frames, -1), next_(num_frames, -1), linked_(num_frames, false) {}
+
+  auto Contains(int frame_id) const -> bool { return linked_[frame_id]; }
+
+  auto Size() const -> size_t { return size_; }
+
+  // Return the least recent frame, or -1 if the list is empty
+  auto Back() const -> int { return tail_; }
+
+  // Return the frame next to the given one on the front side, or -1
+  auto Prev(int frame_id) const -> int { return prev_[frame_id]; }
+
+  void PushFront(int frame_id) {
+    prev_[frame_id] = -1;
+    next_[frame_id] = head_;
+    if (head_ != -1) {
+      prev_[head_] = frame_id;
+    } else {
+      tail_ = frame_id;
+    }
+    head_ = frame_id;
+    linked_[frame_id] = true;
+    ++size_;
+  }
+
+  void PushBack(int frame_id) {
+    next_[frame_id] = -1;
+    prev_[frame_id] = tail_;
+    if (tail_ != -1) {
+      next_[tail_] = frame_id;
+    } else {
+      head_ = frame_id;
+    }
+    tail_ = frame_id;
+    linked_[frame_id] = true;
+    ++size_;
+  }
+
+  void Erase(int frame_id) {
+    if (prev_[frame_id] != -1) {
+      next_[prev_[frame_id]] = next_[frame_id];
+    } else {
+      head_ = next_[frame_id];
+    }
+    if (next_[frame_id] != -1) {
+      prev_[next_[frame_id]] = prev_[frame_id];
+    } else {
+      tail_ = prev_[frame_id];
+    }
+    linked_[frame_id] = false;
+    --size_;
+  }
+
+  void Clear() {
+    for (int frame_id = head_; frame_id != -1; frame_id = next_[frame_id]) {
+      linked_[frame_id] = false;
+    }
+    head_ = tail_ = -1;
+    size_ = 0;
+  }
+
+ private:
+  vector<int> prev_;
+  vector<int> next_;
+  vector<bool> linked_;
+  int head_{-1};
+  int tail_{-1};
+  size_t size_{0};
+};
+
+/**
+ * A list of the ids of evicted pages, from the most recent eviction to the least recent one. The pages are ordered by
+ * the stamp of their eviction.
+ */
+class GhostList {
+ public:
+  auto Contains(int page_id) -> bool { return stamps_.find(page_id) != stamps_.end(); }
+
+  auto Size() const -> size_t { return stamps_.size(); }
+
+  void PushFront(int page_id) {
+    Erase(page_id);
+    stamps_[page_id] = next_stamp_;
+    pages_[next_stamp_++] = page_id;
+  }
+
+  // Return false if the page is not in the list
+  auto Erase(int page_id) -> bool {
+    auto it = stamps_.find(page_id);
+    if (it == stamps_.end()) {
+      return false;
+    }
+    pages_.erase(pages_.find(it->second));
+    stamps_.erase(it);
+    return true;
+  }
+
+  void PopBack() {
+    auto it = pages_.begin();
+    stamps_.erase(stamps_.find(it->second));
+    pages_.erase(it);
+  }
+
+  void Clear() {
+    stamps_.clear();
+    pages_.clear();
+    next_stamp_ = 0;
+  }
+
+ private:
+  map<int, size_t> stamps_;
+  map<size_t, int> pages_;
+  size_t next_stamp_{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef TWO_QUEUE_REPLACER_H
+#define TWO_QUEUE_REPLACER_H
+
+#include <optional>
+#include "my_stl/vector.hpp"
+#include "buffer/replacer.h"
+
+namespace sjtu {
+
+/**
+ * TwoQueueReplacer implements the full version of the 2Q policy.
+ *
+ * A page read for the first time enters A1in, a FIFO of about TWO_Q_IN_PERCENT of the frames, and further hits there
+ * do not promote it, so a scan only cycles through A1in. The pages evicted from A1in are remembered in the ghost list
+ * A1out, of up to TWO_Q_OUT_PERCENT of the frames. A page read again while it is in A1out enters Am, which is an LRU
+ * list of the frames holding the pages that were reused.
+ */
+class TwoQueueReplacer : public Replacer {
+ public:
+  explicit TwoQueueReplacer(size_t num_frames);
+
+  ~TwoQueueReplacer() override = default;
+
+  auto Evict() -> std::optional<int> override;
+
+  void RecordAccess(int frame_id, int page_id, AccessType access_type = AccessType::Unknown) override;
+
+  void SetEvictable(int frame_id, bool set_evictable) override;
+
+  void Remove(int frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void Clean() override;
+
+ private:
+  // Return the least recent evictable frame of a list, or -1
+  auto FindVictim(const FrameList &frames) const -> int;
+
+  size_t in_size_;
+  size_t out_size_;
+  FrameList in_;
+  FrameList main_;
+  GhostList out_;
+  vector<int> page_ids_;
+  vector<bool> evictable_;
+  size_t evictable_size_{0};
+};
+
+}
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef COMPARATOR_H
 #define COMPARATOR_H
 
+#include <string>
+
+#include "b_plus_tree/normalized_key.h"
+
 namespace sjtu {
 
 constexpr int kMod1 = 1e9 + 7;
@@ -44,6 +48,20 @@ struct Comparator {
     }
     return 0;
   }
+  static auto Normalize(const Key &x) -> NormalizedBytes<12> {
+    NormalizedBytes<12> res;
+    EncodeInt(x.hash1_, res.bytes_);
+    EncodeInt(x.hash2_, res.bytes_ + 4);
+    EncodeInt(x.value_, res.bytes_ + 8);
+    return res;
+  }
+  static auto Denormalize(const NormalizedBytes<12> &x) -> Key {
+    Key res;
+    res.hash1_ = DecodeInt(x.bytes_);
+    res.hash2_ = DecodeInt(x.bytes_ + 4);
+    res.value_ = DecodeInt(x.bytes_ + 8);
+    return res;
+  }
 };
 
 struct RoughComparator {
@@ -62,6 +80,9 @@ struct RoughComparator {
     }
     return 0;
   }
+  auto Hash(const Key &x) const -> unsigned {
+    return static_cast<unsigned>(x.hash1_);
+  }
 };
 
 }
@@ -4,11 +4,36 @@
 namespace sjtu {
 
 static constexpr int BUSTUB_PAGE_SIZE = 8192;                                        // size of a data page in byte
+static constexpr int POINT_INDEX_PAGE_SIZE = 4096;                                   // page size of point-lookup indexes
+static constexpr int SCAN_INDEX_PAGE_SIZE = 32768;                                   // page size of order history indexes
+static constexpr int TRAIN_PAGE_SIZE = 32768;                                         // page size of the train records
+static constexpr int SEAT_CACHE_SIZE = 4096;                                         // seat rows held by the seat cache
 static constexpr int BUFFER_POOL_SIZE = 128;                                         // size of buffer pool
+static constexpr int INDEX_BUFFER_POOL_SIZE = 100;                                   // size of the buffer pool of an index
 static constexpr int DEFAULT_DB_IO_SIZE = 16;                                        // starting size of file on disk
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;                                           // backward k-distance for lru-k
+static constexpr int TWO_Q_IN_PERCENT = 25;                                          // frames of the 2q fifo of new pages
+static constexpr int TWO_Q_OUT_PERCENT = 50;                                         // evicted pages remembered by 2q
 static constexpr int MAX_SEAT_NUM = 100000;
+static constexpr int LOG_FLUSH_INTERVAL_MS = 5;                                      // max delay of a group commit
+static constexpr int LOG_FLUSH_RECORD_CNT = 256;                                     // max records in a group commit
+static constexpr int CHECKPOINT_RECORD_CNT = 100000;                                 // log records between checkpoints
+static constexpr int DIRTY_HIGH_WATER_PERCENT = 25;                                  // dirty frames before write-back
+static constexpr int FLUSHER_INTERVAL_MS = 10;                                       // period of the background flusher
+static constexpr int FLUSHER_BATCH_PERCENT = 10;                                     // frames the flusher pins at once
+static constexpr int DISK_SCHEDULER_WORKER_CNT = 2;                                  // io workers of each buffer pool
+static constexpr int READ_AHEAD_PAGE_CNT = 4;                                        // leaves read ahead by a scan
+static constexpr int SCAN_RING_SIZE = 16;                                            // private frames of a sequential scan
+static constexpr int RESIDENT_FRAME_PERCENT = 25;                                    // frames kept for the upper tree levels
+static constexpr bool POINTER_SWIZZLING = true;                                      // resident pages pinned by their frame
+static constexpr bool DIRECT_IO = false;                                             // b+ tree pages bypass page cache
+static constexpr int DIRECT_IO_ALIGNMENT = 4096;                                     // alignment of O_DIRECT buffers
+static constexpr int MAX_TREE_HEIGHT = 8;                                            // pages kept inline on a tree descent
+static constexpr int APPEND_SPLIT_PERCENT = 90;                                      // entries kept by a leaf an append splits
+static constexpr int APPEND_HINT_SLOT_CNT = 64;                                      // prefixes whose last leaf is remembered
+static constexpr int BLOOM_FILTER_BITS_PER_KEY = 16;                                 // bits of a Bloom filter per key
+static constexpr int BLOOM_FILTER_MIN_KEYS = 1024;                                   // smallest capacity of a Bloom filter
 
 using txn_id_t = int64_t;      // transaction id type
 
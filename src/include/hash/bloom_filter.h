@@ -0,0 +1,52 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace sjtu {
+
+/**
+ * A blocked Bloom filter over the 32-bit hashes of the keys of an index.
+ *
+ * A key sets one bit in each of the 8 words of a single 64-byte block, so a lookup touches one cache line. The filter
+ * is sized for a capacity of keys with BLOOM_FILTER_BITS_PER_KEY bits each. Keys cannot be removed, so the owner
+ * rebuilds the filter once more keys than its capacity were added since the last reset.
+ *
+ * Add and MayContain may run concurrently. Reset and CopyFrom reallocate or overwrite the bits, so no other operation
+ * may run meanwhile.
+ */
+class BloomFilter {
+ public:
+  // Clear the filter and size it for capacity keys
+  void Reset(int capacity);
+  void Add(unsigned hash);
+  // Returns false only if no key of this hash was added since the last reset
+  auto MayContain(unsigned hash) const -> bool;
+  auto GetCapacity() const -> int;
+  // The number of keys added since the last reset, including the ones removed from the index since
+  auto GetKeyCnt() const -> int;
+  void SetKeyCnt(int key_cnt);
+  auto GetByteCnt() const -> size_t;
+  // Copy size bytes of the bits from or to offset, to persist the filter in pages
+  void CopyTo(size_t offset, size_t size, char *data) const;
+  void CopyFrom(size_t offset, size_t size, const char *data);
+  // Set when an Add changes a bit
+  auto IsDirty() const -> bool;
+  void SetClean();
+
+ private:
+  static constexpr int kBlockWords = 8;
+
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  size_t block_cnt_{0};
+  int capacity_{0};
+  std::atomic<int> key_cnt_{0};
+  std::atomic<bool> is_dirty_{false};
+};
+
+}
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * extendible_hash_table.h
+ *
+ * Implementation of a disk-based extendible hash table for indexes that only serve exact-match lookups.
+ * (1) We only support unique key
+ * (2) support insert & remove, buckets split when full and merge with their split image when they get sparse
+ * (3) The directories grow and shrink with the buckets, and split once they cannot grow any more
+ */
+#ifndef EXTENDIBLE_HASH_TABLE_H
+#define EXTENDIBLE_HASH_TABLE_H
+
+#include <atomic>
+#include <string>
+
+#include "b_plus_tree/page_guard.h"
+#include "hash/bloom_filter.h"
+#include "hash/hash_table_bucket_page.h"
+#include "hash/hash_table_directory_page.h"
+#include "hash/hash_table_header_page.h"
+#include "my_stl/vector.hpp"
+
+namespace sjtu {
+
+/**
+ * Hash a key by its bytes. This is only correct for keys whose comparator compares every byte, such as the fixed-size
+ * names of users, trains and stations.
+ */
+template <typename KeyType>
+struct BytesHasher {
+  auto operator()(const KeyType &key) const -> unsigned {
+    auto bytes = reinterpret_cast<const unsigned char *>(&key);
+    unsigned hash = 2166136261U;
+    for (size_t i = 0; i < sizeof(KeyType); ++i) {
+      hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    // the high bits pick the directory and FNV-1a mixes them poorly, so finish with the mixer of MurmurHash3
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35U;
+    hash ^= hash >> 16;
+    return hash;
+  }
+};
+
+#define HASH_TABLE_TEMPLATE_ARGUMENTS \
+  template <typename KeyType, typename ValueType, typename KeyComparator, typename KeyHasher, int PageSize>
+#define HASH_TABLE_TEMPLATE_DECLARATION \
+  template <typename KeyType, typename ValueType, typename KeyComparator, \
+            typename KeyHasher = BytesHasher<KeyType>, int PageSize = POINT_INDEX_PAGE_SIZE>
+#define HASH_TABLE_TYPE ExtendibleHashTable<KeyType, ValueType, KeyComparator, KeyHasher, PageSize>
+
+HASH_TABLE_TEMPLATE_DECLARATION
+class ExtendibleHashTable;
+
+/**
+ * Main class providing the API for the extendible hash table. It exposes the point-lookup part of the BPlusTree API,
+ * so a lookup reads the header page, a directory page and a single bucket page whatever the number of entries.
+ *
+ * A Bloom filter of the keys is kept in memory and consulted before any page is fetched, so most lookups of a missing
+ * key cost no page fetch at all. The filter is saved in pages of the table by checkpoints and snapshots, where no other
+ * operation runs, and is rebuilt there from the buckets once it holds more keys than its capacity.
+ *
+ * Readers crab their read latches from the header page to the bucket. Writers hold the write latch of the directory
+ * while they change a bucket, so splits and merges, which change the directory and several buckets, are atomic. The
+ * header page is only write latched to create or split a directory.
+ */
+HASH_TABLE_TEMPLATE_ARGUMENTS
+class ExtendibleHashTable {
+  static_assert(PageSize % DIRECT_IO_ALIGNMENT == 0, "pages must be aligned for direct I/O");
+  using DirectoryPage = HashTableDirectoryPage<PageSize>;
+  using BucketPage = HashTableBucketPage<KeyType, ValueType, KeyComparator, PageSize>;
+  static_assert(sizeof(HashTableHeaderPage) <= PageSize && sizeof(DirectoryPage) <= PageSize,
+                "hash table pages must fit in a page");
+
+ public:
+  explicit ExtendibleHashTable(std::string name,
+                               ReplacerType replacer_type = ReplacerType::LRU_K,
+                               int bucket_max_size = HASH_TABLE_BUCKET_SLOT_CNT,
+                               int directory_max_depth = DirectoryPage::kMaxDepth);
+
+  ~ExtendibleHashTable();
+
+  // Returns true if this hash table has no keys and values.
+  auto IsEmpty() const -> bool;
+
+  // Insert a key-value pair into this hash table, return false if the key exists.
+  auto Insert(const KeyType &key, const ValueType &value) -> bool;
+
+  // Remove a key and its value from this hash table.
+  void Remove(const KeyType &key);
+
+  // Return the value associated with a given key
+  auto GetValue(const KeyType &key, vector<ValueType> *result) -> bool;
+
+  // Return the number of inserted entries, which removes do not decrease
+  auto GetSize() const -> int;
+
+  void Clean();
+
+  // Two phases of a checkpoint, see DiskManager
+  void PrepareCheckpoint(size_t epoch, vector<std::string> *files);
+
+  void ApplyCheckpoint();
+
+  // Snapshots of the whole table, see DiskManager. No other operation may run meanwhile.
+  auto CreateSnapshot(const std::string &name) -> bool;
+
+  auto SwitchSnapshot(const std::string &name) -> bool;
+
+  auto DropSnapshot(const std::string &name) -> bool;
+
+  // Append the storage statistics of this table
+  void CollectStats(vector<FileStats> *stats);
+
+  // Check the structural invariants of this hash table, only used in tests
+  auto CheckIntegrity() -> bool;
+
+ private:
+  void SaveHeader();
+
+  // Save the filter if it changed since it was last saved or loaded, rebuilding it first if it is full
+  void SaveFilter();
+
+  void LoadFilter();
+
+  // Size the filter for twice the current entries and add the key of every entry
+  void RebuildFilter();
+
+  auto Hash(const KeyType &key) const -> unsigned;
+
+  void SplitDirectory(HashTableHeaderPage *header_page, WritePageGuard *directory_guard);
+
+  // member variable
+  std::string index_name_;
+  std::shared_ptr<DiskManager> disk_manager_;
+  BufferPoolManager *bpm_;
+  KeyComparator comparator_;
+  KeyHasher hasher_;
+  int bucket_max_size_;
+  int directory_max_depth_;
+  int header_page_id_;
+  // the number of inserted entries and of current entries, saved to the header page only by SaveHeader
+  std::atomic<int> size_{0};
+  std::atomic<int> entry_cnt_{0};
+  BloomFilter filter_;
+  // the lookups of a missing key that the filter answered, and the ones it let through
+  std::atomic<size_t> filter_negative_cnt_{0};
+  std::atomic<size_t> filter_false_positive_cnt_{0};
+};
+
+}
+
+#endif
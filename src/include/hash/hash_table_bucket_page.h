@@ -0,0 +1,58 @@
+#ifndef HASH_TABLE_BUCKET_PAGE_H
+#define HASH_TABLE_BUCKET_PAGE_H
+
+#include "config.h"
+
+namespace sjtu {
+
+#define HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS \
+  template <typename KeyType, typename ValueType, typename KeyComparator, int PageSize>
+#define HASH_TABLE_BUCKET_PAGE_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator, PageSize>
+#define HASH_TABLE_BUCKET_HEADER_SIZE 8
+#define HASH_TABLE_BUCKET_SLOT_CNT \
+  ((PageSize - HASH_TABLE_BUCKET_HEADER_SIZE) / ((int)(sizeof(KeyType) + sizeof(ValueType))))  // NOLINT
+
+/**
+ * A bucket page of an extendible hash table, holding unique keys and their values in no particular order.
+ *
+ * Bucket page format:
+ *  ---------------------------------------------------------------------------
+ * | CurrentSize (4) | MaxSize (4) | KEY(1) ... KEY(n) | VALUE(1) ... VALUE(n) |
+ *  ---------------------------------------------------------------------------
+ *
+ * The number of slots is derived from the page size of the table.
+ */
+HASH_TABLE_BUCKET_TEMPLATE_ARGUMENTS
+class HashTableBucketPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableBucketPage() = delete;
+  HashTableBucketPage(const HashTableBucketPage &other) = delete;
+
+  void Init(int max_size = HASH_TABLE_BUCKET_SLOT_CNT);
+
+  // Returns true and sets value if the key is in the bucket
+  auto Lookup(const KeyType &key, ValueType *value, KeyComparator &comparator) const -> bool;
+  // Returns false if the key is already in the bucket. The bucket must not be full.
+  auto Insert(const KeyType &key, const ValueType &value, KeyComparator &comparator) -> bool;
+  // Returns false if the key is not in the bucket
+  auto Remove(const KeyType &key, KeyComparator &comparator) -> bool;
+  // Move the last entry into slot index
+  void RemoveAt(int index);
+  auto KeyAt(int index) const -> KeyType;
+  auto ValueAt(int index) const -> ValueType;
+  auto Size() const -> int;
+  auto GetMaxSize() const -> int;
+  auto IsFull() const -> bool;
+  auto IsEmpty() const -> bool;
+
+ private:
+  int size_;
+  int max_size_;
+  KeyType key_array_[HASH_TABLE_BUCKET_SLOT_CNT];
+  ValueType value_array_[HASH_TABLE_BUCKET_SLOT_CNT];
+};
+
+}
+
+#endif
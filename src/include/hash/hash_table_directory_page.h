@@ -0,0 +1,77 @@
+#ifndef HASH_TABLE_DIRECTORY_PAGE_H
+#define HASH_TABLE_DIRECTORY_PAGE_H
+
+#include <cstdint>
+
+#include "config.h"
+
+namespace sjtu {
+
+#define HASH_TABLE_DIRECTORY_HEADER_SIZE 12
+
+/**
+ * The largest depth of a directory whose slots fit in a page: every slot takes a one-byte local depth and a four-byte
+ * bucket page id.
+ */
+constexpr auto HashTableDirectoryMaxDepth(int page_size) -> int {
+  int depth = 0;
+  while (HASH_TABLE_DIRECTORY_HEADER_SIZE + (2 << depth) * 5 <= page_size) {
+    ++depth;
+  }
+  return depth;
+}
+
+/**
+ * A directory page of an extendible hash table. The lowest global_depth_ bits of a hash select a slot, and every slot
+ * points to a bucket page. A bucket of local depth d is shared by the 2^(global_depth_ - d) slots whose lowest d bits
+ * are the same.
+ *
+ * In the same way, a directory of header depth h is shared by the slots of the header page whose highest h bits are
+ * the same, and it only holds the keys whose hashes start with these bits.
+ *
+ * Directory page format:
+ *  ----------------------------------------------------------------------------------------------------------------
+ * | MaxDepth (4) | GlobalDepth (4) | HeaderDepth (4) | LocalDepths (2^kMaxDepth) | BucketPageIds (4 * 2^kMaxDepth) |
+ *  ----------------------------------------------------------------------------------------------------------------
+ */
+template <int PageSize>
+class HashTableDirectoryPage {
+ public:
+  static constexpr int kMaxDepth = HashTableDirectoryMaxDepth(PageSize);
+  static constexpr int kArraySize = 1 << kMaxDepth;
+
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableDirectoryPage() = delete;
+  HashTableDirectoryPage(const HashTableDirectoryPage &other) = delete;
+
+  // Init a directory of global and header depth 0, whose only slot points to bucket_page_id
+  void Init(int bucket_page_id, int max_depth = kMaxDepth);
+
+  auto HashToBucketIndex(unsigned hash) const -> int;
+  auto GetBucketPageId(int bucket_idx) const -> int;
+  void SetBucketPageId(int bucket_idx, int bucket_page_id);
+  auto GetLocalDepth(int bucket_idx) const -> int;
+  void SetLocalDepth(int bucket_idx, int local_depth);
+  auto GetGlobalDepth() const -> int;
+  auto GetMaxDepth() const -> int;
+  auto GetHeaderDepth() const -> int;
+  void SetHeaderDepth(int header_depth);
+  // Double the directory, the new half of the slots is a copy of the old one
+  void IncrGlobalDepth();
+  void DecrGlobalDepth();
+  // Returns true if every bucket has a local depth smaller than the global depth
+  auto CanShrink() const -> bool;
+  // The number of slots in use
+  auto Size() const -> int;
+
+ private:
+  int max_depth_;
+  int global_depth_;
+  int header_depth_;
+  uint8_t local_depths_[kArraySize];
+  int bucket_page_ids_[kArraySize];
+};
+
+}
+
+#endif
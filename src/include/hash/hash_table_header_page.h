@@ -0,0 +1,55 @@
+#ifndef HASH_TABLE_HEADER_PAGE_H
+#define HASH_TABLE_HEADER_PAGE_H
+
+namespace sjtu {
+
+#define HASH_TABLE_HEADER_MAX_DEPTH 9
+#define HASH_TABLE_HEADER_ARRAY_SIZE (1 << HASH_TABLE_HEADER_MAX_DEPTH)
+
+/**
+ * The header page of an extendible hash table. The highest HASH_TABLE_HEADER_MAX_DEPTH bits of a hash select one of
+ * the directory pages. A directory is shared by several slots until it is full and split, so a small table has a
+ * single directory. Directories are never deleted.
+ *
+ * A page that was never written is all zeros, so a max_depth_ of 0 marks a header page that is not initialized yet.
+ * A filter_page_id_ of -1 means that the Bloom filter was never saved, and it is rebuilt from the buckets.
+ */
+class HashTableHeaderPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableHeaderPage() = delete;
+  HashTableHeaderPage(const HashTableHeaderPage &other) = delete;
+
+  void Init() {
+    page_cnt_ = 0;
+    size_ = 0;
+    entry_cnt_ = 0;
+    max_depth_ = HASH_TABLE_HEADER_MAX_DEPTH;
+    filter_page_id_ = -1;
+    filter_page_cnt_ = 0;
+    filter_capacity_ = 0;
+    filter_key_cnt_ = 0;
+    for (int i = 0; i < HASH_TABLE_HEADER_ARRAY_SIZE; ++i) {
+      directory_page_ids_[i] = -1;
+    }
+  }
+
+  auto HashToDirectoryIndex(unsigned hash) const -> int {
+    return max_depth_ == 0 ? 0 : static_cast<int>(hash >> (32 - max_depth_));
+  }
+
+  int page_cnt_;
+  int size_;  // the number of inserted entries, see ExtendibleHashTable::GetSize
+  int entry_cnt_;
+  int max_depth_;
+  // the Bloom filter of the table is saved in filter_page_cnt_ consecutive pages from filter_page_id_
+  int filter_page_id_;
+  int filter_page_cnt_;
+  int filter_capacity_;
+  int filter_key_cnt_;
+  int directory_page_ids_[HASH_TABLE_HEADER_ARRAY_SIZE];
+};
+
+}
+
+#endif
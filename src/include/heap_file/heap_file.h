@@ -0,0 +1,106 @@
+#ifndef HEAP_FILE_H
+#define HEAP_FILE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "config.h"
+#include "heap_file/heap_page.h"
+
+namespace sjtu {
+
+/**
+ * A record id: the page of a record in its heap file and its slot in the page.
+ */
+struct Rid {
+  int page_id_{-1};
+  int slot_{-1};
+};
+
+/**
+ * The header page of a heap file.
+ */
+class HeapFileHeaderPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HeapFileHeaderPage() = delete;
+  HeapFileHeaderPage(const HeapFileHeaderPage &other) = delete;
+
+  int page_cnt_;
+  int last_page_id_;  // the page new records are appended to, -1 if there is none
+};
+
+/**
+ * @brief A heap file stores records in slotted pages (see `HeapPage`) and addresses them by record id.
+ *
+ * Indexes store the record ids of large records instead of the records, so a record shared by several indexes is
+ * stored once, and changing it is a single update in place. Records are appended to the last page, and are never
+ * moved or deleted until the file is cleaned.
+ *
+ * Like a B+ tree, a heap file goes through its own buffer pool and disk manager, so it follows the same checkpoints
+ * and snapshots. Inserts are serialized by a latch, while reads and updates only latch the page of their record.
+ */
+class HeapFile {
+ public:
+  explicit HeapFile(std::string name, ReplacerType replacer_type = ReplacerType::LRU_K,
+                    size_t page_size = BUSTUB_PAGE_SIZE);
+
+  ~HeapFile();
+
+  auto Insert(const char *data, size_t size) -> Rid;
+
+  // Copy `size` bytes of a record starting from `offset`
+  void Read(const Rid &rid, char *data, size_t offset, size_t size);
+
+  // Overwrite `size` bytes of a record starting from `offset`, the rest of the record is left untouched
+  void Update(const Rid &rid, const char *data, size_t offset, size_t size);
+
+  template <class T>
+  auto Insert(const T &record) -> Rid {
+    return Insert(reinterpret_cast<const char *>(&record), sizeof(T));
+  }
+
+  template <class T>
+  auto Get(const Rid &rid) -> T {
+    T record;
+    Read(rid, reinterpret_cast<char *>(&record), 0, sizeof(T));
+    return record;
+  }
+
+  template <class T>
+  void Update(const Rid &rid, const T &record) {
+    Update(rid, reinterpret_cast<const char *>(&record), 0, sizeof(T));
+  }
+
+  // Drop every record
+  void Clean();
+
+  // see BPlusTree::PrepareCheckpoint
+  void PrepareCheckpoint(size_t epoch, vector<std::string> *files);
+
+  void ApplyCheckpoint();
+
+  auto CreateSnapshot(const std::string &name) -> bool;
+
+  auto SwitchSnapshot(const std::string &name) -> bool;
+
+  auto DropSnapshot(const std::string &name) -> bool;
+
+  void CollectStats(vector<FileStats> *stats);
+
+ private:
+  void SavePageCnt();
+
+  std::shared_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  const size_t page_size_;
+  int header_page_id_;
+  // serializes inserts
+  std::mutex latch_;
+};
+
+}
+
+#endif //HEAP_FILE_H
@@ -0,0 +1,60 @@
+#ifndef HEAP_PAGE_H
+#define HEAP_PAGE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sjtu {
+
+/**
+ * A slotted page of a heap file.
+ *
+ * Heap page format:
+ *  ----------------------------------------------------------------
+ * | HEADER | SLOT(0) | SLOT(1) | ... | FREE SPACE | ... | RECORD(1) | RECORD(0) |
+ *  ----------------------------------------------------------------
+ *
+ *  Header format (size in byte, 8 bytes in total):
+ *  ---------------------------------
+ * | SlotCnt (4) | FreeSpaceEnd (4) |
+ *  ---------------------------------
+ *
+ * The slot directory grows forwards and the records backwards from the end of the page. A slot holds the offset and
+ * the size of its record, so a record keeps its slot, and its record id, for its whole life. Records are aligned to
+ * 8 bytes.
+ */
+class HeapPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HeapPage() = delete;
+  HeapPage(const HeapPage &other) = delete;
+
+  void Init(size_t page_size);
+
+  // Insert a record, return its slot, or -1 if the page has no room for it
+  auto InsertRecord(const char *data, size_t size) -> int;
+
+  auto GetRecord(int slot) const -> const char *;
+
+  auto GetRecordMut(int slot) -> char *;
+
+  auto GetRecordSize(int slot) const -> size_t;
+
+  auto GetSlotCnt() const -> int;
+
+ private:
+  struct Slot {
+    uint32_t offset_;
+    uint32_t size_;
+  };
+
+  auto GetSlots() const -> const Slot *;
+  auto GetSlotsMut() -> Slot *;
+
+  uint32_t slot_cnt_;
+  uint32_t free_space_end_;
+};
+
+}
+
+#endif //HEAP_PAGE_H
@@ -1,14 +1,15 @@
 #ifndef ALGORITHM_HPP
 #define ALGORITHM_HPP
 
+#include <utility>
+
 namespace sjtu {
 
 template <typename T>
 void swap(T &x, T &y) {
-  static T tmp;
-  tmp = x;
-  x = y;
-  y = tmp;
+  T tmp = std::move(x);
+  x = std::move(y);
+  y = std::move(tmp);
 }
 
 template <typename T>
@@ -0,0 +1,122 @@
+#ifndef SJTU_SMALL_VECTOR_HPP
+#define SJTU_SMALL_VECTOR_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace sjtu {
+
+/**
+ * A sequence that keeps its first N elements inline and only allocates on the heap beyond them.
+ *
+ * It is meant for short-lived stacks such as the pages on the path of a tree descent. Both ends can be popped in O(1),
+ * and no element is ever moved except when the storage grows, so a pointer to an element stays valid until the next
+ * push. Copying is not supported, since the elements may be guards.
+ */
+template<typename T, size_t N>
+class SmallVector {
+public:
+  SmallVector() = default;
+  SmallVector(const SmallVector &) = delete;
+  SmallVector &operator = (const SmallVector &) = delete;
+  ~SmallVector() {
+    clear();
+    if (data_ != InlineData()) {
+      operator delete (data_);
+    }
+  }
+
+  template<typename... Args>
+  T &emplace_back(Args &&... args) {
+    if (end_ == capacity_) {
+      Grow();
+    }
+    new (data_ + end_) T(std::forward<Args>(args)...);
+    return data_[end_++];
+  }
+  void push_back(const T &value) {
+    emplace_back(value);
+  }
+  void pop_back() {
+    data_[--end_].~T();
+    Rewind();
+  }
+  void pop_front() {
+    data_[begin_++].~T();
+    Rewind();
+  }
+  void clear() {
+    while (end_ > begin_) {
+      data_[--end_].~T();
+    }
+    begin_ = end_ = 0;
+  }
+
+  T &operator [] (size_t pos) {
+    return data_[begin_ + pos];
+  }
+  const T &operator [] (size_t pos) const {
+    return data_[begin_ + pos];
+  }
+  T &front() {
+    return data_[begin_];
+  }
+  const T &front() const {
+    return data_[begin_];
+  }
+  T &back() {
+    return data_[end_ - 1];
+  }
+  const T &back() const {
+    return data_[end_ - 1];
+  }
+  T *begin() {
+    return data_ + begin_;
+  }
+  T *end() {
+    return data_ + end_;
+  }
+  size_t size() const {
+    return end_ - begin_;
+  }
+  bool empty() const {
+    return end_ == begin_;
+  }
+
+private:
+  T *InlineData() {
+    return reinterpret_cast<T *>(inline_);
+  }
+  // reuse the storage from its start once every element is popped
+  void Rewind() {
+    if (begin_ == end_) {
+      begin_ = end_ = 0;
+    }
+  }
+  void Grow() {
+    size_t size = end_ - begin_;
+    T *data = static_cast<T *>(operator new (capacity_ * 2 * sizeof(T)));
+    for (size_t i = 0; i < size; ++i) {
+      new (data + i) T(std::move(data_[begin_ + i]));
+      data_[begin_ + i].~T();
+    }
+    if (data_ != InlineData()) {
+      operator delete (data_);
+    }
+    data_ = data;
+    capacity_ *= 2;
+    begin_ = 0;
+    end_ = size;
+  }
+
+  alignas(T) unsigned char inline_[N * sizeof(T)];
+  T *data_{InlineData()};
+  size_t begin_{0};
+  size_t end_{0};
+  size_t capacity_{N};
+};
+
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef RECORD_FILE_HPP
+#define RECORD_FILE_HPP
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "config.h"
+
+namespace sjtu {
+
+/**
+ * @brief A pinned, read-only view of a record of a `RecordFile`.
+ *
+ * The page of the record stays pinned and read-latched until the guard is dropped, so the record can be read in place
+ * without a copy. Do not update a record of the same page while holding a guard on it.
+ */
+template <class T>
+class RecordGuard {
+ public:
+  RecordGuard(ReadPageGuard guard, size_t offset)
+      : guard_(std::move(guard)), record_(reinterpret_cast<const T *>(guard_.GetData() + offset)) {}
+
+  auto operator*() const -> const T & { return *record_; }
+
+  auto operator->() const -> const T * { return record_; }
+
+ private:
+  ReadPageGuard guard_;
+  const T *record_;
+};
+
+/**
+ * @brief A file of fixed-size records addressed by their index.
+ *
+ * Record `index` lives in page `index / kRecordsPerPage + 2` (page 1 is the header page), at slot
+ * `index % kRecordsPerPage`, so a record never crosses pages. Records are read and written through a buffer pool, so
+ * hot records are cached and the file follows the same checkpoints and snapshots as the B+ trees.
+ */
+template <class T, int PageSize = BUSTUB_PAGE_SIZE>
+class RecordFile {
+  static constexpr size_t kRecordsPerPage = PageSize / sizeof(T);
+  static_assert(kRecordsPerPage > 0, "a record must fit in a page");
+
+  struct HeaderPage {
+    int page_cnt_;
+  };
+
+ public:
+  explicit RecordFile(std::string name, ReplacerType replacer_type = ReplacerType::LRU_K)
+      : disk_manager_(std::make_shared<DiskManager>(std::move(name), DIRECT_IO, PageSize)),
+        bpm_(std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_, LRUK_REPLACER_K, 0, replacer_type)),
+        header_page_id_(bpm_->NewPage()) {
+    int page_cnt = bpm_->ReadPage(header_page_id_).template As<HeaderPage>()->page_cnt_;
+    if (page_cnt != 0) {
+      bpm_->InitPageCnt(page_cnt);
+    }
+  }
+
+  ~RecordFile() {
+    SavePageCnt();
+    bpm_->FlushAllPages();
+    disk_manager_->Apply();
+  }
+
+  // Pin the record and read it in place
+  auto Read(size_t index) -> RecordGuard<T> {
+    return {bpm_->ReadPage(PageOf(index)), SlotOf(index) * sizeof(T)};
+  }
+
+  auto Get(size_t index) -> T { return *Read(index); }
+
+  void Update(const T &t, size_t index) { Update(t, index, 0, sizeof(T)); }
+
+  // only write the `len` bytes of t starting from `offset`, so that other parts of the record are left untouched
+  void Update(const T &t, size_t index, size_t offset, size_t len) {
+    Update(index, offset, reinterpret_cast<const char *>(&t) + offset, len);
+  }
+
+  // write `len` bytes into the record starting from `offset`
+  void Update(size_t index, size_t offset, const char *data, size_t len) {
+    int page_id = PageOf(index);
+    Allocate(page_id);
+    auto guard = bpm_->WritePage(page_id);
+    memcpy(guard.GetDataMut() + SlotOf(index) * sizeof(T) + offset, data, len);
+  }
+
+  // drop every record
+  void Clean() {
+    std::scoped_lock latch(latch_);
+    bpm_->Clean();
+    header_page_id_ = bpm_->NewPage();
+  }
+
+  // see BPlusTree::PrepareCheckpoint
+  void PrepareCheckpoint(size_t epoch, vector<std::string> *files) {
+    SavePageCnt();
+    bpm_->FlushAllPages();
+    disk_manager_->Prepare(epoch);
+    files->push_back(disk_manager_->GetFileName());
+  }
+
+  void ApplyCheckpoint() { disk_manager_->Apply(); }
+
+  auto CreateSnapshot(const std::string &name) -> bool {
+    SavePageCnt();
+    return bpm_->CreateSnapshot(name);
+  }
+
+  auto SwitchSnapshot(const std::string &name) -> bool {
+    if (!bpm_->SwitchSnapshot(name)) {
+      return false;
+    }
+    bpm_->InitPageCnt(bpm_->ReadPage(header_page_id_).template As<HeaderPage>()->page_cnt_);
+    return true;
+  }
+
+  auto DropSnapshot(const std::string &name) -> bool { return bpm_->DropSnapshot(name); }
+
+  void CollectStats(vector<FileStats> *stats) { stats->push_back(bpm_->GetStats()); }
+
+ private:
+  static auto PageOf(size_t index) -> int { return static_cast<int>(index / kRecordsPerPage) + 2; }
+
+  static auto SlotOf(size_t index) -> size_t { return index % kRecordsPerPage; }
+
+  // allocate the pages up to `page_id`, so that the page counter covers every written record
+  void Allocate(int page_id) {
+    std::scoped_lock latch(latch_);
+    while (bpm_->PageCnt() < page_id) {
+      bpm_->NewPage();
+    }
+  }
+
+  // see BPlusTree::SaveHeader
+  void SavePageCnt() {
+    int page_cnt = bpm_->PageCnt();
+    if (bpm_->ReadPage(header_page_id_).template As<HeaderPage>()->page_cnt_ != page_cnt) {
+      bpm_->WritePage(header_page_id_).template AsMut<HeaderPage>()->page_cnt_ = page_cnt;
+    }
+  }
+
+  std::shared_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  int header_page_id_;
+  // serializes page allocation
+  std::mutex latch_;
+};
+
+}
+
+#endif //RECORD_FILE_HPP
@@ -0,0 +1,94 @@
+#ifndef LOG_MANAGER_H
+#define LOG_MANAGER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "my_stl/vector.hpp"
+
+namespace sjtu {
+
+/**
+ * @brief LogManager maintains the redo log of the system.
+ *
+ * The log starts with the record of the last checkpoint, followed by the command lines that changed the state since
+ * then. Commands are deterministic, so replaying them on the state of the checkpoint rebuilds the state before a crash.
+ *
+ * Records are appended to an in-memory buffer, and a background thread writes and syncs the buffer once every
+ * LOG_FLUSH_INTERVAL_MS, or as soon as LOG_FLUSH_RECORD_CNT records are waiting (group commit). A log sequence number
+ * (lsn) is durable once every record up to it is synced.
+ *
+ * A checkpoint is committed by atomically replacing the log with a new one that holds only the checkpoint record:
+ * the checkpoint epoch, the database files it prepared (see DiskManager) and the logged-in users.
+ */
+class LogManager {
+ public:
+  /**
+   * @brief Open the log and finish the last committed checkpoint if needed.
+   *
+   * The commands to replay and the logged-in users of the checkpoint can then be fetched by `GetRecords` and
+   * `GetSessions`.
+   *
+   * @param log_file the file name of the log
+   */
+  explicit LogManager(std::string log_file);
+
+  ~LogManager();
+
+  // Append a record (a command line) and return its lsn
+  auto Append(const std::string &record) -> size_t;
+
+  // Block until every appended record is durable
+  void Flush();
+
+  auto GetDurableLsn() -> size_t;
+
+  auto GetAppendedLsn() -> size_t;
+
+  // Return the number of records since the last checkpoint
+  auto GetRecordCnt() -> size_t;
+
+  /**
+   * @brief Commit a checkpoint. Every record appended before is dropped.
+   *
+   * @param epoch the epoch of the checkpoint
+   * @param files the database files prepared by the checkpoint
+   * @param sessions the logged-in users
+   */
+  void Checkpoint(size_t epoch, const vector<std::string> &files, const vector<std::string> &sessions);
+
+  // Return the epoch of the last checkpoint, 0 if there is none
+  auto GetEpoch() const -> size_t;
+
+  void GetRecords(vector<std::string> *records) const;
+
+  void GetSessions(vector<std::string> *sessions) const;
+
+ private:
+  void FlushLoop();
+
+  std::string log_file_;
+  int log_fd_{-1};
+  size_t epoch_{0};
+  vector<std::string> records_;   // records to replay
+  vector<std::string> sessions_;  // users logged in at the last checkpoint
+
+  std::mutex latch_;
+  std::condition_variable flush_cv_;    // wakes up the flush thread
+  std::condition_variable durable_cv_;  // wakes up the threads waiting for a flush
+  std::string buffer_;
+  size_t buffer_record_cnt_{0};
+  size_t appended_lsn_{0};
+  size_t durable_lsn_{0};
+  size_t record_cnt_{0};
+  bool flush_requested_{false};
+  bool stop_{false};
+  // held while the log file is written, so that a checkpoint never replaces the file in the middle of a flush
+  std::mutex io_latch_;
+  std::thread flush_thread_;
+};
+
+}
+
+#endif //LOG_MANAGER_H
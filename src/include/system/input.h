@@ -2,6 +2,7 @@
 #define INPUT_H
 
 #include <cassert>
+#include <iostream>
 #include <string>
 #include "my_stl/array.hpp"
 
@@ -9,6 +10,8 @@ namespace sjtu {
 
 class Input {
 public:
+  // `las_c` is the character consumed right before the stream position, '\n' at the beginning of a command line
+  explicit Input(std::istream &is = std::cin, char las_c = '\n') : is_(&is), las_c_(las_c) {}
 
   void Skip();
   auto GetTimestamp() -> int;
@@ -32,7 +35,8 @@ public:
   auto GetChineseArray() -> array<array<unsigned int, len1>, len2>;
 
 private:
-  char las_c_{'\n'};
+  std::istream *is_;
+  char las_c_;
   auto GetSingleChinese() -> unsigned int;
 };
 
@@ -52,36 +52,36 @@ std::string ArrayToString(array<char, len> tmp) {
   return res;
 }
 
-inline void PrintTwoBitNumber(int x) {
+inline void PrintTwoBitNumber(std::ostream &os, int x) {
   if (x < 10) {
-    std::cout << '0' << x;
+    os << '0' << x;
   } else {
     assert(x < 100);
-    std::cout << x;
+    os << x;
   }
 }
 
-inline void PrintTime(int time) {
+inline void PrintTime(std::ostream &os, int time) {
   int day = time / 1440;
   int hour = time % 1440 / 60;
   int minute = time % 1440 % 60;
   if (day < 30) {
-    std::cout << "06-";
-    PrintTwoBitNumber(day + 1);
+    os << "06-";
+    PrintTwoBitNumber(os, day + 1);
   } else if (day < 61) {
-    std::cout << "07-";
-    PrintTwoBitNumber(day - 29);
+    os << "07-";
+    PrintTwoBitNumber(os, day - 29);
   } else if (day < 92) {
-    std::cout << "08-";
-    PrintTwoBitNumber(day - 60);
+    os << "08-";
+    PrintTwoBitNumber(os, day - 60);
   } else {
-    std::cout << "09-";
-    PrintTwoBitNumber(day - 91);
+    os << "09-";
+    PrintTwoBitNumber(os, day - 91);
   }
-  std::cout << ' ';
-  PrintTwoBitNumber(hour);
-  std::cout << ':';
-  PrintTwoBitNumber(minute);
+  os << ' ';
+  PrintTwoBitNumber(os, hour);
+  os << ':';
+  PrintTwoBitNumber(os, minute);
 }
 
 }
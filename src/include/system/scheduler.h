@@ -0,0 +1,85 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "my_stl/list.hpp"
+#include "my_stl/map.hpp"
+#include "my_stl/vector.hpp"
+
+namespace sjtu {
+
+/**
+ * Two lock requests on the same resource are compatible iff they have the same mode and the mode is not exclusive.
+ * kIntention is used on a parent resource by tasks that lock a single child: it is compatible with other kIntention
+ * requests but not with kShared requests, which stand for reading every child at once.
+ */
+enum class LockMode { kShared, kExclusive, kIntention };
+
+struct LockRequest {
+  size_t resource_;
+  LockMode mode_;
+};
+
+/**
+ * @brief A worker pool that runs tasks as if they were run one by one in submission order.
+ *
+ * Each task declares the resources it touches up front. Tasks are queued on each of their resources in submission
+ * order and a task only starts once it is granted all of them, so two conflicting tasks always run in submission order
+ * while unrelated tasks run in parallel. Since a task only waits for tasks submitted before it, no deadlock can happen.
+ *
+ * Every task writes to its own buffer, and the buffers are written to the output in submission order.
+ */
+class Scheduler {
+ public:
+  explicit Scheduler(size_t worker_cnt, size_t window_size = 1024);
+
+  ~Scheduler();
+
+  // Submit a task, blocking while `window_size` tasks are still not flushed
+  void Submit(const vector<LockRequest> &requests, std::function<void(std::ostream &)> task, std::ostream &os);
+
+  // Wait for all submitted tasks to finish and flush their output
+  void Drain(std::ostream &os);
+
+ private:
+  struct Task {
+    std::function<void(std::ostream &)> func_;
+    vector<LockRequest> requests_;
+    size_t waiting_{0};  // the number of requests not granted yet
+    std::ostringstream output_;
+    bool done_{false};
+  };
+
+  struct Waiter {
+    Task *task_;
+    LockMode mode_;
+    bool granted_;
+  };
+
+  void WorkerLoop();
+
+  // Grant the longest compatible prefix of waiters of a resource, pushing tasks that become runnable to ready_
+  void Grant(list<Waiter> *waiters);
+
+  void Release(Task *task);
+
+  void FlushDone(std::ostream &os);
+
+  std::mutex latch_;
+  std::condition_variable ready_cv_;
+  std::condition_variable done_cv_;
+  map<size_t, list<Waiter>> lock_table_;
+  list<Task *> ready_;
+  list<Task *> tasks_;  // tasks not flushed yet, in submission order
+  size_t window_size_;
+  bool stop_{false};
+  list<std::thread> workers_;
+};
+
+}
+
+#endif //SCHEDULER_H
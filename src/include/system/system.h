@@ -5,37 +5,82 @@
 #include "system/train_system/train_system.h"
 #include "system/ticket_system/ticket_system.h"
 #include "system/input.h"
+#include "system/scheduler.h"
+#include "recovery/log_manager.h"
+#include <atomic>
+#include <shared_mutex>
+#include <sstream>
 
 namespace sjtu {
 
 class System {
 public:
   System() = delete;
+  // Open the system and redo the commands logged after the last checkpoint
   explicit System(const std::string &name);
-  void Run();
-  void AddUser();
-  void Login();
-  void Logout();
-  void QueryProfile();
-  void ModifyProfile();
-  void AddTrain();
-  void DeleteTrain();
-  void ReleaseTrain();
-  void QueryTrain();
-  void QueryTicket();
-  void QueryTransfer();
-  void BuyTicket();
-  void QueryOrder();
-  void RefundTicket();
-  void Clean();
+  ~System();
+  // Run commands from std::cin. If worker_cnt > 0, commands are executed by a pool of worker_cnt threads, with the
+  // same output as running them one by one.
+  void Run(size_t worker_cnt = 0);
+  // Run a single command line in the sequential mode, return false if the command is exit. The output is written to
+  // os right away instead of being held for the log, so this is only meant for tools such as the benchmark.
+  auto RunCommand(const std::string &line, std::ostream &os) -> bool;
+  // Append the storage statistics of every database file
+  void CollectStats(vector<FileStats> *stats);
+  void AddUser(Input &input, std::ostream &os);
+  void Login(Input &input, std::ostream &os);
+  void Logout(Input &input, std::ostream &os);
+  void QueryProfile(Input &input, std::ostream &os);
+  void ModifyProfile(Input &input, std::ostream &os);
+  void AddTrain(Input &input, std::ostream &os);
+  void DeleteTrain(Input &input, std::ostream &os);
+  void ReleaseTrain(Input &input, std::ostream &os);
+  void QueryTrain(Input &input, std::ostream &os);
+  void QueryTicket(Input &input, std::ostream &os);
+  void QueryTransfer(Input &input, std::ostream &os);
+  void BuyTicket(int timestamp, Input &input, std::ostream &os);
+  void QueryOrder(Input &input, std::ostream &os);
+  void RefundTicket(Input &input, std::ostream &os);
+  void Clean(std::ostream &os);
+  void CreateSnapshot(Input &input, std::ostream &os);
+  void SwitchSnapshot(Input &input, std::ostream &os);
+  void DropSnapshot(Input &input, std::ostream &os);
+  // Print the storage statistics of every database file and the count and total time of every command
+  void Stats(std::ostream &os);
 private:
+  // Counters of a command. They are updated by the workers without any latch, so each one owns a cache line.
+  struct alignas(64) CommandStats {
+    std::atomic<size_t> cnt_{0};
+    std::atomic<size_t> nanos_{0};
+  };
+  static constexpr int kCommandCnt = 20;
+  struct HeldOutput {
+    size_t lsn_;  // the output is released once the log is durable up to lsn_
+    std::string text_;
+  };
+  LogManager log_manager_; // constructed first, since it finishes the last checkpoint before the data files are opened
+  size_t epoch_;
   UserSystem user_system_;
   TrainSystem train_system_;
   TicketSystem ticket_system_;
   map<array<char, 20>, User> online_users_;
-  Input input_;
-  int timestamp_;
-  void PrintTimestamp() const;
+  std::shared_mutex online_latch_; // protects online_users_
+  std::ostringstream output_; // output not sealed yet
+  list<HeldOutput> held_output_;
+  CommandStats command_stats_[kCommandCnt];
+  // Execute a command whose timestamp and name are already read, return false if the command is exit
+  auto Execute(int timestamp, const std::string &command, Input &input, std::ostream &os) -> bool;
+  auto Dispatch(int timestamp, const std::string &command, Input &input, std::ostream &os) -> bool;
+  void RunParallel(size_t worker_cnt);
+  auto LockRequests(const std::string &line, bool users_empty, vector<LockRequest> *requests) -> bool;
+  auto FindOnlineUser(const array<char, 20> &username, User *user = nullptr) -> bool;
+  // Append the command to the log if it changes the state
+  void LogCommand(const std::string &line);
+  void Checkpoint();
+  // Hold the output so far until the log is durable up to the last appended record
+  void SealOutput();
+  // Print the held output whose records are durable. If wait, flush the log and print everything.
+  void ReleaseOutput(bool wait);
 };
 
 }
@@ -14,14 +14,14 @@ struct Ticket {
   int end_time_;
   int price_;
   int seat_;
-  void Print(TrainSystem *train_system) const {
-    std::cout << ArrayToString<20>(train_system->QueryTrain(train_id_).trainID_) << " ";
-    std::cout << ChineseToString<10>(train_system->StationName(start_station_)) << " ";
-    PrintTime(start_time_);
-    std::cout << " -> ";
-    std::cout << ChineseToString<10>(train_system->StationName(end_station_)) << " ";
-    PrintTime(end_time_);
-    std::cout << " " << price_ << " " << seat_ << '\n';
+  void Print(TrainSystem *train_system, std::ostream &os) const {
+    os << ArrayToString<20>(train_system->ReadTrain(train_id_)->trainID_) << " ";
+    os << ChineseToString<10>(train_system->StationName(start_station_)) << " ";
+    PrintTime(os, start_time_);
+    os << " -> ";
+    os << ChineseToString<10>(train_system->StationName(end_station_)) << " ";
+    PrintTime(os, end_time_);
+    os << " " << price_ << " " << seat_ << '\n';
   }
 };
 
@@ -33,14 +33,14 @@ struct RawTicket {
   int end_time_;
   int price_;
   int seat_;
-  void Print(TrainSystem *train_system) const {
-    std::cout << ArrayToString<20>(train_id_) << " ";
-    std::cout << ChineseToString<10>(train_system->StationName(start_station_)) << " ";
-    PrintTime(start_time_);
-    std::cout << " -> ";
-    std::cout << ChineseToString<10>(train_system->StationName(end_station_)) << " ";
-    PrintTime(end_time_);
-    std::cout << " " << price_ << " " << seat_ << '\n';
+  void Print(TrainSystem *train_system, std::ostream &os) const {
+    os << ArrayToString<20>(train_id_) << " ";
+    os << ChineseToString<10>(train_system->StationName(start_station_)) << " ";
+    PrintTime(os, start_time_);
+    os << " -> ";
+    os << ChineseToString<10>(train_system->StationName(end_station_)) << " ";
+    PrintTime(os, end_time_);
+    os << " " << price_ << " " << seat_ << '\n';
   }
 };
 
@@ -93,6 +93,19 @@ struct BuyInfoComparator {
     }
     return 0;
   }
+  // the user and the time are stored as bytes, see KeyNormalizer
+  static auto Normalize(const BuyInfo &x) -> NormalizedBytes<24> {
+    NormalizedBytes<24> res;
+    EncodeChars(x.user_, res.bytes_);
+    EncodeInt(x.buy_time_, res.bytes_ + 20);
+    return res;
+  }
+  static auto Denormalize(const NormalizedBytes<24> &x) -> BuyInfo {
+    BuyInfo res;
+    DecodeChars(x.bytes_, &res.user_);
+    res.buy_time_ = DecodeInt(x.bytes_ + 20);
+    return res;
+  }
 };
 
 struct RoughBuyInfoComparator {
@@ -105,6 +118,10 @@ struct RoughBuyInfoComparator {
     }
     return 0;
   }
+  // orders of a user are appended in the order of their time, see BPlusTree::FindLeafByHint
+  auto Hash(const BuyInfo &x) const -> unsigned {
+    return BytesHasher<array<char, 20>>()(x.user_);
+  }
 };
 
 struct TimeComparator {
@@ -117,12 +134,15 @@ struct TimeComparator {
     }
     return 0;
   }
+  // times are already integers, see KeyNormalizer
+  static auto Normalize(const int &x) -> int { return x; }
+  static auto Denormalize(const int &x) -> int { return x; }
 };
 
 struct Order {
   BuyInfo info_;
   Ticket ticket_;
-  enum {
+  enum State {
     kSuccess, kPending, kRefunded
   } state_;
 };
@@ -3,23 +3,36 @@
 
 #include "system/ticket_system/ticket.h"
 #include "b_plus_tree/b_plus_tree.h"
+#include "heap_file/heap_file.h"
 
 namespace sjtu {
 
+// Orders are stored once in a heap file, and both indexes only keep their record ids, so that a state change is a
+// single update in place.
 class TicketSystem {
 public:
   void AddOrder(const Order &order);
-  void DeleteOrder(const Order &order);
-  void QueryOrder(const array<char, 20> &user, vector<Order> *tmp);
-  void GetQueue(vector<Order> *tmp);
+  void QueryOrder(const array<char, 20> &user, vector<Rid> *tmp);
+  auto GetOrder(const Rid &rid) -> Order;
+  void SetOrderState(const Rid &rid, Order::State state);
+  void GetQueue(vector<Rid> *tmp);
   void RemoveFromQueue(const int &time);
   void Clean();
+  void PrepareCheckpoint(size_t epoch, vector<std::string> *files);
+  void ApplyCheckpoint();
+  auto CreateSnapshot(const std::string &name) -> bool;
+  auto SwitchSnapshot(const std::string &name) -> bool;
+  auto DropSnapshot(const std::string &name) -> bool;
+  void CollectStats(vector<FileStats> *stats);
   TicketSystem() = delete;
-  explicit TicketSystem(const std::string &name) : orders_(name + "_order"), queue_(name + "_queue") {}
+  // the order trees are scanned, so their pools use a scan-resistant policy
+  explicit TicketSystem(const std::string &name) : orders_(name + "_order", ReplacerType::TWO_Q),
+    queue_(name + "_queue", ReplacerType::TWO_Q), order_records_(name + "_order_records", ReplacerType::CLOCK) {}
 
 private:
-  BPlusTree<BuyInfo, Order, BuyInfoComparator, RoughBuyInfoComparator> orders_;
-  BPlusTree<int, Order, TimeComparator, TimeComparator> queue_;
+  BPlusTree<BuyInfo, Rid, BuyInfoComparator, RoughBuyInfoComparator, SCAN_INDEX_PAGE_SIZE> orders_;
+  BPlusTree<int, Rid, TimeComparator, TimeComparator, SCAN_INDEX_PAGE_SIZE> queue_;
+  HeapFile order_records_;
 };
 
 }
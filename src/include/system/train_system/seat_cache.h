@@ -0,0 +1,69 @@
+#ifndef SEAT_CACHE_H
+#define SEAT_CACHE_H
+
+#include <mutex>
+#include "config.h"
+#include "my_stl/list.hpp"
+#include "my_stl/map.hpp"
+#include "record_file/record_file.hpp"
+#include "system/train_system/train.h"
+
+namespace sjtu {
+
+using Seats = array<int, 23>;
+
+/**
+ * @brief A write-back cache of the seat rows of trains, one row per (train, date).
+ *
+ * buy_ticket and refund_ticket read and update the seats of a single date, so they go through the cache instead of
+ * copying and rewriting the whole train record. Updated rows are only written back to the train records when they are
+ * evicted or at a checkpoint. At most `capacity` rows are held, and the least recently used one is evicted first.
+ *
+ * Queries only look rows up without admitting them, so a scan over many trains does not flush the hot rows out.
+ *
+ * An admission may read and write train records while holding the cache latch, so it must not be called while holding
+ * a guard of a train record.
+ */
+class SeatCache {
+ public:
+  SeatCache(RecordFile<Train, TRAIN_PAGE_SIZE> *trains, size_t capacity);
+
+  ~SeatCache();
+
+  // Look up the cached seats of a train on a date without admitting them, return false on a miss
+  auto Find(int train_id, int date, Seats *seats) -> bool;
+
+  // Return the seats of a train on a date, admitting them on a miss
+  auto Get(int train_id, int date) -> Seats;
+
+  // Update the seats of a train on a date. They are written back to the train record later
+  void Put(int train_id, int date, const Seats &seats);
+
+  // Write back every dirty row
+  void FlushAll();
+
+  // Drop every row without writing it back
+  void Clear();
+
+ private:
+  struct Entry {
+    Seats seats_;
+    bool dirty_{false};
+    list<size_t>::iterator lru_pos_;
+  };
+
+  static auto Key(int train_id, int date) -> size_t { return static_cast<size_t>(train_id) * 92 + date; }
+
+  auto Admit(size_t key) -> Entry &;
+  void WriteBack(size_t key, const Entry &entry);
+
+  RecordFile<Train, TRAIN_PAGE_SIZE> *trains_;
+  const size_t capacity_;
+  map<size_t, Entry> entries_;
+  list<size_t> lru_;  // least recently used first
+  std::mutex latch_;
+};
+
+}
+
+#endif //SEAT_CACHE_H
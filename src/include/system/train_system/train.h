@@ -1,6 +1,7 @@
 #ifndef TRAIN_H
 #define TRAIN_H
 
+#include "b_plus_tree/normalized_key.h"
 #include "my_stl/array.hpp"
 
 namespace sjtu {
@@ -32,6 +33,17 @@ struct TrainComparator {
     }
     return 0;
   }
+  // train ids are stored as their bytes, see KeyNormalizer
+  static auto Normalize(const array<char, 20> &x) -> NormalizedBytes<20> {
+    NormalizedBytes<20> res;
+    EncodeChars(x, res.bytes_);
+    return res;
+  }
+  static auto Denormalize(const NormalizedBytes<20> &x) -> array<char, 20> {
+    array<char, 20> res;
+    DecodeChars(x.bytes_, &res);
+    return res;
+  }
 };
 
 struct StationComparator {
@@ -46,6 +58,21 @@ struct StationComparator {
     }
     return 0;
   }
+  // station names are stored as big-endian words, see KeyNormalizer
+  static auto Normalize(const array<unsigned int, 10> &x) -> NormalizedBytes<40> {
+    NormalizedBytes<40> res;
+    for (int i = 0; i < 10; ++i) {
+      EncodeUnsigned(x[i], res.bytes_ + 4 * i);
+    }
+    return res;
+  }
+  static auto Denormalize(const NormalizedBytes<40> &x) -> array<unsigned int, 10> {
+    array<unsigned int, 10> res;
+    for (int i = 0; i < 10; ++i) {
+      res[i] = DecodeUnsigned(x.bytes_ + 4 * i);
+    }
+    return res;
+  }
 };
 
 struct StationTrain {
@@ -69,6 +96,13 @@ struct StationTrainComparator {
     }
     return 0;
   }
+  // both ids are packed into one integer, see KeyNormalizer
+  static auto Normalize(const StationTrain &x) -> uint64_t {
+    return BiasInt(x.station_id_) << 32 | BiasInt(x.train_id_);
+  }
+  static auto Denormalize(const uint64_t &x) -> StationTrain {
+    return {UnbiasInt(x >> 32), UnbiasInt(x)};
+  }
 };
 
 struct StationIDComparator {
@@ -81,6 +115,10 @@ struct StationIDComparator {
     }
     return 0;
   }
+  // trains of a station are appended in the order of their ids, see BPlusTree::FindLeafByHint
+  auto Hash(const StationTrain &x) const -> unsigned {
+    return static_cast<unsigned>(x.station_id_);
+  }
 };
 
 struct TrainStation {
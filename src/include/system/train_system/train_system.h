@@ -3,36 +3,51 @@
 
 #include "system/train_system/train.h"
 #include "b_plus_tree/b_plus_tree.h"
-#include "memory_river/memory_river.hpp"
+#include "hash/extendible_hash_table.h"
+#include "record_file/record_file.hpp"
+#include "system/train_system/seat_cache.h"
 
 namespace sjtu {
 
 class TrainSystem {
 public:
   auto TrainID(const array<char, 20> &train) -> int;
+  auto FindTrainID(const array<char, 20> &train) -> int;
   auto StationID(array<unsigned int, 10> &station, bool add_new) -> int;
   auto StationName(const int &id) -> array<unsigned int, 10>;
   auto AddTrain(Train &train) -> bool;
   void DeleteTrain(const array<char, 20> &trainID);
   void ReleaseTrain(Train &train);
   auto QueryTrain(const int &train_id) -> Train;
+  auto ReadTrain(const int &train_id) -> RecordGuard<Train>;
   auto QueryTrain(const array<char, 20> &trainID) -> Train;
-  void UpdateTrain(const int &train_id, Train &new_train);
+  auto QuerySeats(const int &train_id, const int &date) -> Seats;
+  auto QuerySeats(const int &train_id, const int &date, const Train &train) -> Seats;
+  void UpdateSeats(const int &train_id, const int &date, const Seats &seats);
   void QueryStationInfo(const int &id, vector<TrainStation> *info);
   void Clean();
+  void PrepareCheckpoint(size_t epoch, vector<std::string> *files);
+  void ApplyCheckpoint();
+  auto CreateSnapshot(const std::string &name) -> bool;
+  auto SwitchSnapshot(const std::string &name) -> bool;
+  auto DropSnapshot(const std::string &name) -> bool;
+  void CollectStats(vector<FileStats> *stats);
   TrainSystem() = delete;
-  explicit TrainSystem(const std::string &name) : train_id_(name + "_train_id"), trains_(name + "_trains"),
-    station_id_(name + "_station_id"), station_info_(name + "_station_info"), station_name_(name + "_station_name") {
-    station_name_.Initialise();
-    trains_.Initialise();
-  }
+  // the trains of a station are scanned, so its tree uses a scan-resistant policy, the rest serve point lookups
+  explicit TrainSystem(const std::string &name) : train_id_(name + "_train_id", ReplacerType::CLOCK),
+    trains_(name + "_trains", ReplacerType::CLOCK), station_id_(name + "_station_id", ReplacerType::CLOCK),
+    station_info_(name + "_station_info", ReplacerType::TWO_Q),
+    station_name_(name + "_station_name", ReplacerType::CLOCK), seat_cache_(&trains_, SEAT_CACHE_SIZE) {}
 
 private:
-  BPlusTree<array<char, 20>, int, TrainComparator, TrainComparator> train_id_;
-  BPlusTree<array<unsigned int, 10>, int, StationComparator, StationComparator> station_id_;
-  MemoryRiver<array<unsigned int, 10>> station_name_;
-  MemoryRiver<Train> trains_;
+  // trains and stations are only looked up by name, so they are indexed by hash tables
+  ExtendibleHashTable<array<char, 20>, int, TrainComparator> train_id_;
+  ExtendibleHashTable<array<unsigned int, 10>, int, StationComparator> station_id_;
+  RecordFile<array<unsigned int, 10>> station_name_;
+  RecordFile<Train, TRAIN_PAGE_SIZE> trains_;
   BPlusTree<StationTrain, TrainStation, StationTrainComparator, StationIDComparator> station_info_;
+  // declared after trains_, so that it is destroyed and written back first
+  SeatCache seat_cache_;
 };
 
 }
@@ -1,6 +1,7 @@
 #ifndef USER_H
 #define USER_H
 
+#include "b_plus_tree/normalized_key.h"
 #include "my_stl/array.hpp"
 
 namespace sjtu {
@@ -26,6 +27,17 @@ struct UserComparator {
     }
     return 0;
   }
+  // names are stored as their bytes, see KeyNormalizer
+  static auto Normalize(const array<char, 20> &x) -> NormalizedBytes<20> {
+    NormalizedBytes<20> res;
+    EncodeChars(x, res.bytes_);
+    return res;
+  }
+  static auto Denormalize(const NormalizedBytes<20> &x) -> array<char, 20> {
+    array<char, 20> res;
+    DecodeChars(x.bytes_, &res);
+    return res;
+  }
 };
 
 }
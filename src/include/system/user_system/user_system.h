@@ -2,21 +2,33 @@
 #define USER_SYSTEM_H
 
 #include "system/user_system/user.h"
-#include "b_plus_tree/b_plus_tree.h"
+#include "hash/extendible_hash_table.h"
+#include "heap_file/heap_file.h"
 
 namespace sjtu {
 
+// Users are stored in a heap file, and their record ids are indexed by a hash table on the username.
 class UserSystem {
 public:
   auto AddUser(const User &user) -> bool;
   auto QueryUser(const array<char, 20> &username) -> User;
   void RemoveUser(const array<char, 20> &username);
+  void UpdateUser(const User &user);
   auto IsEmpty() -> bool;
   void Clean();
+  void PrepareCheckpoint(size_t epoch, vector<std::string> *files);
+  void ApplyCheckpoint();
+  auto CreateSnapshot(const std::string &name) -> bool;
+  auto SwitchSnapshot(const std::string &name) -> bool;
+  auto DropSnapshot(const std::string &name) -> bool;
+  void CollectStats(vector<FileStats> *stats);
   UserSystem() = delete;
-  explicit UserSystem(const std::string &name) : users_(name) {}
+  // users are looked up at random, so the pools use the cheapest policy
+  explicit UserSystem(const std::string &name) : users_(name, ReplacerType::CLOCK),
+    user_records_(name + "_records", ReplacerType::CLOCK) {}
 private:
-  BPlusTree<array<char, 20>, User, UserComparator, UserComparator> users_;
+  ExtendibleHashTable<array<char, 20>, Rid, UserComparator> users_;
+  HeapFile user_records_;
 };
 
 }
@@ -1,12 +1,19 @@
+#include <cstring>
 #include "system/user_system/user.h"
 #include "system/output.hpp"
 #include "system/system.h"
 
-int main() {
+int main(int argc, char **argv) {
   std::ios::sync_with_stdio(false);
   std::cin.tie(nullptr);
   std::cout.tie(nullptr);
+  size_t worker_cnt = 0; // `-j N` runs commands with N worker threads
+  for (int i = 1; i + 1 < argc; ++i) {
+    if (strcmp(argv[i], "-j") == 0) {
+      worker_cnt = std::stoul(argv[i + 1]);
+    }
+  }
   sjtu::System system("sword");
-  system.Run();
+  system.Run(worker_cnt);
   return 0;
-}
\ No newline at end of file
+}
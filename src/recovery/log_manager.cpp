@@ -0,0 +1,226 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+#include "buffer/disk_manager.h"
+#include "config.h"
+#include "recovery/log_manager.h"
+
+namespace sjtu {
+
+static const std::string kCheckpointTag = "#checkpoint ";
+static const std::string kFileTag = "#file ";
+static const std::string kSessionTag = "#session ";
+
+static auto StartsWith(const std::string &str, const std::string &prefix) -> bool {
+  return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+static void WriteAll(int fd, const char *data, size_t len) {
+  while (len > 0) {
+    auto res = write(fd, data, len);
+    if (res <= 0) {
+      throw std::exception();
+    }
+    data += res;
+    len -= res;
+  }
+}
+
+// make a rename in the directory of `file` durable
+static void SyncDirectory(const std::string &file) {
+  auto dir = std::filesystem::path(file).parent_path();
+  int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+  if (fd == -1) {
+    throw std::exception();
+  }
+  fsync(fd);
+  close(fd);
+}
+
+LogManager::LogManager(std::string log_file) : log_file_(std::move(log_file)) {
+  log_fd_ = open(log_file_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (log_fd_ == -1) {
+    throw std::exception();
+  }
+  std::string content;
+  char buf[BUSTUB_PAGE_SIZE];
+  while (true) {
+    auto res = read(log_fd_, buf, BUSTUB_PAGE_SIZE);
+    if (res < 0) {
+      throw std::exception();
+    }
+    if (res == 0) {
+      break;
+    }
+    content.append(buf, res);
+  }
+  // the last record may be torn by a crash. it was never durable, so it is dropped
+  size_t end = content.rfind('\n');
+  end = end == std::string::npos ? 0 : end + 1;
+  if (end != content.size()) {
+    content.resize(end);
+    if (ftruncate(log_fd_, end) != 0 || fdatasync(log_fd_) != 0) {
+      throw std::exception();
+    }
+  }
+  vector<std::string> files;
+  size_t pos = 0;
+  while (pos < content.size()) {
+    size_t next = content.find('\n', pos);
+    std::string line = content.substr(pos, next - pos);
+    pos = next + 1;
+    if (StartsWith(line, kCheckpointTag)) {
+      epoch_ = std::stoull(line.substr(kCheckpointTag.size()));
+    } else if (StartsWith(line, kFileTag)) {
+      files.push_back(line.substr(kFileTag.size()));
+    } else if (StartsWith(line, kSessionTag)) {
+      sessions_.push_back(line.substr(kSessionTag.size()));
+    } else {
+      records_.push_back(line);
+    }
+  }
+  // the checkpoint is committed, but some of its pages may still wait in the pending files
+  size_t file_cnt = files.size();
+  for (size_t i = 0; i < file_cnt; ++i) {
+    DiskManager::Recover(files[i], epoch_);
+  }
+  record_cnt_ = records_.size();
+  lseek(log_fd_, 0, SEEK_END);
+  flush_thread_ = std::thread(&LogManager::FlushLoop, this);
+}
+
+LogManager::~LogManager() {
+  {
+    std::scoped_lock latch(latch_);
+    stop_ = true;
+  }
+  flush_cv_.notify_one();
+  flush_thread_.join();
+  close(log_fd_);
+}
+
+auto LogManager::Append(const std::string &record) -> size_t {
+  std::scoped_lock latch(latch_);
+  buffer_ += record;
+  buffer_ += '\n';
+  ++record_cnt_;
+  if (++buffer_record_cnt_ >= LOG_FLUSH_RECORD_CNT) {
+    flush_cv_.notify_one();
+  }
+  return ++appended_lsn_;
+}
+
+void LogManager::Flush() {
+  std::unique_lock latch(latch_);
+  size_t lsn = appended_lsn_;
+  if (durable_lsn_ >= lsn) {
+    return;
+  }
+  flush_requested_ = true;
+  flush_cv_.notify_one();
+  durable_cv_.wait(latch, [this, lsn] { return durable_lsn_ >= lsn; });
+}
+
+auto LogManager::GetDurableLsn() -> size_t {
+  std::scoped_lock latch(latch_);
+  return durable_lsn_;
+}
+
+auto LogManager::GetAppendedLsn() -> size_t {
+  std::scoped_lock latch(latch_);
+  return appended_lsn_;
+}
+
+auto LogManager::GetRecordCnt() -> size_t {
+  std::scoped_lock latch(latch_);
+  return record_cnt_;
+}
+
+/**
+ * The new log is written to a temporary file first, and renamed over the old one once it is durable, so a crash leaves
+ * either the old log or the new one.
+ */
+void LogManager::Checkpoint(size_t epoch, const vector<std::string> &files, const vector<std::string> &sessions) {
+  std::string content = kCheckpointTag + std::to_string(epoch) + '\n';
+  size_t size = files.size();
+  for (size_t i = 0; i < size; ++i) {
+    content += kFileTag + files[i] + '\n';
+  }
+  size = sessions.size();
+  for (size_t i = 0; i < size; ++i) {
+    content += kSessionTag + sessions[i] + '\n';
+  }
+  std::string tmp_file = log_file_ + ".tmp";
+  int fd = open(tmp_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    throw std::exception();
+  }
+  WriteAll(fd, content.c_str(), content.size());
+  if (fsync(fd) != 0) {
+    throw std::exception();
+  }
+  std::scoped_lock io_latch(io_latch_);
+  if (std::rename(tmp_file.c_str(), log_file_.c_str()) != 0) {
+    throw std::exception();
+  }
+  SyncDirectory(log_file_);
+  close(log_fd_);
+  log_fd_ = fd;
+  std::scoped_lock latch(latch_);
+  epoch_ = epoch;
+  buffer_.clear();
+  buffer_record_cnt_ = 0;
+  record_cnt_ = 0;
+  durable_lsn_ = appended_lsn_;
+  durable_cv_.notify_all();
+}
+
+auto LogManager::GetEpoch() const -> size_t { return epoch_; }
+
+void LogManager::GetRecords(vector<std::string> *records) const { *records = records_; }
+
+void LogManager::GetSessions(vector<std::string> *sessions) const { *sessions = sessions_; }
+
+/**
+ * Group commit: every round writes all the records appended so far with a single sync.
+ */
+void LogManager::FlushLoop() {
+  std::unique_lock latch(latch_);
+  while (true) {
+    flush_cv_.wait_for(latch, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS), [this] {
+      return stop_ || flush_requested_ || buffer_record_cnt_ >= LOG_FLUSH_RECORD_CNT;
+    });
+    if (buffer_.empty()) {
+      flush_requested_ = false;
+      if (stop_) {
+        return;
+      }
+      continue;
+    }
+    latch.unlock();
+    {
+      std::scoped_lock io_latch(io_latch_);
+      latch.lock();
+      std::string data;
+      data.swap(buffer_);
+      size_t lsn = appended_lsn_;
+      buffer_record_cnt_ = 0;
+      flush_requested_ = false;
+      latch.unlock();
+      WriteAll(log_fd_, data.c_str(), data.size());
+      if (fdatasync(log_fd_) != 0) {
+        throw std::exception();
+      }
+      latch.lock();
+      if (lsn > durable_lsn_) {
+        durable_lsn_ = lsn;
+      }
+    }
+    durable_cv_.notify_all();
+  }
+}
+
+}
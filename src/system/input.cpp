@@ -1,34 +1,33 @@
 #include "system/input.h"
-#include <iostream>
 
 namespace sjtu {
 
 void Input::Skip() {
-  std::cin.get(las_c_);
+  is_->get(las_c_);
 }
 
 auto Input::GetTimestamp() -> int {
   assert(las_c_ == '\n');
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   assert(las_c_ == '[');
   int res = 0;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   while (las_c_ != ']') {
     res = res * 10 + las_c_ - '0';
-    std::cin.get(las_c_);
+    is_->get(las_c_);
   }
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   assert(las_c_ == ' ');
   return res;
 }
 
 auto Input::GetCommand() -> std::string {
   assert(las_c_ == ' ');
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   std::string res;
   while (las_c_ != ' ' && las_c_ != '\n') {
     res += las_c_;
-    std::cin.get(las_c_);
+    is_->get(las_c_);
   }
   return res;
 }
@@ -38,34 +37,34 @@ auto Input::GetKey() -> char {
     return '\n';
   }
   assert(las_c_ == ' ');
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   assert(las_c_ == '-');
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   char res = las_c_;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   assert(las_c_ == ' ');
   return res;
 }
 
 auto Input::GetChar() -> char {
   assert(las_c_ == ' ');
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   char res = las_c_;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   return res;
 }
 
 auto Input::GetInteger() -> int {
   assert(las_c_ == ' ' || las_c_ == '|');
   int res = 0;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   if (las_c_ == '_') {
     Skip();
     return -1;
   }
   while (las_c_ >= '0' && las_c_ <= '9') {
     res = res * 10 + las_c_ - '0';
-    std::cin.get(las_c_);
+    is_->get(las_c_);
   }
   return res;
 }
@@ -73,7 +72,7 @@ auto Input::GetInteger() -> int {
 auto Input::GetDate() -> int {
   Skip();
   int res = 0;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   if (las_c_ == '7') {
     res = 30;
   } else if (las_c_ == '8') {
@@ -82,9 +81,9 @@ auto Input::GetDate() -> int {
     res = 114514; // a impossible date
   }
   Skip();
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   res += 10 * (las_c_ - '0');
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   res += las_c_ - '1';
   Skip();
   return res;
@@ -92,16 +91,16 @@ auto Input::GetDate() -> int {
 
 auto Input::GetTime() -> int {
   int res = 0;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   res = (las_c_ - '0') * 600;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   res += (las_c_ - '0') * 60;
   Skip();
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   res += (las_c_ - '0') * 10;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   res += las_c_ - '0';
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   return res;
 }
 
@@ -110,39 +109,39 @@ auto Input::GetString() -> array<char, len> {
   assert(las_c_ == ' ');
   int pos = 0;
   array<char, len> res;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   while (las_c_ != ' ' && las_c_ != '\n') {
     res[pos++] = las_c_;
-    std::cin.get(las_c_);
+    is_->get(las_c_);
   }
   return res;
 }
 
 auto Input::GetSingleChinese() -> unsigned int {
   unsigned int res = 0;
-  std::cin.get(las_c_);
+  is_->get(las_c_);
   if ((las_c_ & 0x80) == 0) { // 0xxxxxxxx
     assert(las_c_ == ' ' || las_c_ == '\n' || las_c_ == '|');
     return 0;
   }
   if ((las_c_ & 0xE0) == 0xC0) { // 110xxxxx 10xxxxxxx
     res = (las_c_ & 0x1F) << 6;
-    assert(std::cin.get(las_c_));
+    assert(is_->get(las_c_));
     res |= (las_c_ & 0x3F);
   } else if ((las_c_ & 0xF0) == 0xE0) { // 1110xxxx 10xxxxxxx 10xxxxxx
     res = (las_c_ & 0x0F) << 12;
-    assert(std::cin.get(las_c_));
+    assert(is_->get(las_c_));
     res |= (las_c_ & 0x3F) << 6;
-    assert(std::cin.get(las_c_));
+    assert(is_->get(las_c_));
     res |= las_c_ & 0x3F;
   } else {
     assert((las_c_ & 0xF8) == 0xF0); // 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
     res = (las_c_ & 0x07) << 18;
-    assert(std::cin.get(las_c_));
+    assert(is_->get(las_c_));
     res |= (las_c_ & 0x3F) << 12;
-    assert(std::cin.get(las_c_));
+    assert(is_->get(las_c_));
     res |= (las_c_ & 0x3F) << 6;
-    assert(std::cin.get(las_c_));
+    assert(is_->get(las_c_));
     res |= las_c_ & 0x3F;
   }
   return res;
@@ -193,6 +192,7 @@ auto Input::GetChineseArray() -> array<array<unsigned int, len1>, len2> {
 }
 
 template auto Input::GetString<4>() -> array<char, 4>;
+template auto Input::GetString<16>() -> array<char, 16>;
 template auto Input::GetString<20>() -> array<char, 20>;
 template auto Input::GetString<30>() -> array<char, 30>;
 template auto Input::GetChinese<5>() -> array<unsigned int, 5>;
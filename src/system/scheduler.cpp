@@ -0,0 +1,142 @@
+#include "system/scheduler.h"
+
+namespace sjtu {
+
+static auto Compatible(LockMode x, LockMode y) -> bool {
+  return x == y && x != LockMode::kExclusive;
+}
+
+Scheduler::Scheduler(size_t worker_cnt, size_t window_size) : window_size_(window_size) {
+  for (size_t i = 0; i < worker_cnt; ++i) {
+    workers_.emplace_back(std::thread(&Scheduler::WorkerLoop, this));
+  }
+}
+
+Scheduler::~Scheduler() {
+  {
+    std::scoped_lock latch(latch_);
+    stop_ = true;
+  }
+  ready_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  while (!tasks_.empty()) {
+    delete tasks_.front();
+    tasks_.pop_front();
+  }
+}
+
+/**
+ * @brief Submit a task.
+ *
+ * The resources in `requests` must be distinct. The task is queued on each of them, and is runnable once it is
+ * granted all of them. Meanwhile, the output of the finished tasks at the front is flushed to `os`.
+ */
+void Scheduler::Submit(const vector<LockRequest> &requests, std::function<void(std::ostream &)> task,
+                       std::ostream &os) {
+  std::unique_lock latch(latch_);
+  FlushDone(os);
+  while (tasks_.size() >= window_size_) {
+    done_cv_.wait(latch);
+    FlushDone(os);
+  }
+  auto new_task = new Task;
+  new_task->func_ = std::move(task);
+  new_task->requests_ = requests;
+  size_t size = requests.size();
+  for (size_t i = 0; i < size; ++i) {
+    auto &waiters = lock_table_[requests[i].resource_];
+    bool granted = waiters.empty() || (waiters.back().granted_ && Compatible(waiters.back().mode_, requests[i].mode_));
+    waiters.push_back({new_task, requests[i].mode_, granted});
+    if (!granted) {
+      ++new_task->waiting_;
+    }
+  }
+  tasks_.push_back(new_task);
+  if (new_task->waiting_ == 0) {
+    ready_.push_back(new_task);
+    ready_cv_.notify_one();
+  }
+}
+
+void Scheduler::Drain(std::ostream &os) {
+  std::unique_lock latch(latch_);
+  while (true) {
+    FlushDone(os);
+    if (tasks_.empty()) {
+      return;
+    }
+    done_cv_.wait(latch);
+  }
+}
+
+void Scheduler::WorkerLoop() {
+  while (true) {
+    Task *task;
+    {
+      std::unique_lock latch(latch_);
+      ready_cv_.wait(latch, [this] { return stop_ || !ready_.empty(); });
+      if (ready_.empty()) {
+        return;
+      }
+      task = ready_.front();
+      ready_.pop_front();
+    }
+    task->func_(task->output_);
+    {
+      std::scoped_lock latch(latch_);
+      task->done_ = true;
+      Release(task);
+    }
+    done_cv_.notify_all();
+  }
+}
+
+void Scheduler::Grant(list<Waiter> *waiters) {
+  if (waiters->front().granted_) {
+    return;
+  }
+  auto mode = waiters->front().mode_;
+  bool first = true;
+  for (auto it = waiters->begin(); it != waiters->end(); ++it) {
+    if (!first && !Compatible(mode, it->mode_)) {
+      break;
+    }
+    first = false;
+    it->granted_ = true;
+    if (--it->task_->waiting_ == 0) {
+      ready_.push_back(it->task_);
+      ready_cv_.notify_one();
+    }
+  }
+}
+
+void Scheduler::Release(Task *task) {
+  size_t size = task->requests_.size();
+  for (size_t i = 0; i < size; ++i) {
+    auto table_it = lock_table_.find(task->requests_[i].resource_);
+    auto &waiters = table_it->second;
+    for (auto it = waiters.begin(); it != waiters.end(); ++it) {
+      if (it->task_ == task) {
+        waiters.erase(it);
+        break;
+      }
+    }
+    if (waiters.empty()) {
+      lock_table_.erase(table_it);
+    } else {
+      Grant(&waiters);
+    }
+  }
+}
+
+void Scheduler::FlushDone(std::ostream &os) {
+  while (!tasks_.empty() && tasks_.front()->done_) {
+    os << tasks_.front()->output_.str();
+    delete tasks_.front();
+    tasks_.pop_front();
+  }
+}
+
+}
@@ -1,77 +1,452 @@
 #include "system/system.h"
 #include "system/output.hpp"
 #include "config.h"
+#include <chrono>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
 
 namespace sjtu {
 
-System::System(const std::string &name) : user_system_(name + "_user"),
+template<int len>
+static auto ToArray(const std::string &str) -> array<char, len> {
+  array<char, len> res;
+  int size = str.size();
+  for (int i = 0; i < size && i < len; ++i) {
+    res[i] = str[i];
+  }
+  return res;
+}
+
+/**
+ * The log is opened first, which finishes the last checkpoint. The data files then hold the state of the checkpoint,
+ * and the logged commands are executed again to restore the state before a crash.
+ */
+System::System(const std::string &name) : log_manager_(name + "_log"),
+                                          epoch_(log_manager_.GetEpoch()),
+                                          user_system_(name + "_user"),
                                           train_system_(name + "_train"),
-                                          ticket_system_(name + "_ticket") {}
+                                          ticket_system_(name + "_ticket") {
+  vector<std::string> sessions;
+  log_manager_.GetSessions(&sessions);
+  size_t size = sessions.size();
+  for (size_t i = 0; i < size; ++i) {
+    auto username = ToArray<20>(sessions[i]);
+    online_users_[username] = user_system_.QueryUser(username);
+  }
+  vector<std::string> records;
+  log_manager_.GetRecords(&records);
+  size = records.size();
+  std::ostream null_os(nullptr);
+  for (size_t i = 0; i < size; ++i) {
+    std::istringstream is(records[i] + '\n');
+    Input input(is);
+    int timestamp = input.GetTimestamp();
+    Execute(timestamp, input.GetCommand(), input, null_os);
+  }
+  if (size > 0) {
+    Checkpoint();
+  }
+}
+
+// Shutting down is like exit: every user is logged out, and the state is checkpointed so nothing is left to redo
+System::~System() {
+  online_users_.clear();
+  Checkpoint();
+  ReleaseOutput(true);
+}
 
-void System::PrintTimestamp() const {
-  std::cout << "[" << timestamp_ << "] ";
+/**
+ * Run commands until exit.
+ *
+ * In the sequential mode commands are read and executed one by one. Otherwise see `RunParallel`.
+ *
+ * The commands that change the state are logged before they run. Their output, and the output of every later command,
+ * is held until the log is durable, so nothing is printed that a crash could undo.
+ */
+void System::Run(size_t worker_cnt) {
+  if (worker_cnt > 0) {
+    RunParallel(worker_cnt);
+  } else {
+    std::string line;
+    while (true) {
+      // do not keep the output waiting for more input
+      ReleaseOutput(std::cin.rdbuf()->in_avail() <= 0);
+      if (!std::getline(std::cin, line)) {
+        break;
+      }
+      line += '\n';
+      bool running = RunCommand(line, output_);
+      SealOutput();
+      if (!running) {
+        break;
+      }
+    }
+  }
+  ReleaseOutput(true);
 }
 
-void System::Run() {
+auto System::RunCommand(const std::string &line, std::ostream &os) -> bool {
+  LogCommand(line);
+  std::istringstream is(line);
+  Input input(is);
+  int timestamp = input.GetTimestamp();
+  if (!Execute(timestamp, input.GetCommand(), input, os)) {
+    return false;
+  }
+  if (log_manager_.GetRecordCnt() >= CHECKPOINT_RECORD_CNT) {
+    Checkpoint();
+  }
+  return true;
+}
+
+void System::CollectStats(vector<FileStats> *stats) {
+  user_system_.CollectStats(stats);
+  train_system_.CollectStats(stats);
+  ticket_system_.CollectStats(stats);
+}
+
+// The commands in the order of `command_stats_`
+static const char *kCommands[] = {"add_user", "login", "logout", "query_profile", "modify_profile", "add_train",
+                                  "delete_train", "release_train", "query_train", "query_ticket", "query_transfer",
+                                  "buy_ticket", "query_order", "refund_ticket", "clean", "create_snapshot",
+                                  "switch_snapshot", "drop_snapshot", "stats", "exit"};
+
+static auto CommandIndex(const std::string &command) -> int {
+  int index = 0;
+  while (index + 1 < static_cast<int>(std::size(kCommands)) && command != kCommands[index]) {
+    ++index;
+  }
+  return index;
+}
+
+auto System::Execute(int timestamp, const std::string &command, Input &input, std::ostream &os) -> bool {
+  auto start = std::chrono::steady_clock::now();
+  bool running = Dispatch(timestamp, command, input, os);
+  auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  auto &stats = command_stats_[CommandIndex(command)];
+  stats.cnt_.fetch_add(1, std::memory_order_relaxed);
+  stats.nanos_.fetch_add(nanos, std::memory_order_relaxed);
+  return running;
+}
+
+auto System::Dispatch(int timestamp, const std::string &command, Input &input, std::ostream &os) -> bool {
+  os << "[" << timestamp << "] ";
+  if (command == "add_user") {
+    AddUser(input, os);
+  } else if (command == "login") {
+    Login(input, os);
+  } else if (command == "logout") {
+    Logout(input, os);
+  } else if (command == "query_profile") {
+    QueryProfile(input, os);
+  } else if (command == "modify_profile") {
+    ModifyProfile(input, os);
+  } else if (command == "add_train") {
+    AddTrain(input, os);
+  } else if (command == "delete_train") {
+    DeleteTrain(input, os);
+  } else if (command == "release_train") {
+    ReleaseTrain(input, os);
+  } else if (command == "query_train") {
+    QueryTrain(input, os);
+  } else if (command == "query_ticket") {
+    QueryTicket(input, os);
+  } else if (command == "query_transfer") {
+    QueryTransfer(input, os);
+  } else if (command == "buy_ticket") {
+    BuyTicket(timestamp, input, os);
+  } else if (command == "query_order") {
+    QueryOrder(input, os);
+  } else if (command == "refund_ticket") {
+    RefundTicket(input, os);
+  } else if (command == "clean") {
+    Clean(os);
+  } else if (command == "create_snapshot") {
+    CreateSnapshot(input, os);
+  } else if (command == "switch_snapshot") {
+    SwitchSnapshot(input, os);
+  } else if (command == "drop_snapshot") {
+    DropSnapshot(input, os);
+  } else if (command == "stats") {
+    Stats(os);
+  } else {
+    assert(command == "exit");
+    {
+      std::unique_lock latch(online_latch_);
+      online_users_.clear();
+    }
+    Checkpoint();
+    os << "bye\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Run commands with a pool of worker threads.
+ *
+ * Commands are read ahead line by line. Each command is submitted to the scheduler together with the locks of the
+ * data it touches (see `LockRequests`), so conflicting commands run in timestamp order and the others in parallel.
+ * Commands that change the train catalog, refund_ticket (which may complete any pending order of the same train),
+ * clean and exit are barriers: they wait for every previous command and run on this thread.
+ */
+void System::RunParallel(size_t worker_cnt) {
+  Scheduler scheduler(worker_cnt);
+  bool users_empty = user_system_.IsEmpty();
+  std::string line;
   while (true) {
-    timestamp_ = input_.GetTimestamp();
-    PrintTimestamp();
-    auto command = input_.GetCommand();
-    if (command == "add_user") {
-      AddUser();
-    } else if (command == "login") {
-      Login();
-    } else if (command == "logout") {
-      Logout();
-    } else if (command == "query_profile") {
-      QueryProfile();
-    } else if (command == "modify_profile") {
-      ModifyProfile();
-    } else if (command == "add_train") {
-      AddTrain();
-    } else if (command == "delete_train") {
-      DeleteTrain();
-    } else if (command == "release_train") {
-      ReleaseTrain();
-    } else if (command == "query_train") {
-      QueryTrain();
-    } else if (command == "query_ticket") {
-      QueryTicket();
-    } else if (command == "query_transfer") {
-      QueryTransfer();
-    } else if (command == "buy_ticket") {
-      BuyTicket();
-    } else if (command == "query_order") {
-      QueryOrder();
-    } else if (command == "refund_ticket") {
-      RefundTicket();
-    } else if (command == "clean") {
-      Clean();
-    } else {
-      assert(command == "exit");
-      std::cout << "bye\n";
+    ReleaseOutput(std::cin.rdbuf()->in_avail() <= 0);
+    if (!std::getline(std::cin, line)) {
       break;
     }
+    line += '\n';
+    if (log_manager_.GetRecordCnt() >= CHECKPOINT_RECORD_CNT) {
+      scheduler.Drain(output_);
+      Checkpoint();
+    }
+    LogCommand(line);
+    vector<LockRequest> requests;
+    if (LockRequests(line, users_empty, &requests)) {
+      scheduler.Submit(requests, [this, line](std::ostream &os) {
+        std::istringstream is(line);
+        Input input(is);
+        int timestamp = input.GetTimestamp();
+        Execute(timestamp, input.GetCommand(), input, os);
+      }, output_);
+      SealOutput();
+      continue;
+    }
+    scheduler.Drain(output_);
+    std::istringstream is(line);
+    Input input(is);
+    int timestamp = input.GetTimestamp();
+    bool running = Execute(timestamp, input.GetCommand(), input, output_);
+    SealOutput();
+    users_empty = user_system_.IsEmpty();
+    if (!running) {
+      return;
+    }
+  }
+  scheduler.Drain(output_);
+  SealOutput();
+}
+
+static auto IsLogged(const std::string &command) -> bool {
+  return command == "add_user" || command == "login" || command == "logout" || command == "modify_profile" ||
+         command == "add_train" || command == "delete_train" || command == "release_train" ||
+         command == "buy_ticket" || command == "refund_ticket" || command == "clean" ||
+         command == "create_snapshot" || command == "switch_snapshot" || command == "drop_snapshot";
+}
+
+void System::LogCommand(const std::string &line) {
+  size_t pos = line.find(' ') + 1;
+  if (IsLogged(line.substr(pos, line.find_first_of(" \n", pos) - pos))) {
+    log_manager_.Append(line.substr(0, line.size() - 1));
+  }
+}
+
+/**
+ * @brief Take a checkpoint. No command may be running.
+ *
+ * Every subsystem first prepares its dirty pages in the pending files, then the checkpoint is committed by the log, and
+ * at last the pending pages are applied to the data files. A crash before the commit keeps the last checkpoint, and a
+ * crash after it applies the pending pages again at the next start.
+ */
+void System::Checkpoint() {
+  ++epoch_;
+  vector<std::string> files;
+  user_system_.PrepareCheckpoint(epoch_, &files);
+  train_system_.PrepareCheckpoint(epoch_, &files);
+  ticket_system_.PrepareCheckpoint(epoch_, &files);
+  vector<std::string> sessions;
+  for (auto it = online_users_.begin(); it != online_users_.end(); ++it) {
+    sessions.push_back(ArrayToString<20>(it->first));
   }
+  log_manager_.Checkpoint(epoch_, files, sessions);
+  user_system_.ApplyCheckpoint();
+  train_system_.ApplyCheckpoint();
+  ticket_system_.ApplyCheckpoint();
 }
 
-void System::AddUser() {
+void System::SealOutput() {
+  auto text = output_.str();
+  if (text.empty()) {
+    return;
+  }
+  output_.str("");
+  size_t lsn = log_manager_.GetAppendedLsn();
+  if (!held_output_.empty() && held_output_.back().lsn_ == lsn) {
+    auto it = held_output_.end();
+    (--it)->text_ += text;
+  } else {
+    held_output_.push_back({lsn, std::move(text)});
+  }
+}
+
+void System::ReleaseOutput(bool wait) {
+  if (held_output_.empty()) {
+    return;
+  }
+  if (wait) {
+    log_manager_.Flush();
+  }
+  size_t lsn = log_manager_.GetDurableLsn();
+  while (!held_output_.empty() && held_output_.front().lsn_ <= lsn) {
+    std::cout << held_output_.front().text_;
+    held_output_.pop_front();
+  }
+  if (wait) {
+    std::cout.flush();
+  }
+}
+
+static constexpr size_t kUserStripeCnt = 1024;
+static constexpr size_t kSeatStripeCnt = 4096;
+
+// the single resources, followed by the user stripes and the (train, date) stripes
+static constexpr size_t kAllSeats = 0;
+static constexpr size_t kAllUsers = 1;
+static constexpr size_t kUserStripeBegin = 2;
+static constexpr size_t kSeatStripeBegin = kUserStripeBegin + kUserStripeCnt;
+
+static void AddLockRequest(vector<LockRequest> *requests, size_t resource, LockMode mode) {
+  size_t size = requests->size();
+  for (size_t i = 0; i < size; ++i) {
+    if ((*requests)[i].resource_ == resource) {  // two keys in the same stripe
+      if ((*requests)[i].mode_ != mode) {
+        (*requests)[i].mode_ = LockMode::kExclusive;
+      }
+      return;
+    }
+  }
+  requests->push_back({resource, mode});
+}
+
+static auto UserStripe(const std::string &username) -> size_t {
+  return kUserStripeBegin + std::hash<std::string>()(username) % kUserStripeCnt;
+}
+
+static auto SeatStripe(int train_id, int date) -> size_t {
+  return kSeatStripeBegin + (static_cast<size_t>(train_id) * 92 + date) % kSeatStripeCnt;
+}
+
+/**
+ * @brief Decide the locks a command needs.
+ *
+ * Users are locked by stripes of their username, covering their profile, their session and their orders. Seats are
+ * locked by stripes of (train, start date) under the kAllSeats resource, which query_ticket and query_transfer lock in
+ * shared mode since they read the seats of many trains. Adding users is shared on kAllUsers while modify_profile, which
+ * removes and re-inserts a user, holds it in intention mode, so add_user never sees a transiently smaller user table.
+ *
+ * @param line the command line
+ * @param users_empty whether there is no user, in which case add_user is a barrier
+ * @param[out] requests the locks needed by the command
+ * @return false if the command is a barrier
+ */
+auto System::LockRequests(const std::string &line, bool users_empty, vector<LockRequest> *requests) -> bool {
+  size_t pos = line.find(' ') + 1;
+  size_t nxt = line.find_first_of(" \n", pos);
+  std::string command = line.substr(pos, nxt - pos);
+  array<std::string, 26> args;
+  while (line[nxt] == ' ') {
+    char key = line[nxt + 2];
+    pos = nxt + 4;
+    nxt = line.find_first_of(" \n", pos);
+    args[key - 'a'] = line.substr(pos, nxt - pos);
+  }
+  auto &username = args['u' - 'a'];
+  auto &cur_username = args['c' - 'a'];
+  if (command == "add_user" && !users_empty) {
+    AddLockRequest(requests, kAllUsers, LockMode::kShared);
+    AddLockRequest(requests, UserStripe(cur_username), LockMode::kShared);
+    AddLockRequest(requests, UserStripe(username), LockMode::kExclusive);
+  } else if (command == "login" || command == "logout") {
+    AddLockRequest(requests, UserStripe(username), LockMode::kExclusive);
+  } else if (command == "query_profile") {
+    AddLockRequest(requests, UserStripe(cur_username), LockMode::kShared);
+    AddLockRequest(requests, UserStripe(username), LockMode::kShared);
+  } else if (command == "modify_profile") {
+    AddLockRequest(requests, kAllUsers, LockMode::kIntention);
+    AddLockRequest(requests, UserStripe(cur_username), LockMode::kShared);
+    AddLockRequest(requests, UserStripe(username), LockMode::kExclusive);
+  } else if (command == "query_order") {
+    AddLockRequest(requests, UserStripe(username), LockMode::kShared);
+  } else if (command == "query_ticket" || command == "query_transfer") {
+    AddLockRequest(requests, kAllSeats, LockMode::kShared);
+  } else if (command == "query_train") {
+    AddLockRequest(requests, kAllSeats, LockMode::kIntention);
+    int train_id = train_system_.FindTrainID(ToArray<20>(args['i' - 'a']));
+    if (train_id != -1) {
+      std::istringstream is(args['d' - 'a'] + '\n');
+      AddLockRequest(requests, SeatStripe(train_id, Input(is, ' ').GetDate()), LockMode::kShared);
+    }
+  } else if (command == "buy_ticket") {
+    AddLockRequest(requests, UserStripe(username), LockMode::kExclusive);
+    AddLockRequest(requests, kAllSeats, LockMode::kIntention);
+    // the train catalog only changes in barriers, so the start date can be resolved in advance like BuyTicket does
+    int train_id = train_system_.FindTrainID(ToArray<20>(args['i' - 'a']));
+    if (train_id == -1) {
+      return true;
+    }
+    std::istringstream station_is(args['f' - 'a'] + '\n');
+    auto station = Input(station_is, ' ').GetChinese<10>();
+    int start_station = train_system_.StationID(station, false);
+    auto guard = train_system_.ReadTrain(train_id);
+    const Train &train = *guard;
+    int start_pos = -1;
+    for (int i = 0; i < train.stationNum_; ++i) {
+      if (train.stations_[i] == start_station) {
+        start_pos = i;
+      }
+    }
+    if (start_pos == -1) {
+      return true;
+    }
+    int start_total_time = train.arrivingTimes_[start_pos];
+    if (start_pos > 0) {
+      start_total_time += train.stopoverTimes_[start_pos - 1];
+    }
+    std::istringstream date_is(args['d' - 'a'] + '\n');
+    int start_date = Input(date_is, ' ').GetDate() - start_total_time / 1440;
+    if (start_date >= train.saleDate_start_ && start_date <= train.saleDate_end_) {
+      AddLockRequest(requests, SeatStripe(train_id, start_date), LockMode::kExclusive);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+auto System::FindOnlineUser(const array<char, 20> &username, User *user) -> bool {
+  std::shared_lock latch(online_latch_);
+  auto it = online_users_.find(username);
+  if (it == online_users_.end()) {
+    return false;
+  }
+  if (user != nullptr) {
+    *user = it->second;
+  }
+  return true;
+}
+
+void System::AddUser(Input &input, std::ostream &os) {
   array<char, 20> cur_username;
   User user;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 'c') {
-      cur_username = input_.GetString<20>();
+      cur_username = input.GetString<20>();
     } else if (key == 'u') {
-      user.username_ = input_.GetString<20>();
+      user.username_ = input.GetString<20>();
     } else if (key == 'p') {
-      user.password_ = input_.GetString<30>();
+      user.password_ = input.GetString<30>();
     } else if (key == 'n') {
-      user.name_ = input_.GetChinese<5>();
+      user.name_ = input.GetChinese<5>();
     } else if (key == 'm') {
-      user.mailAddr_ = input_.GetString<30>();
+      user.mailAddr_ = input.GetString<30>();
     } else if (key == 'g') {
-      user.privilege_ = input_.GetInteger();
+      user.privilege_ = input.GetInteger();
     } else {
       assert(key == '\n');
       break;
@@ -80,117 +455,119 @@ void System::AddUser() {
   if (user_system_.IsEmpty()) {
     user.privilege_ = 10;
     user_system_.AddUser(user);
-    std::cout << "0\n";
+    os << "0\n";
   } else {
-    auto it = online_users_.find(cur_username);
-    if (it == online_users_.end() || it->second.privilege_ <= user.privilege_) {
-      std::cout << "-1\n";
+    User cur_user;
+    if (!FindOnlineUser(cur_username, &cur_user) || cur_user.privilege_ <= user.privilege_) {
+      os << "-1\n";
     } else if (user_system_.AddUser(user)) {
-      std::cout << "0\n";
+      os << "0\n";
     } else {
-      std::cout << "-1\n";
+      os << "-1\n";
     }
   }
 }
 
-void System::Login() {
+void System::Login(Input &input, std::ostream &os) {
   array<char, 20> username;
   array<char, 30> password;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 'u') {
-      username = input_.GetString<20>();
+      username = input.GetString<20>();
     } else if (key == 'p') {
-      password = input_.GetString<30>();
+      password = input.GetString<30>();
     } else {
       assert(key == '\n');
       break;
     }
   }
-  if (online_users_.find(username) != online_users_.end()) {
-    std::cout << "-1\n";
+  if (FindOnlineUser(username)) {
+    os << "-1\n";
   } else {
     auto user = user_system_.QueryUser(username);
     if (user.privilege_ > 10 || user.password_ != password) {
-      std::cout << "-1\n";
+      os << "-1\n";
     } else {
+      std::unique_lock latch(online_latch_);
       online_users_[username] = user;
-      std::cout << "0\n";
+      os << "0\n";
     }
   }
 }
 
-void System::Logout() {
-  assert(input_.GetKey() == 'u');
-  array<char, 20> username = input_.GetString<20>();
-  assert(input_.GetKey() == '\n');
+void System::Logout(Input &input, std::ostream &os) {
+  assert(input.GetKey() == 'u');
+  array<char, 20> username = input.GetString<20>();
+  assert(input.GetKey() == '\n');
+  std::unique_lock latch(online_latch_);
   auto it = online_users_.find(username);
   if (it == online_users_.end()) {
-    std::cout << "-1\n";
+    os << "-1\n";
   } else {
     online_users_.erase(it);
-    std::cout << "0\n";
+    os << "0\n";
   }
 }
 
-void System::QueryProfile() {
+void System::QueryProfile(Input &input, std::ostream &os) {
   array<char, 20> cur_username;
   array<char, 20> username;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 'c') {
-      cur_username = input_.GetString<20>();
+      cur_username = input.GetString<20>();
     } else if (key == 'u') {
-      username = input_.GetString<20>();
+      username = input.GetString<20>();
     } else {
       assert(key == '\n');
       break;
     }
   }
-  auto it = online_users_.find(cur_username);
-  if (it == online_users_.end()) {
-    std::cout << "-1\n";
+  User cur_user;
+  if (!FindOnlineUser(cur_username, &cur_user)) {
+    os << "-1\n";
   } else {
     auto user = user_system_.QueryUser(username);
-    if (it->second.privilege_ > user.privilege_ || cur_username == username) { // if not found, user.privilege == 11
-      std::cout << ArrayToString<20>(username) << " " << ChineseToString<5>(user.name_)
+    if (cur_user.privilege_ > user.privilege_ || cur_username == username) { // if not found, user.privilege == 11
+      os << ArrayToString<20>(username) << " " << ChineseToString<5>(user.name_)
          << " " << ArrayToString<30>(user.mailAddr_) << " " << static_cast<unsigned int>(user.privilege_) << '\n';
     } else {
-      std::cout << "-1\n";
+      os << "-1\n";
     }
   }
 }
 
-void System::ModifyProfile() {
+void System::ModifyProfile(Input &input, std::ostream &os) {
   array<char, 20> cur_username;
   User user;
 
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 'c') {
-      cur_username = input_.GetString<20>();
+      cur_username = input.GetString<20>();
     } else if (key == 'u') {
-      user.username_ = input_.GetString<20>();
+      user.username_ = input.GetString<20>();
     } else if (key == 'p') {
-      user.password_ = input_.GetString<30>();
+      user.password_ = input.GetString<30>();
     } else if (key == 'n') {
-      user.name_ = input_.GetChinese<5>();
+      user.name_ = input.GetChinese<5>();
     } else if (key == 'm') {
-      user.mailAddr_ = input_.GetString<30>();
+      user.mailAddr_ = input.GetString<30>();
     } else if (key == 'g') {
-      user.privilege_ = input_.GetInteger();
+      user.privilege_ = input.GetInteger();
     } else {
       assert(key == '\n');
       break;
     }
   }
-  auto it = online_users_.find(cur_username);
-  if (it == online_users_.end()) {
-    std::cout << "-1\n";
+  User cur_user;
+  if (!FindOnlineUser(cur_username, &cur_user)) {
+    os << "-1\n";
   } else {
     auto old_user = user_system_.QueryUser(user.username_);
-    if ((it->second.privilege_ > old_user.privilege_ || cur_username == user.username_)
-      && (user.privilege_ == 11 || user.privilege_ < it->second.privilege_)) {
+    if ((cur_user.privilege_ > old_user.privilege_ || cur_username == user.username_)
+      && (user.privilege_ == 11 || user.privilege_ < cur_user.privilege_)) {
       if (user.password_[0] == '\0') {
         user.password_ = old_user.password_;
       }
@@ -203,55 +580,57 @@ void System::ModifyProfile() {
       if (user.privilege_ == 11) {
         user.privilege_ = old_user.privilege_;
       }
-      user_system_.RemoveUser(user.username_);
-      user_system_.AddUser(user);
-      it = online_users_.find(user.username_);
-      if (it != online_users_.end()) {
-        it->second = user;
+      user_system_.UpdateUser(user);
+      {
+        std::unique_lock latch(online_latch_);
+        auto it = online_users_.find(user.username_);
+        if (it != online_users_.end()) {
+          it->second = user;
+        }
       }
-      std::cout << ArrayToString<20>(user.username_) << " " << ChineseToString<5>(user.name_)
+      os << ArrayToString<20>(user.username_) << " " << ChineseToString<5>(user.name_)
          << " " << ArrayToString<30>(user.mailAddr_) << " " << static_cast<unsigned int>(user.privilege_) << '\n';
     } else {
-      std::cout << "-1\n";
+      os << "-1\n";
     }
   }
 }
 
-void System::AddTrain() {
+void System::AddTrain(Input &input, std::ostream &os) {
   Train train;
   array<array<unsigned int, 10>, 24> stations;
   int startTime;
   array<int, 23> travelTimes;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 'i') {
-      train.trainID_ = input_.GetString<20>();
+      train.trainID_ = input.GetString<20>();
     } else if (key == 'n') {
-      train.stationNum_ = input_.GetInteger();
+      train.stationNum_ = input.GetInteger();
     } else if (key == 'm') {
-      train.max_seatNum_ = input_.GetInteger();
+      train.max_seatNum_ = input.GetInteger();
     } else if (key == 's') {
-      stations = input_.GetChineseArray<10, 24>();
+      stations = input.GetChineseArray<10, 24>();
     } else if (key == 'p') {
-      train.prices_ = input_.GetIntegerArray<23>();
+      train.prices_ = input.GetIntegerArray<23>();
     } else if (key == 'x') {
-      startTime = input_.GetTime();
+      startTime = input.GetTime();
     } else if (key == 't') {
-      travelTimes = input_.GetIntegerArray<23>();
+      travelTimes = input.GetIntegerArray<23>();
     } else if (key == 'o') {
-      train.stopoverTimes_ = input_.GetIntegerArray<22>();
+      train.stopoverTimes_ = input.GetIntegerArray<22>();
     } else if (key == 'd') {
-      train.saleDate_start_ = input_.GetDate();
-      train.saleDate_end_ = input_.GetDate();
+      train.saleDate_start_ = input.GetDate();
+      train.saleDate_end_ = input.GetDate();
     } else if (key == 'y') {
-      train.type_ = input_.GetChar();
+      train.type_ = input.GetChar();
     } else {
       assert(key == '\n');
       break;
     }
   }
   if (train_system_.QueryTrain(train.trainID_).trainID_[0] != '\0') {
-    std::cout << "-1\n";
+    os << "-1\n";
   } else {
     for (int i = train.saleDate_start_; i <= train.saleDate_end_; ++i) {
       for (int j = 0; j < train.stationNum_ - 1; ++j) {
@@ -269,45 +648,45 @@ void System::AddTrain() {
       }
     }
     train_system_.AddTrain(train);
-    std::cout << "0\n";
+    os << "0\n";
   }
 }
 
-void System::DeleteTrain() {
-  assert(input_.GetKey() == 'i');
-  array<char, 20> trainID = input_.GetString<20>();
-  assert(input_.GetKey() == '\n');
+void System::DeleteTrain(Input &input, std::ostream &os) {
+  assert(input.GetKey() == 'i');
+  array<char, 20> trainID = input.GetString<20>();
+  assert(input.GetKey() == '\n');
   auto train = train_system_.QueryTrain(trainID);
   if (train.trainID_[0] != '\0' && !train.is_released_) {
     train_system_.DeleteTrain(trainID);
-    std::cout << "0\n";
+    os << "0\n";
   } else {
-    std::cout << "-1\n";
+    os << "-1\n";
   }
 }
 
-void System::ReleaseTrain() {
-  assert(input_.GetKey() == 'i');
-  array<char, 20> trainID = input_.GetString<20>();
-  assert(input_.GetKey() == '\n');
+void System::ReleaseTrain(Input &input, std::ostream &os) {
+  assert(input.GetKey() == 'i');
+  array<char, 20> trainID = input.GetString<20>();
+  assert(input.GetKey() == '\n');
   auto train = train_system_.QueryTrain(trainID);
   if (train.trainID_[0] != '\0' && !train.is_released_) {
     train_system_.ReleaseTrain(train);
-    std::cout << "0\n";
+    os << "0\n";
   } else {
-    std::cout << "-1\n";
+    os << "-1\n";
   }
 }
 
-void System::QueryTrain() {
+void System::QueryTrain(Input &input, std::ostream &os) {
   array<char, 20> trainID;
   int date;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 'i') {
-      trainID = input_.GetString<20>();
+      trainID = input.GetString<20>();
     } else if (key == 'd') {
-      date = input_.GetDate();
+      date = input.GetDate();
     } else {
       assert(key == '\n');
       break;
@@ -316,51 +695,52 @@ void System::QueryTrain() {
   auto train = train_system_.QueryTrain(trainID);
   if (train.trainID_[0] != '\0' && train.saleDate_start_ <= date && date <= train.saleDate_end_) {
     int total_price = 0;
-    std::cout << ArrayToString<20>(train.trainID_) << ' ' << train.type_ << '\n';
+    auto seats = train_system_.QuerySeats(train_system_.TrainID(trainID), date, train);
+    os << ArrayToString<20>(train.trainID_) << ' ' << train.type_ << '\n';
     for (int i = 0; i < train.stationNum_; ++i) {
-      std::cout << ChineseToString<10>(train_system_.StationName(train.stations_[i])) << " ";
+      os << ChineseToString<10>(train_system_.StationName(train.stations_[i])) << " ";
       if (i == 0) {
-        std::cout << "xx-xx xx:xx";
+        os << "xx-xx xx:xx";
       } else {
-        PrintTime(date * 1440 + train.arrivingTimes_[i]);
+        PrintTime(os, date * 1440 + train.arrivingTimes_[i]);
       }
 
-      std::cout << " -> ";
+      os << " -> ";
 
       if (i + 1 == train.stationNum_) {
-        std::cout << "xx-xx xx:xx";
+        os << "xx-xx xx:xx";
       } else {
-        PrintTime(date * 1440 + train.arrivingTimes_[i] + (i == 0 ? 0 : train.stopoverTimes_[i - 1]));
+        PrintTime(os, date * 1440 + train.arrivingTimes_[i] + (i == 0 ? 0 : train.stopoverTimes_[i - 1]));
       }
 
-      std::cout << ' ' << total_price << ' ';
+      os << ' ' << total_price << ' ';
       if (i + 1 == train.stationNum_) {
-        std::cout << "x\n";
+        os << "x\n";
       } else {
         total_price += train.prices_[i];
-        std::cout << train.seatNum_[date][i] << '\n';
+        os << seats[i] << '\n';
       }
     }
   } else {
-    std::cout << "-1\n";
+    os << "-1\n";
   }
 }
 
-void System::QueryTicket() {
+void System::QueryTicket(Input &input, std::ostream &os) {
   array<unsigned int, 10> start;
   array<unsigned int, 10> end;
   array<char, 4> option;
   int date;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 's') {
-      start = input_.GetChinese<10>();
+      start = input.GetChinese<10>();
     } else if (key == 't') {
-      end = input_.GetChinese<10>();
+      end = input.GetChinese<10>();
     } else if (key == 'd') {
-      date = input_.GetDate();
+      date = input.GetDate();
     } else if (key == 'p') {
-      option = input_.GetString<4>();
+      option = input.GetString<4>();
     } else {
       assert(key == '\n');
       break;
@@ -369,12 +749,12 @@ void System::QueryTicket() {
 
   int start_station = train_system_.StationID(start, false);
   if (start_station == -1) {
-    std::cout << "0\n";
+    os << "0\n";
     return;
   }
   int end_station = train_system_.StationID(end, false);
   if (end_station == -1) {
-    std::cout << "0\n";
+    os << "0\n";
     return;
   }
 
@@ -399,7 +779,8 @@ void System::QueryTicket() {
       break;
     }
     if (end_trains[p].train_id_ == start_trains[i].train_id_) {
-      auto train = train_system_.QueryTrain(start_trains[i].train_id_);
+      auto guard = train_system_.ReadTrain(start_trains[i].train_id_);
+      const Train &train = *guard;
       int start_pos = start_trains[i].pos_;
       int end_pos = end_trains[p].pos_;
       if (start_pos < end_pos) {
@@ -409,11 +790,12 @@ void System::QueryTicket() {
         }
         int start_date = date - start_total_time / 1440;
         if (start_date >= train.saleDate_start_ && train.saleDate_end_ >= start_date) {
+          auto seats = train_system_.QuerySeats(start_trains[i].train_id_, start_date, train);
           int seat = MAX_SEAT_NUM;
           int total_price = 0;
           for (int j = start_pos; j < end_pos; ++j) {
-            if (seat > train.seatNum_[start_date][j]) {
-              seat = train.seatNum_[start_date][j];
+            if (seat > seats[j]) {
+              seat = seats[j];
             }
             total_price += train.prices_[j];
           }
@@ -430,27 +812,27 @@ void System::QueryTicket() {
   } else {
     tickets.sort(CostFirstComparator);
   }
-  std::cout << size << '\n';
+  os << size << '\n';
   for (size_t i = 0; i < size; ++i) {
-    tickets[i].Print(&train_system_);
+    tickets[i].Print(&train_system_, os);
   }
 }
 
-void System::QueryTransfer() {
+void System::QueryTransfer(Input &input, std::ostream &os) {
   array<unsigned int, 10> start;
   array<unsigned int, 10> end;
   array<char, 4> option;
   int date;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 's') {
-      start = input_.GetChinese<10>();
+      start = input.GetChinese<10>();
     } else if (key == 't') {
-      end = input_.GetChinese<10>();
+      end = input.GetChinese<10>();
     } else if (key == 'd') {
-      date = input_.GetDate();
+      date = input.GetDate();
     } else if (key == 'p') {
-      option = input_.GetString<4>();
+      option = input.GetString<4>();
     } else {
       assert(key == '\n');
       break;
@@ -459,12 +841,12 @@ void System::QueryTransfer() {
 
   int start_station = train_system_.StationID(start, false);
   if (start_station == -1) {
-    std::cout << "0\n";
+    os << "0\n";
     return;
   }
   int end_station = train_system_.StationID(end, false);
   if (end_station == -1) {
-    std::cout << "0\n";
+    os << "0\n";
     return;
   }
 
@@ -480,7 +862,8 @@ void System::QueryTransfer() {
 
   size_t size = start_trains.size();
   for (size_t i = 0; i < size; ++i) {
-    auto train = train_system_.QueryTrain(start_trains[i].train_id_);
+    auto guard = train_system_.ReadTrain(start_trains[i].train_id_);
+    const Train &train = *guard;
 
     for (int j = 0; j < train.stationNum_; ++j) {
       if (train.stations_[j] == start_station) {
@@ -493,11 +876,12 @@ void System::QueryTransfer() {
           break;
         }
         int start_time = start_total_time + start_date * 1440;
+        auto seats = train_system_.QuerySeats(start_trains[i].train_id_, start_date, train);
         int seat = MAX_SEAT_NUM;
         int total_price = 0;
         for (int k = j + 1; k < train.stationNum_; ++k) {
-          if (seat > train.seatNum_[start_date][k - 1]) {
-            seat = train.seatNum_[start_date][k - 1];
+          if (seat > seats[k - 1]) {
+            seat = seats[k - 1];
           }
           total_price += train.prices_[k - 1];
           int end_time = train.arrivingTimes_[k] + start_date * 1440;
@@ -534,10 +918,11 @@ void System::QueryTransfer() {
             if (next_start_date < train.saleDate_start_) {
               next_start_date = train.saleDate_start_;
             }
+            auto seats = train_system_.QuerySeats(end_trains[i].train_id_, next_start_date, train);
             int seat = MAX_SEAT_NUM;
             for (int l = k; l < j; ++l) {
-              if (seat > train.seatNum_[next_start_date][l]) {
-                seat = train.seatNum_[next_start_date][l];
+              if (seat > seats[l]) {
+                seat = seats[l];
               }
             }
             if (it->first.seat_ > 0 && seat > 0) {
@@ -559,10 +944,10 @@ void System::QueryTransfer() {
                         ticket = new_ticket;
                       }
                     } else {
-                      auto new_trainID_first = train_system_.QueryTrain(new_ticket.first_.train_id_).trainID_;
-                      auto new_trainID_second = train_system_.QueryTrain(new_ticket.second_.train_id_).trainID_;
-                      auto trainID_first = train_system_.QueryTrain(ticket.first_.train_id_).trainID_;
-                      auto trainID_second = train_system_.QueryTrain(ticket.second_.train_id_).trainID_;
+                      auto new_trainID_first = train_system_.ReadTrain(new_ticket.first_.train_id_)->trainID_;
+                      auto new_trainID_second = train_system_.ReadTrain(new_ticket.second_.train_id_)->trainID_;
+                      auto trainID_first = train_system_.ReadTrain(ticket.first_.train_id_)->trainID_;
+                      auto trainID_second = train_system_.ReadTrain(ticket.second_.train_id_)->trainID_;
                       if (new_trainID_first != trainID_first) {
                         if (new_trainID_first < trainID_first) {
                           ticket = new_ticket;
@@ -583,10 +968,10 @@ void System::QueryTransfer() {
                         ticket = new_ticket;
                       }
                     } else {
-                      auto new_trainID_first = train_system_.QueryTrain(new_ticket.first_.train_id_).trainID_;
-                      auto new_trainID_second = train_system_.QueryTrain(new_ticket.second_.train_id_).trainID_;
-                      auto trainID_first = train_system_.QueryTrain(ticket.first_.train_id_).trainID_;
-                      auto trainID_second = train_system_.QueryTrain(ticket.second_.train_id_).trainID_;
+                      auto new_trainID_first = train_system_.ReadTrain(new_ticket.first_.train_id_)->trainID_;
+                      auto new_trainID_second = train_system_.ReadTrain(new_ticket.second_.train_id_)->trainID_;
+                      auto trainID_first = train_system_.ReadTrain(ticket.first_.train_id_)->trainID_;
+                      auto trainID_second = train_system_.ReadTrain(ticket.second_.train_id_)->trainID_;
                       if (new_trainID_first != trainID_first) {
                         if (new_trainID_first < trainID_first) {
                           ticket = new_ticket;
@@ -606,163 +991,173 @@ void System::QueryTransfer() {
     }
   }
   if (ticket.first_.train_id_ == -1) {
-    std::cout << "0\n";
+    os << "0\n";
   } else {
-    ticket.first_.Print(&train_system_);
-    ticket.second_.Print(&train_system_);
+    ticket.first_.Print(&train_system_, os);
+    ticket.second_.Print(&train_system_, os);
   }
 }
 
-void System::BuyTicket() {
+void System::BuyTicket(int timestamp, Input &input, std::ostream &os) {
   Order order;
-  order.info_.buy_time_ = timestamp_;
+  order.info_.buy_time_ = timestamp;
   std::string option = "false";
   int date;
   array<char, 20> trainID;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 'u') {
-      order.info_.user_ = input_.GetString<20>();
+      order.info_.user_ = input.GetString<20>();
     } else if (key == 'i') {
-      trainID = input_.GetString<20>();
+      trainID = input.GetString<20>();
     } else if (key == 'd') {
-      date = input_.GetDate();
+      date = input.GetDate();
     } else if (key == 'n') {
-      order.ticket_.seat_ = input_.GetInteger();
+      order.ticket_.seat_ = input.GetInteger();
     } else if (key == 'f') {
-      array<unsigned int, 10> start_station = input_.GetChinese<10>();
+      array<unsigned int, 10> start_station = input.GetChinese<10>();
       order.ticket_.start_station_ = train_system_.StationID(start_station, false);
     } else if (key == 't') {
-      array<unsigned int, 10> end_station = input_.GetChinese<10>();
+      array<unsigned int, 10> end_station = input.GetChinese<10>();
       order.ticket_.end_station_ = train_system_.StationID(end_station, false);
     } else if (key == 'q') {
-      option = input_.GetCommand();
+      option = input.GetCommand();
     } else {
       assert(key == '\n');
       break;
     }
   }
   if (order.ticket_.start_station_ == -1 || order.ticket_.end_station_ == -1
-    || online_users_.find(order.info_.user_) == online_users_.end()) {
-    std::cout << "-1\n";
+    || !FindOnlineUser(order.info_.user_)) {
+    os << "-1\n";
     return;
   }
   order.ticket_.train_id_ = train_system_.TrainID(trainID);
-  auto train = train_system_.QueryTrain(order.ticket_.train_id_);
-  if (!train.is_released_ || order.ticket_.seat_ > train.max_seatNum_) {
-    std::cout << "-1\n";
-    return;
-  }
+  int start_date;
   int start_pos = -1;
   int end_pos = -1;
-  for (int i = 0; i < train.stationNum_; ++i) {
-    if (train.stations_[i] == order.ticket_.start_station_) {
-      start_pos = i;
-    } else if (train.stations_[i] == order.ticket_.end_station_) {
-      end_pos = i;
+  {
+    // the train is only read in place, and released before its seats go through the seat cache
+    auto guard = train_system_.ReadTrain(order.ticket_.train_id_);
+    const Train &train = *guard;
+    if (!train.is_released_ || order.ticket_.seat_ > train.max_seatNum_) {
+      os << "-1\n";
+      return;
+    }
+    for (int i = 0; i < train.stationNum_; ++i) {
+      if (train.stations_[i] == order.ticket_.start_station_) {
+        start_pos = i;
+      } else if (train.stations_[i] == order.ticket_.end_station_) {
+        end_pos = i;
+      }
+    }
+    if (start_pos < 0 || end_pos < 0 || start_pos >= end_pos) {
+      os << "-1\n";
+      return;
     }
-  }
-  if (start_pos >= 0 && end_pos >= 0 && start_pos < end_pos) {
     int start_total_time = train.arrivingTimes_[start_pos];
     if (start_pos > 0) {
       start_total_time += train.stopoverTimes_[start_pos - 1];
     }
-    int start_date = date - start_total_time / 1440;
+    start_date = date - start_total_time / 1440;
     if (start_date < train.saleDate_start_ || start_date > train.saleDate_end_) {
-      std::cout << "-1\n";
+      os << "-1\n";
       return;
     }
     order.ticket_.start_time_ = start_date * 1440 + start_total_time;
     order.ticket_.end_time_ = start_date * 1440 + train.arrivingTimes_[end_pos];
-    int seat = MAX_SEAT_NUM;
     order.ticket_.price_ = 0;
     for (int i = start_pos; i < end_pos; ++i) {
       order.ticket_.price_ += train.prices_[i];
-      if (train.seatNum_[start_date][i] < seat) {
-        seat = train.seatNum_[start_date][i];
-      }
     }
-    if (seat < order.ticket_.seat_) {
-      if (option[0] == 'f') {
-        std::cout << "-1\n";
-      } else {
-        order.state_ = Order::kPending;
-        ticket_system_.AddOrder(order);
-        std::cout << "queue\n";
-      }
+  }
+  auto seats = train_system_.QuerySeats(order.ticket_.train_id_, start_date);
+  int seat = MAX_SEAT_NUM;
+  for (int i = start_pos; i < end_pos; ++i) {
+    if (seats[i] < seat) {
+      seat = seats[i];
+    }
+  }
+  if (seat < order.ticket_.seat_) {
+    if (option[0] == 'f') {
+      os << "-1\n";
     } else {
-      int total_price = 0;
-      for (int i = start_pos; i < end_pos; ++i) {
-        train.seatNum_[start_date][i] -= order.ticket_.seat_;
-        total_price += train.prices_[i];
-      }
-      train_system_.UpdateTrain(order.ticket_.train_id_, train);
-      order.state_ = Order::kSuccess;
+      order.state_ = Order::kPending;
       ticket_system_.AddOrder(order);
-      std::cout << 1ll * total_price * order.ticket_.seat_ << '\n';
+      os << "queue\n";
     }
   } else {
-    std::cout << "-1\n";
+    for (int i = start_pos; i < end_pos; ++i) {
+      seats[i] -= order.ticket_.seat_;
+    }
+    train_system_.UpdateSeats(order.ticket_.train_id_, start_date, seats);
+    order.state_ = Order::kSuccess;
+    ticket_system_.AddOrder(order);
+    os << 1ll * order.ticket_.price_ * order.ticket_.seat_ << '\n';
   }
 }
 
-void System::QueryOrder() {
-  assert(input_.GetKey() == 'u');
-  array<char, 20> username = input_.GetString<20>();
-  assert(input_.GetKey() == '\n');
-  if (online_users_.find(username) == online_users_.end()) {
-    std::cout << "-1\n";
+void System::QueryOrder(Input &input, std::ostream &os) {
+  assert(input.GetKey() == 'u');
+  array<char, 20> username = input.GetString<20>();
+  assert(input.GetKey() == '\n');
+  if (!FindOnlineUser(username)) {
+    os << "-1\n";
   } else {
-    vector<Order> tmp;
+    vector<Rid> tmp;
     ticket_system_.QueryOrder(username, &tmp);
     size_t size = tmp.size();
-    std::cout << size << '\n';
+    os << size << '\n';
     for (int i = static_cast<int>(size) - 1; i >= 0; --i) {
-      std::cout << '[';
-      if (tmp[i].state_ == Order::kSuccess) {
-        std::cout << "success";
-      } else if (tmp[i].state_ == Order::kPending) {
-        std::cout << "pending";
+      Order order = ticket_system_.GetOrder(tmp[i]);
+      os << '[';
+      if (order.state_ == Order::kSuccess) {
+        os << "success";
+      } else if (order.state_ == Order::kPending) {
+        os << "pending";
       } else {
-        std::cout << "refunded";
+        os << "refunded";
       }
-      std::cout << "] ";
-      std::cout << ArrayToString<20>(train_system_.QueryTrain(tmp[i].ticket_.train_id_).trainID_) << " ";
-      std::cout << ChineseToString<10>(train_system_.StationName(tmp[i].ticket_.start_station_)) << " ";
-      PrintTime(tmp[i].ticket_.start_time_);
-      std::cout << " -> ";
-      std::cout << ChineseToString<10>(train_system_.StationName(tmp[i].ticket_.end_station_)) << " ";
-      PrintTime(tmp[i].ticket_.end_time_);
-      std::cout << " " << tmp[i].ticket_.price_ << " " << tmp[i].ticket_.seat_ << '\n';
+      os << "] ";
+      os << ArrayToString<20>(train_system_.ReadTrain(order.ticket_.train_id_)->trainID_) << " ";
+      os << ChineseToString<10>(train_system_.StationName(order.ticket_.start_station_)) << " ";
+      PrintTime(os, order.ticket_.start_time_);
+      os << " -> ";
+      os << ChineseToString<10>(train_system_.StationName(order.ticket_.end_station_)) << " ";
+      PrintTime(os, order.ticket_.end_time_);
+      os << " " << order.ticket_.price_ << " " << order.ticket_.seat_ << '\n';
     }
   }
 }
 
-void System::RefundTicket() {
+void System::RefundTicket(Input &input, std::ostream &os) {
   array<char, 20> username;
   int index = 1;
   while (true) {
-    auto key = input_.GetKey();
+    auto key = input.GetKey();
     if (key == 'u') {
-      username = input_.GetString<20>();
+      username = input.GetString<20>();
     } else if (key == 'n') {
-      index = input_.GetInteger();
+      index = input.GetInteger();
     } else {
       assert(key == '\n');
       break;
     }
   }
-  if (online_users_.find(username) == online_users_.end()) {
-    std::cout << "-1\n";
+  if (!FindOnlineUser(username)) {
+    os << "-1\n";
     return;
   }
-  vector<Order> tmp;
+  vector<Rid> tmp;
   ticket_system_.QueryOrder(username, &tmp);
   size_t size = tmp.size();
-  if (size < index || tmp[size - index].state_ == Order::kRefunded) {
-    std::cout << "-1\n";
+  Order order;
+  if (size >= index) {
+    order = ticket_system_.GetOrder(tmp[size - index]);
+  }
+  if (size < index || order.state_ == Order::kRefunded) {
+    os << "-1\n";
   } else {
-    Order &order = tmp[size - index];
     if (order.state_ == Order::kSuccess) {
       Train train = train_system_.QueryTrain(order.ticket_.train_id_);
       int start_pos = -1, end_pos = -1;
@@ -774,14 +1169,19 @@ void System::RefundTicket() {
         }
       }
       int start_date = (order.ticket_.start_time_ - train.arrivingTimes_[start_pos]) / 1440;
+      auto seats = train_system_.QuerySeats(order.ticket_.train_id_, start_date);
       for (int i = start_pos; i < end_pos; ++i) {
-        train.seatNum_[start_date][i] += order.ticket_.seat_;
+        seats[i] += order.ticket_.seat_;
       }
-      train_system_.UpdateTrain(order.ticket_.train_id_, train);
+      train_system_.UpdateSeats(order.ticket_.train_id_, start_date, seats);
 
+      vector<Rid> queue_rids;
+      ticket_system_.GetQueue(&queue_rids);
+      size_t queue_size = queue_rids.size();
       vector<Order> queue;
-      ticket_system_.GetQueue(&queue);
-      size_t queue_size = queue.size();
+      for (size_t i = 0; i < queue_size; ++i) {
+        queue.push_back(ticket_system_.GetOrder(queue_rids[i]));
+      }
       for (size_t i = 0; i < queue_size; ++i) {
         if (queue[i].ticket_.train_id_ == order.ticket_.train_id_) {
           start_pos = -1, end_pos = -1;
@@ -793,40 +1193,140 @@ void System::RefundTicket() {
             }
           }
           start_date = (queue[i].ticket_.start_time_ - train.arrivingTimes_[start_pos]) / 1440;
+          seats = train_system_.QuerySeats(order.ticket_.train_id_, start_date);
           int seat = MAX_SEAT_NUM;
           for (int j = start_pos; j < end_pos; ++j) {
-            if (train.seatNum_[start_date][j] < seat) {
-              seat = train.seatNum_[start_date][j];
+            if (seats[j] < seat) {
+              seat = seats[j];
             }
           }
           if (seat >= queue[i].ticket_.seat_) {
             for (int j = start_pos; j < end_pos; ++j) {
-              train.seatNum_[start_date][j] -= queue[i].ticket_.seat_;
+              seats[j] -= queue[i].ticket_.seat_;
             }
+            train_system_.UpdateSeats(order.ticket_.train_id_, start_date, seats);
             ticket_system_.RemoveFromQueue(queue[i].info_.buy_time_);
-            ticket_system_.DeleteOrder(queue[i]);
-            queue[i].state_ = Order::kSuccess;
-            ticket_system_.AddOrder(queue[i]);
+            ticket_system_.SetOrderState(queue_rids[i], Order::kSuccess);
           }
         }
       }
-      train_system_.UpdateTrain(order.ticket_.train_id_, train);
     } else {
       ticket_system_.RemoveFromQueue(order.info_.buy_time_);
     }
-    ticket_system_.DeleteOrder(order);
-    order.state_ = Order::kRefunded;
-    ticket_system_.AddOrder(order);
-    std::cout << "0\n";
+    ticket_system_.SetOrderState(tmp[size - index], Order::kRefunded);
+    os << "0\n";
   }
 }
 
-void System::Clean() {
+void System::Clean(std::ostream &os) {
   user_system_.Clean();
   train_system_.Clean();
   ticket_system_.Clean();
-  online_users_.clear();
-  std::cout << "0\n";
+  {
+    std::unique_lock latch(online_latch_);
+    online_users_.clear();
+  }
+  os << "0\n";
+}
+
+static auto GetSnapshotName(Input &input) -> std::string {
+  assert(input.GetKey() == 'n');
+  auto name = ArrayToString<16>(input.GetString<16>());
+  assert(input.GetKey() == '\n');
+  return name;
+}
+
+/**
+ * Snapshots cover every file of the system and share the pages they have in common, see DiskManager. Like clean,
+ * they are barriers when commands run in parallel.
+ */
+void System::CreateSnapshot(Input &input, std::ostream &os) {
+  auto name = GetSnapshotName(input);
+  if (!user_system_.CreateSnapshot(name)) {
+    os << "-1\n";
+    return;
+  }
+  train_system_.CreateSnapshot(name);
+  ticket_system_.CreateSnapshot(name);
+  os << "0\n";
+}
+
+// The logged-in users stay logged in if they exist in the snapshot, with their profiles in the snapshot
+void System::SwitchSnapshot(Input &input, std::ostream &os) {
+  auto name = GetSnapshotName(input);
+  if (!user_system_.SwitchSnapshot(name)) {
+    os << "-1\n";
+    return;
+  }
+  train_system_.SwitchSnapshot(name);
+  ticket_system_.SwitchSnapshot(name);
+  {
+    std::unique_lock latch(online_latch_);
+    vector<array<char, 20>> usernames;
+    for (auto it = online_users_.begin(); it != online_users_.end(); ++it) {
+      usernames.push_back(it->first);
+    }
+    for (size_t i = 0; i < usernames.size(); ++i) {
+      auto user = user_system_.QueryUser(usernames[i]);
+      if (user.privilege_ > 10) {  // not found
+        online_users_.erase(online_users_.find(usernames[i]));
+      } else {
+        online_users_[usernames[i]] = user;
+      }
+    }
+  }
+  os << "0\n";
 }
 
-}
\ No newline at end of file
+void System::DropSnapshot(Input &input, std::ostream &os) {
+  auto name = GetSnapshotName(input);
+  if (!user_system_.DropSnapshot(name)) {
+    os << "-1\n";
+    return;
+  }
+  train_system_.DropSnapshot(name);
+  ticket_system_.DropSnapshot(name);
+  os << "0\n";
+}
+
+/**
+ * Print one line per database file, then one line per command that has run:
+ *
+ *   <file> pages <n> [entries <n> height <n> resident <n> swizzled_hits <n>] hits <n> misses <n> evictions <n>
+ *   write_backs <n> reads <n> writes <n> flushes <n> deletes <n>
+ *   <command> count <n> time_ms <total>
+ *
+ * The counters are cumulative since the start of the process. Write-backs are the dirty victims written by a miss
+ * instead of the background flusher. Resident counts the upper pages that an index keeps in its pool for good, and
+ * swizzled hits the hits on them that skipped the page table.
+ */
+void System::Stats(std::ostream &os) {
+  static_assert(std::size(kCommands) == kCommandCnt);
+  vector<FileStats> stats;
+  CollectStats(&stats);
+  os << "stats\n";
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const auto &file = stats[i];
+    os << file.name_ << " pages " << file.page_cnt_;
+    if (file.entry_cnt_ >= 0) {
+      os << " entries " << file.entry_cnt_ << " height " << file.height_ << " resident " << file.resident_page_cnt_
+         << " swizzled_hits " << file.swizzled_hit_cnt_;
+    }
+    if (file.filter_byte_cnt_ >= 0) {
+      os << " filter_bytes " << file.filter_byte_cnt_ << " filter_negatives " << file.filter_negative_cnt_
+         << " filter_false_positives " << file.filter_false_positive_cnt_;
+    }
+    os << " hits " << file.hit_cnt_ << " misses " << file.miss_cnt_ << " evictions " << file.evict_cnt_
+       << " write_backs " << file.write_back_cnt_ << " reads " << file.read_cnt_ << " writes " << file.write_cnt_
+       << " flushes " << file.flush_cnt_ << " deletes " << file.delete_cnt_ << '\n';
+  }
+  for (int i = 0; i < kCommandCnt; ++i) {
+    size_t cnt = command_stats_[i].cnt_.load(std::memory_order_relaxed);
+    if (cnt > 0) {
+      os << kCommands[i] << " count " << cnt << " time_ms " << std::fixed << std::setprecision(3)
+         << command_stats_[i].nanos_.load(std::memory_order_relaxed) / 1e6 << std::defaultfloat << '\n';
+    }
+  }
+}
+
+}
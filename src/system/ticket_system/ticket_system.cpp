@@ -1,23 +1,31 @@
+#include <cstddef>
+
 #include "system/ticket_system/ticket_system.h"
 
 namespace sjtu {
 
 void TicketSystem::AddOrder(const Order &order) {
-  orders_.Insert(order.info_, order);
+  Rid rid = order_records_.Insert(order);
+  orders_.Insert(order.info_, rid);
   if (order.state_ == Order::kPending) {
-    queue_.Insert(order.info_.buy_time_, order);
+    queue_.Insert(order.info_.buy_time_, rid);
   }
 }
 
-void TicketSystem::DeleteOrder(const Order &order) {
-  orders_.Remove(order.info_);
+void TicketSystem::QueryOrder(const array<char, 20> &user, vector<Rid> *tmp) {
+  orders_.GetAllValue({user, 0}, tmp);
 }
 
-void TicketSystem::QueryOrder(const array<char, 20> &user, vector<Order> *tmp) {
-  orders_.GetAllValue({user, 0}, tmp);
+auto TicketSystem::GetOrder(const Rid &rid) -> Order {
+  return order_records_.Get<Order>(rid);
 }
 
-void TicketSystem::GetQueue(vector<Order> *tmp) {
+// only the state is written, the rest of the record is left untouched
+void TicketSystem::SetOrderState(const Rid &rid, Order::State state) {
+  order_records_.Update(rid, reinterpret_cast<const char *>(&state), offsetof(Order, state_), sizeof(state));
+}
+
+void TicketSystem::GetQueue(vector<Rid> *tmp) {
   queue_.GetAll(tmp);
 }
 
@@ -28,6 +36,52 @@ void TicketSystem::RemoveFromQueue(const int &time) {
 void TicketSystem::Clean() {
   orders_.Clean();
   queue_.Clean();
+  order_records_.Clean();
 }
 
-}
\ No newline at end of file
+void TicketSystem::PrepareCheckpoint(size_t epoch, vector<std::string> *files) {
+  orders_.PrepareCheckpoint(epoch, files);
+  queue_.PrepareCheckpoint(epoch, files);
+  order_records_.PrepareCheckpoint(epoch, files);
+}
+
+void TicketSystem::ApplyCheckpoint() {
+  orders_.ApplyCheckpoint();
+  queue_.ApplyCheckpoint();
+  order_records_.ApplyCheckpoint();
+}
+
+auto TicketSystem::CreateSnapshot(const std::string &name) -> bool {
+  if (!orders_.CreateSnapshot(name)) {
+    return false;
+  }
+  queue_.CreateSnapshot(name);
+  order_records_.CreateSnapshot(name);
+  return true;
+}
+
+auto TicketSystem::SwitchSnapshot(const std::string &name) -> bool {
+  if (!orders_.SwitchSnapshot(name)) {
+    return false;
+  }
+  queue_.SwitchSnapshot(name);
+  order_records_.SwitchSnapshot(name);
+  return true;
+}
+
+auto TicketSystem::DropSnapshot(const std::string &name) -> bool {
+  if (!orders_.DropSnapshot(name)) {
+    return false;
+  }
+  queue_.DropSnapshot(name);
+  order_records_.DropSnapshot(name);
+  return true;
+}
+
+void TicketSystem::CollectStats(vector<FileStats> *stats) {
+  orders_.CollectStats(stats);
+  queue_.CollectStats(stats);
+  order_records_.CollectStats(stats);
+}
+
+}
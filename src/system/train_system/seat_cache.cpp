@@ -0,0 +1,83 @@
+#include <cstddef>
+
+#include "system/train_system/seat_cache.h"
+
+namespace sjtu {
+
+SeatCache::SeatCache(RecordFile<Train, TRAIN_PAGE_SIZE> *trains, size_t capacity)
+    : trains_(trains), capacity_(capacity) {}
+
+SeatCache::~SeatCache() { FlushAll(); }
+
+auto SeatCache::Find(int train_id, int date, Seats *seats) -> bool {
+  std::scoped_lock latch(latch_);
+  auto it = entries_.find(Key(train_id, date));
+  if (it == entries_.end()) {
+    return false;
+  }
+  *seats = it->second.seats_;
+  return true;
+}
+
+auto SeatCache::Get(int train_id, int date) -> Seats {
+  std::scoped_lock latch(latch_);
+  return Admit(Key(train_id, date)).seats_;
+}
+
+void SeatCache::Put(int train_id, int date, const Seats &seats) {
+  std::scoped_lock latch(latch_);
+  auto &entry = Admit(Key(train_id, date));
+  entry.seats_ = seats;
+  entry.dirty_ = true;
+}
+
+void SeatCache::FlushAll() {
+  std::scoped_lock latch(latch_);
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->second.dirty_) {
+      WriteBack(it->first, it->second);
+      it->second.dirty_ = false;
+    }
+  }
+}
+
+void SeatCache::Clear() {
+  std::scoped_lock latch(latch_);
+  entries_.clear();
+  lru_.clear();
+}
+
+/**
+ * @brief Find the entry of a row, loading it from the train record on a miss, and mark it as the most recently used.
+ * The least recently used entry is written back if dirty and evicted once the cache is over its capacity.
+ */
+auto SeatCache::Admit(size_t key) -> Entry & {
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    lru_.erase(it->second.lru_pos_);
+    lru_.push_back(key);
+    it->second.lru_pos_ = --lru_.end();
+    return it->second;
+  }
+  if (entries_.size() >= capacity_) {
+    size_t victim = *lru_.begin();
+    auto victim_it = entries_.find(victim);
+    if (victim_it->second.dirty_) {
+      WriteBack(victim, victim_it->second);
+    }
+    entries_.erase(victim_it);
+    lru_.erase(lru_.begin());
+  }
+  Entry entry;
+  entry.seats_ = trains_->Read(key / 92)->seatNum_[key % 92];
+  lru_.push_back(key);
+  entry.lru_pos_ = --lru_.end();
+  return entries_.insert({key, entry}).first->second;
+}
+
+void SeatCache::WriteBack(size_t key, const Entry &entry) {
+  size_t offset = offsetof(Train, seatNum_) + key % 92 * sizeof(Seats);
+  trains_->Update(key / 92, offset, reinterpret_cast<const char *>(&entry.seats_), sizeof(Seats));
+}
+
+}
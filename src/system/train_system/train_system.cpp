@@ -10,6 +10,15 @@ auto TrainSystem::TrainID(const array<char, 20> &train) -> int {
   return tmp[0];
 }
 
+// return -1 if the train does not exist
+auto TrainSystem::FindTrainID(const array<char, 20> &train) -> int {
+  vector<int> tmp;
+  if (!train_id_.GetValue(train, &tmp)) {
+    return -1;
+  }
+  return tmp[0];
+}
+
 auto TrainSystem::StationID(array<unsigned int, 10> &station, bool add_new) -> int {
   vector<int> tmp;
   if (station_id_.GetValue(station, &tmp)) {
@@ -25,9 +34,7 @@ auto TrainSystem::StationID(array<unsigned int, 10> &station, bool add_new) -> i
 }
 
 auto TrainSystem::StationName(const int &id) -> array<unsigned int, 10> {
-  array<unsigned int, 10> res;
-  station_name_.Read(res, id);
-  return res;
+  return station_name_.Get(id);
 }
 
 auto TrainSystem::AddTrain(Train &train) -> bool {
@@ -53,9 +60,12 @@ void TrainSystem::ReleaseTrain(Train &train) {
 }
 
 auto TrainSystem::QueryTrain(const int &train_id) -> Train {
-  Train res;
-  trains_.Read(res, train_id);
-  return res;
+  return trains_.Get(train_id);
+}
+
+// read a train in place, without copying it. see RecordGuard
+auto TrainSystem::ReadTrain(const int &train_id) -> RecordGuard<Train> {
+  return trains_.Read(train_id);
 }
 
 auto TrainSystem::QueryTrain(const array<char, 20> &trainID) -> Train {
@@ -67,8 +77,24 @@ auto TrainSystem::QueryTrain(const array<char, 20> &trainID) -> Train {
   return QueryTrain(tmp[0]);
 }
 
-void TrainSystem::UpdateTrain(const int &train_id, Train &new_train) {
-  trains_.Update(new_train, train_id);
+// the seats of a train on a date, through the seat cache
+auto TrainSystem::QuerySeats(const int &train_id, const int &date) -> Seats {
+  return seat_cache_.Get(train_id, date);
+}
+
+// the seats of a train on a date for a query that has already read the train: the cached row if any, otherwise the row
+// of the train. The row is not admitted into the cache
+auto TrainSystem::QuerySeats(const int &train_id, const int &date, const Train &train) -> Seats {
+  Seats seats;
+  if (!seat_cache_.Find(train_id, date, &seats)) {
+    seats = train.seatNum_[date];
+  }
+  return seats;
+}
+
+// only the seats of the given date are updated, so that concurrent updates of other dates are not overwritten
+void TrainSystem::UpdateSeats(const int &train_id, const int &date, const Seats &seats) {
+  seat_cache_.Put(train_id, date, seats);
 }
 
 void TrainSystem::QueryStationInfo(const int &id, vector<TrainStation> *info) {
@@ -76,11 +102,73 @@ void TrainSystem::QueryStationInfo(const int &id, vector<TrainStation> *info) {
 }
 
 void TrainSystem::Clean() {
+  seat_cache_.Clear();
   train_id_.Clean();
   station_id_.Clean();
   station_info_.Clean();
-  station_name_.Initialise();
-  trains_.Initialise();
+  station_name_.Clean();
+  trains_.Clean();
+}
+
+void TrainSystem::PrepareCheckpoint(size_t epoch, vector<std::string> *files) {
+  seat_cache_.FlushAll();
+  train_id_.PrepareCheckpoint(epoch, files);
+  station_id_.PrepareCheckpoint(epoch, files);
+  station_info_.PrepareCheckpoint(epoch, files);
+  station_name_.PrepareCheckpoint(epoch, files);
+  trains_.PrepareCheckpoint(epoch, files);
+}
+
+void TrainSystem::ApplyCheckpoint() {
+  train_id_.ApplyCheckpoint();
+  station_id_.ApplyCheckpoint();
+  station_info_.ApplyCheckpoint();
+  station_name_.ApplyCheckpoint();
+  trains_.ApplyCheckpoint();
+}
+
+auto TrainSystem::CreateSnapshot(const std::string &name) -> bool {
+  seat_cache_.FlushAll();
+  if (!train_id_.CreateSnapshot(name)) {
+    return false;
+  }
+  station_id_.CreateSnapshot(name);
+  station_info_.CreateSnapshot(name);
+  station_name_.CreateSnapshot(name);
+  trains_.CreateSnapshot(name);
+  return true;
+}
+
+auto TrainSystem::SwitchSnapshot(const std::string &name) -> bool {
+  seat_cache_.FlushAll();
+  if (!train_id_.SwitchSnapshot(name)) {
+    return false;
+  }
+  seat_cache_.Clear();
+  station_id_.SwitchSnapshot(name);
+  station_info_.SwitchSnapshot(name);
+  station_name_.SwitchSnapshot(name);
+  trains_.SwitchSnapshot(name);
+  return true;
+}
+
+auto TrainSystem::DropSnapshot(const std::string &name) -> bool {
+  if (!train_id_.DropSnapshot(name)) {
+    return false;
+  }
+  station_id_.DropSnapshot(name);
+  station_info_.DropSnapshot(name);
+  station_name_.DropSnapshot(name);
+  trains_.DropSnapshot(name);
+  return true;
+}
+
+void TrainSystem::CollectStats(vector<FileStats> *stats) {
+  train_id_.CollectStats(stats);
+  station_id_.CollectStats(stats);
+  station_info_.CollectStats(stats);
+  station_name_.CollectStats(stats);
+  trains_.CollectStats(stats);
 }
 
 }
@@ -1,31 +1,85 @@
 #include "system/user_system/user_system.h"
+#include <cassert>
 #include "my_stl/vector.hpp"
 
 namespace sjtu {
 
 auto UserSystem::AddUser(const User &user) -> bool {
-  return users_.Insert(user.username_, user);
+  vector<Rid> tmp;
+  if (users_.GetValue(user.username_, &tmp)) {
+    return false;
+  }
+  return users_.Insert(user.username_, user_records_.Insert(user));
 }
 
 auto UserSystem::QueryUser(const array<char, 20> &username) -> User {
-  vector<User> tmp;
+  vector<Rid> tmp;
   if (!users_.GetValue(username, &tmp)) {
     return {};
   }
   assert(tmp.size() == 1);
-  return tmp[0];
+  return user_records_.Get<User>(tmp[0]);
 }
 
+// the record of a removed user is left in the heap file, and is dropped by the next `Clean`
 void UserSystem::RemoveUser(const array<char, 20> &username) {
   users_.Remove(username);
 }
 
+// overwrite the record of an existing user in place
+void UserSystem::UpdateUser(const User &user) {
+  vector<Rid> tmp;
+  if (users_.GetValue(user.username_, &tmp)) {
+    user_records_.Update(tmp[0], user);
+  }
+}
+
 auto UserSystem::IsEmpty() -> bool {
   return users_.IsEmpty();
 }
 
 void UserSystem::Clean() {
   users_.Clean();
+  user_records_.Clean();
+}
+
+void UserSystem::PrepareCheckpoint(size_t epoch, vector<std::string> *files) {
+  users_.PrepareCheckpoint(epoch, files);
+  user_records_.PrepareCheckpoint(epoch, files);
+}
+
+void UserSystem::ApplyCheckpoint() {
+  users_.ApplyCheckpoint();
+  user_records_.ApplyCheckpoint();
+}
+
+auto UserSystem::CreateSnapshot(const std::string &name) -> bool {
+  if (!users_.CreateSnapshot(name)) {
+    return false;
+  }
+  user_records_.CreateSnapshot(name);
+  return true;
+}
+
+auto UserSystem::SwitchSnapshot(const std::string &name) -> bool {
+  if (!users_.SwitchSnapshot(name)) {
+    return false;
+  }
+  user_records_.SwitchSnapshot(name);
+  return true;
+}
+
+auto UserSystem::DropSnapshot(const std::string &name) -> bool {
+  if (!users_.DropSnapshot(name)) {
+    return false;
+  }
+  user_records_.DropSnapshot(name);
+  return true;
 }
 
-}
\ No newline at end of file
+void UserSystem::CollectStats(vector<FileStats> *stats) {
+  users_.CollectStats(stats);
+  user_records_.CollectStats(stats);
+}
+
+}
@@ -0,0 +1,187 @@
+/**
+ * bench replays a command file through a System and reports, as JSON:
+ *  - the latency histogram of every command type (p50 / p99 / p999, HDR-style buckets),
+ *  - the throughput of the whole run,
+ *  - the buffer pool hits and misses, the disk reads and writes and the size of every database file.
+ *
+ * usage: bench <command file> [output file]
+ *
+ * Commands run in the sequential mode, one at a time. Run it in an empty directory: the database files are named
+ * bench_*, and existing ones are opened as they are.
+ */
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "my_stl/array.hpp"
+#include "my_stl/map.hpp"
+#include "system/system.h"
+
+namespace sjtu {
+
+/**
+ * A log-linear histogram: values below 2^(kSubBucketBits + 1) have a bucket each, and every larger power of two is
+ * split into 2^kSubBucketBits buckets, so a recorded value is off by at most 1 / 2^kSubBucketBits.
+ */
+class Histogram {
+ public:
+  void Record(uint64_t value) {
+    ++counts_[BucketOf(value)];
+    ++count_;
+    sum_ += value;
+    if (value > max_) {
+      max_ = value;
+    }
+  }
+
+  // Return the upper bound of the bucket that holds the given percentile
+  auto Percentile(double percentile) const -> uint64_t {
+    uint64_t rank = static_cast<uint64_t>(percentile / 100 * count_ + 0.5);
+    if (rank == 0) {
+      rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCnt; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        uint64_t upper = UpperBoundOf(i);
+        return upper < max_ ? upper : max_;
+      }
+    }
+    return max_;
+  }
+
+  auto Count() const -> uint64_t { return count_; }
+
+  auto Mean() const -> double { return count_ == 0 ? 0 : static_cast<double>(sum_) / count_; }
+
+  auto Max() const -> uint64_t { return max_; }
+
+ private:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kBucketCnt = (64 - kSubBucketBits + 1) << kSubBucketBits;
+
+  static auto BucketOf(uint64_t value) -> int {
+    if (value < (1ULL << (kSubBucketBits + 1))) {
+      return static_cast<int>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - kSubBucketBits;
+    return ((shift + 1) << kSubBucketBits) + static_cast<int>((value >> shift) & ((1 << kSubBucketBits) - 1));
+  }
+
+  static auto UpperBoundOf(int bucket) -> uint64_t {
+    if (bucket < (1 << (kSubBucketBits + 1))) {
+      return bucket;
+    }
+    int shift = (bucket >> kSubBucketBits) - 1;
+    uint64_t mantissa = (1ULL << kSubBucketBits) + (bucket & ((1 << kSubBucketBits) - 1));
+    return ((mantissa + 1) << shift) - 1;
+  }
+
+  array<uint64_t, kBucketCnt> counts_{};
+  uint64_t count_{0};
+  uint64_t sum_{0};
+  uint64_t max_{0};
+};
+
+static auto CommandOf(const std::string &line) -> std::string {
+  size_t pos = line.find(' ') + 1;
+  return line.substr(pos, line.find_first_of(" \n", pos) - pos);
+}
+
+static auto Ratio(size_t x, size_t y) -> double { return y == 0 ? 0 : static_cast<double>(x) / y; }
+
+static void PrintFileStats(std::ostream &os, const FileStats &stats) {
+  os << "{\"pages\": " << stats.page_cnt_;
+  if (stats.entry_cnt_ >= 0) {
+    os << ", \"entries\": " << stats.entry_cnt_ << ", \"height\": " << stats.height_
+       << ", \"resident_pages\": " << stats.resident_page_cnt_ << ", \"swizzled_hits\": " << stats.swizzled_hit_cnt_;
+  }
+  if (stats.filter_byte_cnt_ >= 0) {
+    // every negative saves the page fetches of a lookup, and the false positive rate is taken over missing keys
+    os << ", \"filter_bytes\": " << stats.filter_byte_cnt_ << ", \"filter_negatives\": " << stats.filter_negative_cnt_
+       << ", \"filter_false_positives\": " << stats.filter_false_positive_cnt_ << ", \"filter_false_positive_rate\": "
+       << Ratio(stats.filter_false_positive_cnt_, stats.filter_negative_cnt_ + stats.filter_false_positive_cnt_);
+  }
+  os << ", \"hits\": " << stats.hit_cnt_ << ", \"misses\": " << stats.miss_cnt_
+     << ", \"hit_rate\": " << Ratio(stats.hit_cnt_, stats.hit_cnt_ + stats.miss_cnt_)
+     << ", \"evictions\": " << stats.evict_cnt_ << ", \"write_backs\": " << stats.write_back_cnt_
+     << ", \"reads\": " << stats.read_cnt_ << ", \"writes\": " << stats.write_cnt_ << "}";
+}
+
+}
+
+int main(int argc, char **argv) {
+  using sjtu::FileStats;
+  using sjtu::Histogram;
+  if (argc < 2) {
+    std::cerr << "usage: bench <command file> [output file]\n";
+    return 1;
+  }
+  std::ifstream trace(argv[1]);
+  if (!trace) {
+    std::cerr << "cannot open " << argv[1] << '\n';
+    return 1;
+  }
+  std::ofstream output_file;
+  if (argc > 2) {
+    output_file.open(argv[2]);
+  }
+  std::ostream output(argc > 2 ? output_file.rdbuf() : nullptr);
+
+  sjtu::map<std::string, Histogram> histograms;
+  sjtu::vector<FileStats> stats;
+  size_t command_cnt = 0;
+  auto start = std::chrono::steady_clock::now();
+  {
+    sjtu::System system("bench");
+    std::string line;
+    while (std::getline(trace, line)) {
+      line += '\n';
+      auto begin = std::chrono::steady_clock::now();
+      bool running = system.RunCommand(line, output);
+      auto end = std::chrono::steady_clock::now();
+      histograms[sjtu::CommandOf(line)].Record(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+      ++command_cnt;
+      if (!running) {
+        break;
+      }
+    }
+    system.CollectStats(&stats);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  auto &os = std::cout;
+  os << std::fixed << std::setprecision(3);
+  os << "{\n  \"commands\": " << command_cnt << ",\n  \"seconds\": " << seconds
+     << ",\n  \"throughput\": " << command_cnt / seconds << ",\n  \"latency_us\": {";
+  bool first = true;
+  for (auto it = histograms.begin(); it != histograms.end(); ++it) {
+    const auto &histogram = it->second;
+    os << (first ? "\n" : ",\n") << "    \"" << it->first << "\": {\"count\": " << histogram.Count()
+       << ", \"mean\": " << histogram.Mean() / 1000 << ", \"p50\": " << histogram.Percentile(50) / 1000.0
+       << ", \"p99\": " << histogram.Percentile(99) / 1000.0 << ", \"p999\": " << histogram.Percentile(99.9) / 1000.0
+       << ", \"max\": " << histogram.Max() / 1000.0 << "}";
+    first = false;
+  }
+  FileStats total;
+  os << "\n  },\n  \"files\": {";
+  for (size_t i = 0; i < stats.size(); ++i) {
+    os << (i == 0 ? "\n" : ",\n") << "    \"" << stats[i].name_ << "\": ";
+    sjtu::PrintFileStats(os, stats[i]);
+    total.page_cnt_ += stats[i].page_cnt_;
+    total.hit_cnt_ += stats[i].hit_cnt_;
+    total.miss_cnt_ += stats[i].miss_cnt_;
+    total.evict_cnt_ += stats[i].evict_cnt_;
+    total.write_back_cnt_ += stats[i].write_back_cnt_;
+    total.read_cnt_ += stats[i].read_cnt_;
+    total.write_cnt_ += stats[i].write_cnt_;
+  }
+  os << "\n  },\n  \"total\": ";
+  sjtu::PrintFileStats(os, total);
+  os << "\n}\n";
+  return 0;
+}
@@ -0,0 +1,313 @@
+/**
+ * workload_generator writes a reproducible command stream for load tests to stdout.
+ *
+ * usage: workload_generator [--seed N] [--users N] [--trains N] [--stations N] [--min-route N] [--max-route N]
+ *                           [--commands N] [--mix BUY,QUERY,REFUND] [--skew S]
+ *
+ * The stream starts with a setup phase: the users are added and logged in, and the trains are added and released.
+ * It is followed by `--commands` commands drawn from the buy / query / refund mix (in percent), and ends with exit.
+ * Queries are split between query_ticket, query_transfer, query_order and query_train.
+ *
+ * The stations of a route and the trains that are bought are drawn from Zipf distributions with exponent `--skew`, so
+ * a few hub stations and popular trains get most of the traffic. A skew of 0 is uniform.
+ */
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include "my_stl/vector.hpp"
+
+namespace sjtu {
+
+struct Options {
+  unsigned long long seed_{1};
+  int users_{1000};
+  int trains_{200};
+  int stations_{100};
+  int min_route_{2};
+  int max_route_{24};  // the capacity of Train::stations_
+  int commands_{100000};
+  int buy_percent_{50};
+  int query_percent_{40};
+  int refund_percent_{10};
+  double skew_{1.0};
+};
+
+/**
+ * Draws ranks in [0, n) with probability proportional to 1 / (rank + 1)^skew.
+ */
+class ZipfDistribution {
+ public:
+  ZipfDistribution(int n, double skew) {
+    double sum = 0;
+    for (int i = 0; i < n; ++i) {
+      sum += 1 / std::pow(i + 1, skew);
+      cdf_.push_back(sum);
+    }
+    for (int i = 0; i < n; ++i) {
+      cdf_[i] /= sum;
+    }
+  }
+
+  template <class Engine>
+  auto operator()(Engine &engine) const -> int {
+    double value = std::uniform_real_distribution<double>(0, 1)(engine);
+    int lower = 0;
+    int upper = static_cast<int>(cdf_.size()) - 1;
+    while (lower < upper) {
+      int mid = (lower + upper) / 2;
+      if (cdf_[mid] < value) {
+        lower = mid + 1;
+      } else {
+        upper = mid;
+      }
+    }
+    return lower;
+  }
+
+ private:
+  vector<double> cdf_;
+};
+
+struct TrainInfo {
+  vector<int> stations_;
+  int sale_start_;  // days since 06-01
+  int sale_end_;
+};
+
+class WorkloadGenerator {
+ public:
+  explicit WorkloadGenerator(const Options &options)
+      : options_(options),
+        engine_(options.seed_),
+        station_dist_(options.stations_, options.skew_),
+        train_dist_(options.trains_, options.skew_),
+        order_cnt_(options.users_, 0) {}
+
+  void Run() {
+    Setup();
+    for (int i = 0; i < options_.commands_; ++i) {
+      int choice = Uniform(0, options_.buy_percent_ + options_.query_percent_ + options_.refund_percent_ - 1);
+      if (choice < options_.buy_percent_) {
+        BuyTicket();
+      } else if (choice < options_.buy_percent_ + options_.query_percent_) {
+        Query();
+      } else {
+        RefundTicket();
+      }
+    }
+    Emit("exit");
+  }
+
+ private:
+  static constexpr int kSaleDays = 92;  // 06-01 to 08-31
+
+  auto Uniform(int lower, int upper) -> int { return std::uniform_int_distribution<int>(lower, upper)(engine_); }
+
+  void Emit(const std::string &command) { std::cout << '[' << ++timestamp_ << "] " << command << '\n'; }
+
+  static auto Username(int id) -> std::string { return "user_" + std::to_string(id); }
+
+  static auto TrainID(int id) -> std::string { return "train_" + std::to_string(id); }
+
+  // Station names are numbers written with 20 Chinese characters as digits
+  static auto StationName(int id) -> std::string {
+    static const char *kDigits[] = {"甲", "乙", "丙", "丁", "戊", "己", "庚", "辛", "壬", "癸",
+                                    "子", "丑", "寅", "卯", "辰", "巳", "午", "未", "申", "酉"};
+    std::string name;
+    do {
+      name = kDigits[id % 20] + name;
+      id /= 20;
+    } while (id > 0);
+    return name + "站";
+  }
+
+  static auto Date(int day) -> std::string {
+    int month = 6;
+    if (day >= 61) {
+      month = 8;
+      day -= 61;
+    } else if (day >= 30) {
+      month = 7;
+      day -= 30;
+    }
+    std::string res = "0" + std::to_string(month) + "-";
+    return res + (day + 1 < 10 ? "0" : "") + std::to_string(day + 1);
+  }
+
+  static auto Join(const vector<std::string> &items) -> std::string {
+    std::string res;
+    for (size_t i = 0; i < items.size(); ++i) {
+      res += (i == 0 ? "" : "|") + items[i];
+    }
+    return res;
+  }
+
+  void Setup() {
+    Emit("add_user -c root -u root -p root_password -n 管理员 -m root@example.com -g 10");
+    Emit("login -u root -p root_password");
+    for (int i = 1; i < options_.users_; ++i) {
+      Emit("add_user -c root -u " + Username(i) + " -p password_" + std::to_string(i) + " -n 乘客 -m " + Username(i) +
+           "@example.com -g " + std::to_string(Uniform(0, 9)));
+      Emit("login -u " + Username(i) + " -p password_" + std::to_string(i));
+    }
+    for (int i = 0; i < options_.trains_; ++i) {
+      AddTrain(i);
+    }
+    for (int i = 0; i < options_.trains_; ++i) {
+      Emit("release_train -i " + TrainID(i));
+    }
+  }
+
+  void AddTrain(int id) {
+    int max_route = std::min(options_.max_route_, options_.stations_);
+    int station_cnt = Uniform(std::min(options_.min_route_, max_route), max_route);
+    TrainInfo train;
+    while (static_cast<int>(train.stations_.size()) < station_cnt) {
+      int station = station_dist_(engine_);
+      bool duplicated = false;
+      for (size_t i = 0; i < train.stations_.size(); ++i) {
+        duplicated |= train.stations_[i] == station;
+      }
+      if (!duplicated) {
+        train.stations_.push_back(station);
+      }
+    }
+    train.sale_start_ = Uniform(0, kSaleDays - 1);
+    train.sale_end_ = Uniform(train.sale_start_, kSaleDays - 1);
+    vector<std::string> stations;
+    vector<std::string> prices;
+    vector<std::string> travel_times;
+    vector<std::string> stopover_times;
+    for (int i = 0; i < station_cnt; ++i) {
+      stations.push_back(StationName(train.stations_[i]));
+      if (i + 1 < station_cnt) {
+        prices.push_back(std::to_string(Uniform(1, 1000)));
+        travel_times.push_back(std::to_string(Uniform(10, 600)));
+      }
+      if (i > 0 && i + 1 < station_cnt) {
+        stopover_times.push_back(std::to_string(Uniform(1, 20)));
+      }
+    }
+    char start_time[6];
+    snprintf(start_time, sizeof(start_time), "%02d:%02d", Uniform(0, 23), Uniform(0, 59));
+    Emit("add_train -i " + TrainID(id) + " -n " + std::to_string(station_cnt) + " -m " +
+         std::to_string(Uniform(100, 100000)) + " -s " + Join(stations) + " -p " + Join(prices) + " -x " +
+         start_time + " -t " + Join(travel_times) + " -o " + (station_cnt == 2 ? "_" : Join(stopover_times)) +
+         " -d " + Date(train.sale_start_) + "|" + Date(train.sale_end_) + " -y " + "GDKZT"[Uniform(0, 4)]);
+    trains_.push_back(train);
+  }
+
+  void BuyTicket() {
+    int user = Uniform(0, options_.users_ - 1);
+    int id = train_dist_(engine_);
+    const auto &train = trains_[id];
+    int from = Uniform(0, static_cast<int>(train.stations_.size()) - 2);
+    int to = Uniform(from + 1, static_cast<int>(train.stations_.size()) - 1);
+    // the date is the departure from `from`, which may be a few days after the train leaves its first station
+    int date = std::min(Uniform(train.sale_start_, train.sale_end_ + 1), kSaleDays - 1);
+    Emit("buy_ticket -u " + (user == 0 ? std::string("root") : Username(user)) + " -i " + TrainID(id) + " -d " +
+         Date(date) + " -n " + std::to_string(Uniform(1, 10)) + " -f " + StationName(train.stations_[from]) +
+         " -t " + StationName(train.stations_[to]) + " -q " + (Uniform(0, 1) == 0 ? "true" : "false"));
+    ++order_cnt_[user];
+  }
+
+  void Query() {
+    int choice = Uniform(0, 99);
+    if (choice < 60 || choice >= 90) {
+      int from = station_dist_(engine_);
+      int to = station_dist_(engine_);
+      while (to == from && options_.stations_ > 1) {
+        to = station_dist_(engine_);
+      }
+      Emit(std::string(choice < 60 ? "query_ticket" : "query_transfer") + " -s " + StationName(from) + " -t " +
+           StationName(to) + " -d " + Date(Uniform(0, kSaleDays - 1)) + " -p " +
+           (Uniform(0, 1) == 0 ? "time" : "cost"));
+    } else if (choice < 80) {
+      int user = Uniform(0, options_.users_ - 1);
+      Emit("query_order -u " + (user == 0 ? std::string("root") : Username(user)));
+    } else {
+      Emit("query_train -i " + TrainID(train_dist_(engine_)) + " -d " + Date(Uniform(0, kSaleDays - 1)));
+    }
+  }
+
+  void RefundTicket() {
+    int user = Uniform(0, options_.users_ - 1);
+    int index = order_cnt_[user] == 0 ? 1 : Uniform(1, std::min(order_cnt_[user], 5));
+    Emit("refund_ticket -u " + (user == 0 ? std::string("root") : Username(user)) + " -n " + std::to_string(index));
+  }
+
+  Options options_;
+  std::mt19937_64 engine_;
+  ZipfDistribution station_dist_;
+  ZipfDistribution train_dist_;
+  vector<TrainInfo> trains_;
+  vector<int> order_cnt_;
+  int timestamp_{0};
+};
+
+static auto ParseMix(const std::string &mix, Options *options) -> bool {
+  size_t first = mix.find(',');
+  size_t second = mix.find(',', first + 1);
+  if (first == std::string::npos || second == std::string::npos) {
+    return false;
+  }
+  options->buy_percent_ = std::stoi(mix.substr(0, first));
+  options->query_percent_ = std::stoi(mix.substr(first + 1, second - first - 1));
+  options->refund_percent_ = std::stoi(mix.substr(second + 1));
+  return options->buy_percent_ + options->query_percent_ + options->refund_percent_ > 0;
+}
+
+static void PrintUsage() {
+  std::cerr << "usage: workload_generator [--seed N] [--users N] [--trains N] [--stations N] [--min-route N] "
+               "[--max-route N]\n"
+               "                          [--commands N] [--mix BUY,QUERY,REFUND] [--skew S]\n";
+}
+
+}
+
+int main(int argc, char **argv) {
+  sjtu::Options options;
+  for (int i = 1; i < argc; i += 2) {
+    std::string key = argv[i];
+    if (key == "-h" || key == "--help") {
+      sjtu::PrintUsage();
+      return 1;
+    }
+    if (i + 1 == argc) {
+      std::cerr << "missing value of " << key << '\n';
+      sjtu::PrintUsage();
+      return 1;
+    }
+    std::string value = argv[i + 1];
+    if (key == "--seed") {
+      options.seed_ = std::stoull(value);
+    } else if (key == "--users") {
+      options.users_ = std::stoi(value);
+    } else if (key == "--trains") {
+      options.trains_ = std::stoi(value);
+    } else if (key == "--stations") {
+      options.stations_ = std::stoi(value);
+    } else if (key == "--min-route") {
+      options.min_route_ = std::stoi(value);
+    } else if (key == "--max-route") {
+      options.max_route_ = std::min(std::stoi(value), 24);
+    } else if (key == "--commands") {
+      options.commands_ = std::stoi(value);
+    } else if (key == "--skew") {
+      options.skew_ = std::stod(value);
+    } else if (key != "--mix" || !sjtu::ParseMix(value, &options)) {
+      std::cerr << "unknown option " << key << ' ' << value << '\n';
+      sjtu::PrintUsage();
+      return 1;
+    }
+  }
+  if (options.users_ < 1 || options.trains_ < 1 || options.stations_ < 2 || options.min_route_ < 2) {
+    std::cerr << "at least 1 user, 1 train, 2 stations and routes of 2 stations are needed\n";
+    return 1;
+  }
+  std::ios::sync_with_stdio(false);
+  sjtu::WorkloadGenerator(options).Run();
+  return 0;
+}